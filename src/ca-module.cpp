@@ -27,6 +27,7 @@
 #include "detail/info-encoder.hpp"
 #include "detail/request-encoder.hpp"
 #include "detail/probe-encoder.hpp"
+#include "detail/renew-encoder.hpp"
 
 #include <ndn-cxx/metadata-object.hpp>
 #include <ndn-cxx/security/signing-helpers.hpp>
@@ -36,27 +37,76 @@
 #include <ndn-cxx/util/random.hpp>
 #include <ndn-cxx/util/string-helper.hpp>
 
+#include <algorithm>
+
 namespace ndncert::ca {
 
 const time::seconds DEFAULT_DATA_FRESHNESS_PERIOD = 1_s;
 const time::seconds REQUEST_VALIDITY_PERIOD_NOT_BEFORE_GRACE_PERIOD = 120_s;
+const time::milliseconds MIN_RETRY_AFTER = 1_s;
+const time::milliseconds MAX_RETRY_AFTER = 60_s;
+const time::milliseconds CHALLENGE_RETRY_AFTER = 5_s;
+const size_t MAX_CACHED_ERROR_CONTENTS = 256;
+const size_t MAX_CACHED_PROBE_RESPONSES = 1024;
+const size_t MAX_CACHED_REPLAY_RESPONSES = 1024;
+const time::milliseconds REPLAY_CACHE_LIFETIME = 8_s;
 
 NDN_LOG_INIT(ndncert.ca);
 
+static std::map<std::string, std::unique_ptr<ChallengeModule>>
+createChallengeModules(const CaConfig& config, CaStorage& storage)
+{
+  std::map<std::string, std::unique_ptr<ChallengeModule>> modules;
+  for (const auto& challengeType : config.caProfile.supportedChallenges) {
+    auto challenge = ChallengeModule::createChallengeModule(challengeType);
+    if (challenge == nullptr) {
+      NDN_THROW(std::runtime_error("Challenge " + challengeType + " is not supported."));
+    }
+    auto it = config.challengeConfigs.find(challengeType);
+    if (it != config.challengeConfigs.end()) {
+      challenge->loadConfig(it->second);
+    }
+    challenge->setCaStorage(storage);
+    modules.emplace(challengeType, std::move(challenge));
+  }
+  return modules;
+}
+
+static KeyedHmacSha256
+makeRequestIdHmac()
+{
+  uint8_t key[32];
+  ndn::random::generateSecureBytes(key);
+  return KeyedHmacSha256(key, sizeof(key));
+}
+
 CaModule::CaModule(ndn::Face& face, ndn::KeyChain& keyChain,
                    const std::string& configPath, const std::string& storageType)
   : m_face(face)
+  , m_configPath(configPath)
   , m_keyChain(keyChain)
+  , m_requestIdHmac(makeRequestIdHmac())
+  , m_scheduler(face.getIoContext())
+  , m_probeCache(face.getIoContext(), MAX_CACHED_PROBE_RESPONSES)
+  , m_replayCache(face.getIoContext(), MAX_CACHED_REPLAY_RESPONSES)
+  , m_earlyEcdh(KeyAgreement::X25519)
 {
   // load the config and create storage
   m_config.load(configPath);
   m_storage = CaStorage::createCaStorage(storageType, m_config.caProfile.caPrefix, "");
-
-  ndn::random::generateSecureBytes(m_requestIdGenKey);
+  m_challengeModules = createChallengeModules(m_config, *m_storage);
+  for (const auto& request : m_storage->listAllRequests()) {
+    m_requestFilter.insert(request.requestId);
+  }
+  m_scheduler.setOptions(m_config.schedulerOptions);
+  m_scheduler.setShedCallback([this] (const auto& i, auto requestClass) { onRequestShed(i, requestClass); });
 
   if (m_config.nameAssignmentFuncs.empty()) {
     m_config.nameAssignmentFuncs.push_back(NameAssignmentFunc::createNameAssignmentFunc("random"));
   }
+  if (m_config.resumptionTicketLifetime > 0_s) {
+    m_ticketKeys = std::make_unique<ResumptionTicketKeys>(m_config.resumptionTicketLifetime);
+  }
 
   registerPrefix();
 }
@@ -83,27 +133,58 @@ CaModule::registerPrefix()
       // register INFO RDR metadata prefix
       const auto& metaDataComp = ndn::MetadataObject::getKeywordComponent();
       auto filterId = m_face.setInterestFilter(Name(name).append("INFO").append(metaDataComp),
-                                               [this] (auto&&, const auto& i) { onCaProfileDiscovery(i); });
+        [this] (auto&&, const auto& i) {
+          m_scheduler.enqueue(RequestClass::INFO, i,
+                              [this] (const Interest& interest) { onCaProfileDiscovery(interest); });
+        });
       m_interestFilterHandles.push_back(filterId);
 
       // register PROBE prefix
       filterId = m_face.setInterestFilter(Name(name).append("PROBE"),
-                                          [this] (auto&&, const auto& i) { onProbe(i); });
+        [this] (auto&&, const auto& i) {
+          m_scheduler.enqueue(RequestClass::PROBE, i,
+                              [this] (const Interest& interest) { onProbe(interest); });
+        });
       m_interestFilterHandles.push_back(filterId);
 
       // register NEW prefix
       filterId = m_face.setInterestFilter(Name(name).append("NEW"),
-                                          [this] (auto&&, const auto& i) { onNewRenewRevoke(i, RequestType::NEW); });
+        [this] (auto&&, const auto& i) {
+          if (!replayResponse(i)) {
+            m_scheduler.enqueue(RequestClass::NEW, i,
+                                [this] (const Interest& interest) { onNewRenewRevoke(interest, RequestType::NEW); });
+          }
+        });
       m_interestFilterHandles.push_back(filterId);
 
       // register SELECT prefix
       filterId = m_face.setInterestFilter(Name(name).append("CHALLENGE"),
-                                          [this] (auto&&, const auto& i) { onChallenge(i); });
+        [this] (auto&&, const auto& i) {
+          if (!replayResponse(i)) {
+            m_scheduler.enqueue(RequestClass::CHALLENGE, i,
+                                [this] (const Interest& interest) { onChallenge(interest); });
+          }
+        });
+      m_interestFilterHandles.push_back(filterId);
+
+      // register RENEW prefix
+      filterId = m_face.setInterestFilter(Name(name).append("RENEW"),
+        [this] (auto&&, const auto& i) {
+          if (!replayResponse(i)) {
+            m_scheduler.enqueue(RequestClass::NEW, i,
+                                [this] (const Interest& interest) { onRenew(interest); });
+          }
+        });
       m_interestFilterHandles.push_back(filterId);
 
       // register REVOKE prefix
       filterId = m_face.setInterestFilter(Name(name).append("REVOKE"),
-                                          [this] (auto&&, const auto& i) { onNewRenewRevoke(i, RequestType::REVOKE); });
+        [this] (auto&&, const auto& i) {
+          if (!replayResponse(i)) {
+            m_scheduler.enqueue(RequestClass::NEW, i,
+                                [this] (const Interest& interest) { onNewRenewRevoke(interest, RequestType::REVOKE); });
+          }
+        });
       m_interestFilterHandles.push_back(filterId);
 
       NDN_LOG_TRACE("Prefix " << name << " got registered");
@@ -112,6 +193,38 @@ CaModule::registerPrefix()
   m_registeredPrefixHandles.push_back(prefixId);
 }
 
+void
+CaModule::reload()
+{
+  CaConfig config;
+  config.load(m_configPath);
+  if (config.caProfile.caPrefix != m_config.caProfile.caPrefix) {
+    NDN_THROW(std::runtime_error("The CA prefix cannot be changed by reloading the configuration"));
+  }
+  if (config.nameAssignmentFuncs.empty()) {
+    config.nameAssignmentFuncs.push_back(NameAssignmentFunc::createNameAssignmentFunc("random"));
+  }
+  auto challengeModules = createChallengeModules(config, *m_storage);
+  m_scheduler.setOptions(config.schedulerOptions);
+  // the ticket keys are kept as long as the lifetime is unchanged, so that issued tickets stay valid
+  if (config.resumptionTicketLifetime != m_config.resumptionTicketLifetime) {
+    m_ticketKeys.reset();
+    if (config.resumptionTicketLifetime > 0_s) {
+      m_ticketKeys = std::make_unique<ResumptionTicketKeys>(config.resumptionTicketLifetime);
+    }
+  }
+  m_config = std::move(config);
+  // destroying the old modules abandons their pending requests, which may be retried
+  m_challengeModules = std::move(challengeModules);
+  m_challengesInProgress.clear();
+
+  m_profileSegments.clear();
+  m_metadataData.reset();
+  m_errorContents.clear();
+  m_probeCache.erase(Name(m_config.caProfile.caPrefix).append("CA").append("PROBE"));
+  NDN_LOG_INFO("Configuration reloaded from " << m_configPath);
+}
+
 void
 CaModule::setStatusUpdateCallback(const StatusUpdateCallback& onUpdateCallback)
 {
@@ -121,34 +234,75 @@ CaModule::setStatusUpdateCallback(const StatusUpdateCallback& onUpdateCallback)
 Data
 CaModule::getCaProfileData()
 {
-  if (m_profileData == nullptr) {
+  return getCaProfileSegments().front();
+}
+
+const std::vector<Data>&
+CaModule::getCaProfileSegments()
+{
+  if (m_profileSegments.empty()) {
     auto key = m_keyChain.getPib().getIdentity(m_config.caProfile.caPrefix).getDefaultKey();
-    Block contentTLV = infotlv::encodeDataContent(m_config.caProfile, key.getDefaultCertificate());
-
-    Name infoPacketName(m_config.caProfile.caPrefix);
-    auto segmentComp = ndn::name::Component::fromSegment(0);
-    infoPacketName.append("CA").append("INFO").appendVersion().append(segmentComp);
-    m_profileData = std::make_unique<Data>(infoPacketName);
-    m_profileData->setFinalBlock(segmentComp);
-    m_profileData->setContent(contentTLV);
-    m_profileData->setFreshnessPeriod(DEFAULT_DATA_FRESHNESS_PERIOD);
-    m_keyChain.sign(*m_profileData, signingByIdentity(m_config.caProfile.caPrefix));
-  }
-  return *m_profileData;
+    auto profile = m_config.caProfile;
+    if (m_config.earlyChallenge) {
+      profile.ecdhPub = m_earlyEcdh.getSelfPubKey();
+    }
+    profile.acceptsCompactCertRequest = true;
+    profile.keyAgreements = {KeyAgreement::X25519, KeyAgreement::P256};
+    profile.aeadAlgorithms = {AeadAlgorithm::AES_128_GCM, AeadAlgorithm::CHACHA20_POLY1305};
+    // session-hmac falls back to a DigestSha256 outside a request session
+    profile.signsErrorsWithDigest = m_config.errorSigning != ErrorSigning::CA_KEY;
+    Block contentTLV = infotlv::encodeDataContent(profile, key.getDefaultCertificate());
+
+    Name versionedName(m_config.caProfile.caPrefix);
+    versionedName.append("CA").append("INFO").appendVersion();
+
+    // a profile that fits in one segment is published as is, a larger one is split by bytes
+    std::vector<ndn::span<const uint8_t>> chunks;
+    auto segmentSize = m_config.profileSegmentSize;
+    if (segmentSize > 0 && contentTLV.value_size() > segmentSize) {
+      auto value = contentTLV.value_bytes();
+      for (size_t offset = 0; offset < value.size(); offset += segmentSize) {
+        chunks.push_back(value.subspan(offset, std::min(segmentSize, value.size() - offset)));
+      }
+    }
+
+    size_t nSegments = std::max<size_t>(chunks.size(), 1);
+    auto finalBlock = ndn::name::Component::fromSegment(nSegments - 1);
+    for (size_t i = 0; i < nSegments; ++i) {
+      Data segment(Name(versionedName).appendSegment(i));
+      segment.setFinalBlock(finalBlock);
+      if (chunks.empty()) {
+        segment.setContent(contentTLV);
+      }
+      else {
+        segment.setContent(chunks[i]);
+      }
+      segment.setFreshnessPeriod(DEFAULT_DATA_FRESHNESS_PERIOD);
+      m_keyChain.sign(segment, signingByIdentity(m_config.caProfile.caPrefix));
+      m_profileSegments.push_back(std::move(segment));
+    }
+  }
+  return m_profileSegments;
 }
 
 void
 CaModule::onCaProfileDiscovery(const Interest&)
 {
   NDN_LOG_TRACE("Received CA Profile MetaData discovery Interest");
-  if (m_profileData == nullptr) {
-    m_profileData = std::make_unique<Data>(getCaProfileData());
-  }
-  ndn::MetadataObject metadata;
-  metadata.setVersionedName(m_profileData->getName().getPrefix(-1));
-  Name discoveryInterestName(m_profileData->getName().getPrefix(-2));
-  discoveryInterestName.append(ndn::MetadataObject::getKeywordComponent());
-  m_face.put(metadata.makeData(discoveryInterestName, m_keyChain, signingByIdentity(m_config.caProfile.caPrefix)));
+  // the metadata only changes with the profile, so it is signed once per freshness period
+  auto now = time::steady_clock::now();
+  if (m_metadataData == nullptr || now >= m_metadataExpiry) {
+    const auto& profileName = getCaProfileData().getName();
+    ndn::MetadataObject metadata;
+    metadata.setVersionedName(profileName.getPrefix(-1));
+    Name discoveryInterestName(profileName.getPrefix(-2));
+    discoveryInterestName.append(ndn::MetadataObject::getKeywordComponent());
+    m_metadataData = std::make_unique<Data>(metadata.makeData(discoveryInterestName, m_keyChain,
+                                                              signingByIdentity(m_config.caProfile.caPrefix),
+                                                              DEFAULT_DATA_FRESHNESS_PERIOD));
+    m_metadataExpiry = now + DEFAULT_DATA_FRESHNESS_PERIOD;
+  }
+  m_face.put(*m_metadataData);
 }
 
 void
@@ -157,6 +311,18 @@ CaModule::onProbe(const Interest& request)
   // PROBE Naming Convention: /<CA-Prefix>/CA/PROBE/[ParametersSha256DigestComponent]
   NDN_LOG_TRACE("Received PROBE request");
 
+  // the response only depends on the parameters, whose digest is in the name
+  auto cached = m_probeCache.find(request);
+  if (cached != nullptr) {
+    ++m_probeCacheStats.nHits;
+    m_probeCacheStats.savedSigningTime += m_probeSigningTime;
+    m_face.put(*cached);
+    NDN_LOG_TRACE("Handle PROBE: send out the cached PROBE response, hit ratio " <<
+                  m_probeCacheStats.nHits << "/" << m_probeCacheStats.nHits + m_probeCacheStats.nMisses);
+    return;
+  }
+  ++m_probeCacheStats.nMisses;
+
   // process PROBE requests: collect probe parameters
   std::vector<ndn::Name> redirectionNames;
   std::vector<ndn::PartialName> availableComponents;
@@ -199,7 +365,11 @@ CaModule::onProbe(const Interest& request)
   result.setContent(probetlv::encodeDataContent(availableNames, m_config.caProfile.maxSuffixLength,
                                                 redirectionNames));
   result.setFreshnessPeriod(DEFAULT_DATA_FRESHNESS_PERIOD);
+  auto start = time::steady_clock::now();
   m_keyChain.sign(result, signingByIdentity(m_config.caProfile.caPrefix));
+  time::nanoseconds signingTime = time::steady_clock::now() - start;
+  m_probeSigningTime = m_probeSigningTime == 0_ns ? signingTime : (m_probeSigningTime * 7 + signingTime) / 8;
+  m_probeCache.insert(result, DEFAULT_DATA_FRESHNESS_PERIOD);
   m_face.put(result);
   NDN_LOG_TRACE("Handle PROBE: send out the PROBE response");
 }
@@ -207,6 +377,11 @@ CaModule::onProbe(const Interest& request)
 void
 CaModule::onNewRenewRevoke(const Interest& request, RequestType requestType)
 {
+  // a retransmission may have been queued before the original request was answered
+  if (replayResponse(request)) {
+    return;
+  }
+
   // verify ca cert validity
   auto caCert = m_keyChain.getPib()
                           .getIdentity(m_config.caProfile.caPrefix)
@@ -214,8 +389,8 @@ CaModule::onNewRenewRevoke(const Interest& request, RequestType requestType)
                           .getDefaultCertificate();
   if (!caCert.isValid()) {
     NDN_LOG_ERROR("Server certificate invalid/expired");
-    m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::BAD_VALIDITY_PERIOD,
-                                       "Server certificate invalid/expired"));
+    putResponse(generateErrorDataPacket(request.getName(), ErrorCode::BAD_VALIDITY_PERIOD,
+                                        "Server certificate invalid/expired"));
     return;
   }
 
@@ -223,43 +398,98 @@ CaModule::onNewRenewRevoke(const Interest& request, RequestType requestType)
   // REVOKE Naming Convention: /<CA-prefix>/CA/REVOKE/[SignedInterestParameters_Digest]
   // get ECDH pub key and cert request
   const auto& parameterTLV = request.getApplicationParameters();
-  std::vector <uint8_t> ecdhPub;
-  std::shared_ptr<Certificate> clientCert;
+  // both refer to the wire encoding of the Interest
+  ndn::span<const uint8_t> ecdhPub;
+  std::optional<Certificate> clientCert;
   try {
     requesttlv::decodeApplicationParameters(parameterTLV, requestType, ecdhPub, clientCert);
   }
   catch (const std::exception& e) {
     if (!parameterTLV.hasValue()) {
       NDN_LOG_ERROR("Empty TLV obtained from the Interest parameter.");
-      m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
-                                         "Empty TLV obtained from the Interest parameter."));
+      putResponse(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
+                                          "Empty TLV obtained from the Interest parameter."));
       return;
     }
 
     NDN_LOG_ERROR("Unrecognized self-signed certificate: " << e.what());
-    m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
-                                       "Unrecognized self-signed certificate."));
+    putResponse(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
+                                        "Unrecognized self-signed certificate."));
     return;
   }
 
   if (ecdhPub.empty()) {
     NDN_LOG_ERROR("Empty ECDH PUB obtained from the Interest parameter.");
-    m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
-                                       "Empty ECDH PUB obtained from the Interest parameter."));
+    putResponse(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
+                                        "Empty ECDH PUB obtained from the Interest parameter."));
     return;
   }
 
-  // get server's ECDH pub key
-  ECDHState ecdh;
-  std::vector <uint8_t> sharedSecret;
-  try {
-    sharedSecret = ecdh.deriveSecret(ecdhPub);
+  // the AEAD algorithm selected by the requester protects the rest of the session
+  auto aead = AeadAlgorithm::AES_128_GCM;
+  auto aeadElement = parameterTLV.find(tlv::Aead);
+  if (aeadElement != parameterTLV.elements_end()) {
+    try {
+      aead = static_cast<AeadAlgorithm>(readNonNegativeInteger(*aeadElement));
+    }
+    catch (const ndn::tlv::Error& e) {
+      NDN_LOG_ERROR("Malformed AEAD algorithm: " << e.what());
+      putResponse(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
+                                          "Malformed AEAD algorithm."));
+      return;
+    }
+    if (aead != AeadAlgorithm::AES_128_GCM && aead != AeadAlgorithm::CHACHA20_POLY1305) {
+      NDN_LOG_ERROR("Unsupported AEAD algorithm " << static_cast<uint64_t>(aead));
+      putResponse(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
+                                          "Unsupported AEAD algorithm."));
+      return;
+    }
   }
-  catch (const std::exception& e) {
-    NDN_LOG_ERROR("Cannot derive a shared secret using the provided ECDH key: " << e.what());
-    m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
-                                       "Cannot derive a shared secret using the provided ECDH key."));
-    return;
+
+  // a valid resumption ticket replaces the ECDH exchange
+  std::vector<uint8_t> sharedSecret;
+  std::vector<uint8_t> selfEcdhPub;
+  auto ticket = parameterTLV.find(tlv::ResumptionTicket);
+  std::optional<std::array<uint8_t, 32>> resumptionSecret;
+  if (m_ticketKeys && ticket != parameterTLV.elements_end()) {
+    resumptionSecret = m_ticketKeys->open(*ticket, clientCert->getKeyName());
+  }
+  if (resumptionSecret) {
+    NDN_LOG_TRACE("Resuming a session for " << clientCert->getKeyName());
+    sharedSecret.assign(resumptionSecret->begin(), resumptionSecret->end());
+  }
+  else {
+    // get server's ECDH pub key, using the algorithm selected by the requester
+    auto keyAgreement = KeyAgreement::P256;
+    auto keyAgreementElement = parameterTLV.find(tlv::KeyAgreement);
+    if (keyAgreementElement != parameterTLV.elements_end()) {
+      try {
+        keyAgreement = static_cast<KeyAgreement>(readNonNegativeInteger(*keyAgreementElement));
+      }
+      catch (const ndn::tlv::Error& e) {
+        NDN_LOG_ERROR("Malformed key agreement algorithm: " << e.what());
+        putResponse(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
+                                            "Malformed key agreement algorithm."));
+        return;
+      }
+      if (keyAgreement != KeyAgreement::P256 && keyAgreement != KeyAgreement::X25519) {
+        NDN_LOG_ERROR("Unsupported key agreement algorithm " << static_cast<uint64_t>(keyAgreement));
+        putResponse(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
+                                            "Unsupported key agreement algorithm."));
+        return;
+      }
+    }
+    ECDHState ecdh(keyAgreement);
+    try {
+      sharedSecret = ecdh.deriveSecret(ecdhPub);
+    }
+    catch (const std::exception& e) {
+      NDN_LOG_ERROR("Cannot derive a shared secret using the provided ECDH key: " << e.what());
+      putResponse(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
+                                          "Cannot derive a shared secret using the provided ECDH key."));
+      return;
+    }
+    selfEcdhPub = ecdh.getSelfPubKey();
   }
 
   // verify identity name
@@ -267,15 +497,15 @@ CaModule::onNewRenewRevoke(const Interest& request, RequestType requestType)
       || !Certificate::isValidName(clientCert->getName())
       || clientCert->getIdentity().size() <= m_config.caProfile.caPrefix.size()) {
     NDN_LOG_ERROR("An invalid certificate name is being requested " << clientCert->getName());
-    m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::NAME_NOT_ALLOWED,
-                                       "An invalid certificate name is being requested."));
+    putResponse(generateErrorDataPacket(request.getName(), ErrorCode::NAME_NOT_ALLOWED,
+                                        "An invalid certificate name is being requested."));
     return;
   }
   if (m_config.caProfile.maxSuffixLength) {
     if (clientCert->getIdentity().size() > m_config.caProfile.caPrefix.size() + *m_config.caProfile.maxSuffixLength) {
       NDN_LOG_ERROR("An invalid certificate name is being requested " << clientCert->getName());
-      m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::NAME_NOT_ALLOWED,
-                                         "An invalid certificate name is being requested."));
+      putResponse(generateErrorDataPacket(request.getName(), ErrorCode::NAME_NOT_ALLOWED,
+                                          "An invalid certificate name is being requested."));
       return;
     }
   }
@@ -288,31 +518,36 @@ CaModule::onNewRenewRevoke(const Interest& request, RequestType requestType)
         notAfter > currentTime + m_config.caProfile.maxValidityPeriod ||
         notAfter <= notBefore) {
       NDN_LOG_ERROR("An invalid validity period is being requested.");
-      m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::BAD_VALIDITY_PERIOD,
-                                         "An invalid validity period is being requested."));
+      putResponse(generateErrorDataPacket(request.getName(), ErrorCode::BAD_VALIDITY_PERIOD,
+                                          "An invalid validity period is being requested."));
       return;
     }
 
-    // verify signature
-    if (!ndn::security::verifySignature(*clientCert, *clientCert)) {
+    // verify signature; a compact request has no self-signature, the Interest signature suffices
+    bool isCompact = parameterTLV.find(tlv::CompactCertRequest) != parameterTLV.elements_end();
+    if (!isCompact && !ndn::security::verifySignature(*clientCert, *clientCert)) {
       NDN_LOG_ERROR("Invalid signature in the self-signed certificate.");
-      m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::BAD_SIGNATURE,
-                                         "Invalid signature in the self-signed certificate."));
+      putResponse(generateErrorDataPacket(request.getName(), ErrorCode::BAD_SIGNATURE,
+                                          "Invalid signature in the self-signed certificate."));
       return;
     }
     if (!ndn::security::verifySignature(request, *clientCert)) {
       NDN_LOG_ERROR("Invalid signature in the Interest packet.");
-      m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::BAD_SIGNATURE,
-                                         "Invalid signature in the Interest packet."));
+      putResponse(generateErrorDataPacket(request.getName(), ErrorCode::BAD_SIGNATURE,
+                                          "Invalid signature in the Interest packet."));
       return;
     }
+    if (isCompact) {
+      // the rebuilt request is stored, which requires a signature; a digest keeps the validity period
+      m_keyChain.sign(*clientCert, ndn::security::signingWithSha256().setSignatureInfo(clientCert->getSignatureInfo()));
+    }
   }
   else if (requestType == RequestType::REVOKE) {
     //verify cert is from this CA
     if (!ndn::security::verifySignature(*clientCert, caCert)) {
       NDN_LOG_ERROR("Invalid signature in the certificate to revoke.");
-      m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::BAD_SIGNATURE,
-                                         "Invalid signature in the certificate to revoke."));
+      putResponse(generateErrorDataPacket(request.getName(), ErrorCode::BAD_SIGNATURE,
+                                          "Invalid signature in the certificate to revoke."));
       return;
     }
   }
@@ -321,12 +556,12 @@ CaModule::onNewRenewRevoke(const Interest& request, RequestType requestType)
   uint8_t requestIdData[32];
   Block certNameTlv = clientCert->getName().wireEncode();
   try {
-    hmacSha256(certNameTlv.data(), certNameTlv.size(), m_requestIdGenKey, 32, requestIdData);
+    m_requestIdHmac.compute(certNameTlv.data(), certNameTlv.size(), requestIdData);
   }
   catch (const std::runtime_error& e) {
     NDN_LOG_ERROR("Error computing the request ID: " << e.what());
-    m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
-                                       "Error computing the request ID."));
+    putResponse(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
+                                        "Error computing the request ID."));
     return;
   }
   RequestId id;
@@ -345,24 +580,206 @@ CaModule::onNewRenewRevoke(const Interest& request, RequestType requestType)
   hkdf(sharedSecret.data(), sharedSecret.size(), salt.data(), salt.size(),
        aesKey.data(), aesKey.size(), id.data(), id.size());
   requestState.encryptionKey = aesKey;
+  requestState.aead = aead;
+  requestState.aeadKey = deriveAeadKey(aead, aesKey.data(), id.data(), id.size());
   try {
     m_storage->addRequest(requestState);
+    m_requestFilter.insert(requestState.requestId);
   }
   catch (const std::runtime_error&) {
     NDN_LOG_ERROR("Duplicate Request ID: The same request has been seen before.");
-    m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
-                                       "Duplicate Request ID: The same request has been seen before."));
+    putResponse(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
+                                        "Duplicate Request ID: The same request has been seen before."));
+    return;
+  }
+
+  auto content = requesttlv::encodeDataContent(selfEcdhPub, salt, requestState.requestId,
+                                               m_config.caProfile.supportedChallenges);
+
+  // a NEW request may carry the first challenge step, in which case both are answered together
+  std::optional<Block> earlyParams;
+  auto earlyChallenge = parameterTLV.find(tlv::EarlyChallenge);
+  if (m_config.earlyChallenge && requestType == RequestType::NEW &&
+      earlyChallenge != parameterTLV.elements_end()) {
+    earlyParams = decryptEarlyChallenge(*earlyChallenge, ecdhPub, *clientCert, aead);
+  }
+  if (earlyParams) {
+    auto state = std::make_shared<RequestState>(std::move(requestState));
+    auto onComplete = [this, request, state, content] (ErrorCode errorCode, const std::string& errorInfo) {
+      m_challengesInProgress.erase(state->requestId);
+      onEarlyChallengeCompleted(request, *state, content, errorCode, errorInfo);
+    };
+    m_challengesInProgress.insert(state->requestId);
+    try {
+      auto challengeType = readString(earlyParams->get(tlv::SelectedChallenge));
+      auto challengeIt = m_challengeModules.find(challengeType);
+      if (challengeIt == m_challengeModules.end()) {
+        NDN_LOG_TRACE("Unrecognized challenge type: " << challengeType);
+        onComplete(ErrorCode::INVALID_PARAMETER, "Unrecognized challenge type.");
+        return;
+      }
+      NDN_LOG_TRACE("CHALLENGE module to be load with the NEW request: " << challengeType);
+      challengeIt->second->handleChallengeRequestAsync(*earlyParams, state, m_face.getIoContext(), onComplete);
+    }
+    catch (const std::exception& e) {
+      NDN_LOG_ERROR("Challenge in the NEW request failed: " << e.what());
+      onComplete(ErrorCode::INVALID_PARAMETER, "Cannot handle the challenge request.");
+    }
     return;
   }
 
   Data result;
   result.setName(request.getName());
   result.setFreshnessPeriod(DEFAULT_DATA_FRESHNESS_PERIOD);
-  result.setContent(requesttlv::encodeDataContent(ecdh.getSelfPubKey(),
-                                                  salt, requestState.requestId,
-                                                  m_config.caProfile.supportedChallenges));
+  result.setContent(content);
   m_keyChain.sign(result, signingByIdentity(m_config.caProfile.caPrefix));
-  m_face.put(result);
+  putResponse(result);
+  if (m_statusUpdateCallback) {
+    m_statusUpdateCallback(requestState);
+  }
+}
+
+std::optional<Block>
+CaModule::decryptEarlyChallenge(const Block& earlyChallenge, ndn::span<const uint8_t> ecdhPub,
+                                const Certificate& certRequest, AeadAlgorithm aead)
+{
+  try {
+    auto sharedSecret = m_earlyEcdh.deriveSecret(ecdhPub);
+    auto aesKey = deriveEarlyChallengeKey(sharedSecret.data(), sharedSecret.size(),
+                                          ecdhPub.data(), ecdhPub.size());
+    const auto& certName = certRequest.getName().wireEncode();
+    auto aeadKey = deriveAeadKey(aead, aesKey.data(), certName.data(), certName.size());
+    std::vector<uint8_t> decryptionIv;
+    auto params = decryptBlockWithAead(aead, earlyChallenge, tlv::EncryptedPayload, aeadKey.data(),
+                                       certName.data(), certName.size(), decryptionIv, {});
+    params.parse();
+    return params;
+  }
+  catch (const std::exception& e) {
+    // the requester falls back to a separate CHALLENGE request
+    NDN_LOG_DEBUG("Ignoring the challenge step in the NEW request: " << e.what());
+    return std::nullopt;
+  }
+}
+
+void
+CaModule::onEarlyChallengeCompleted(const Interest& request, RequestState& requestState, Block content,
+                                    ErrorCode errorCode, const std::string& errorInfo)
+{
+  if (errorCode != ErrorCode::NO_ERROR) {
+    // the requester cannot authenticate a session signature before receiving the NEW response
+    deleteRequest(requestState.requestId);
+    if (errorCode == ErrorCode::SERVICE_UNAVAILABLE) {
+      // a retry of the NEW request creates the request again
+      m_face.put(generateErrorDataPacket(request.getName(), errorCode, errorInfo, CHALLENGE_RETRY_AFTER));
+      return;
+    }
+    putResponse(generateErrorDataPacket(request.getName(), errorCode, errorInfo));
+    return;
+  }
+
+  auto challengeResult = finishChallengeStep(requestState);
+  content.push_back(ndn::makeBinaryBlock(tlv::EarlyChallenge, challengeResult.value_bytes()));
+  content.encode();
+
+  Data result;
+  result.setName(request.getName());
+  result.setFreshnessPeriod(DEFAULT_DATA_FRESHNESS_PERIOD);
+  result.setContent(content);
+  m_keyChain.sign(result, signingByIdentity(m_config.caProfile.caPrefix));
+  putResponse(result);
+  if (m_statusUpdateCallback) {
+    m_statusUpdateCallback(requestState);
+  }
+}
+
+void
+CaModule::onRenew(const Interest& request)
+{
+  // a retransmission may have been queued before the original request was answered
+  if (replayResponse(request)) {
+    return;
+  }
+
+  auto caCert = m_keyChain.getPib()
+                          .getIdentity(m_config.caProfile.caPrefix)
+                          .getDefaultKey()
+                          .getDefaultCertificate();
+  if (!caCert.isValid()) {
+    NDN_LOG_ERROR("Server certificate invalid/expired");
+    putResponse(generateErrorDataPacket(request.getName(), ErrorCode::BAD_VALIDITY_PERIOD,
+                                        "Server certificate invalid/expired"));
+    return;
+  }
+
+  // RENEW Naming Convention: /<CA-prefix>/CA/RENEW/[SignedInterestParameters_Digest]
+  std::optional<Certificate> certRequest;
+  std::optional<Certificate> certToRenew;
+  try {
+    renewtlv::decodeApplicationParameters(request.getApplicationParameters(), certRequest, certToRenew);
+  }
+  catch (const std::exception& e) {
+    NDN_LOG_ERROR("Cannot decode the RENEW parameters: " << e.what());
+    putResponse(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
+                                        "Cannot decode the RENEW parameters."));
+    return;
+  }
+
+  // the certificate to renew must be a valid certificate from this CA, held by the requester
+  if (!m_config.caProfile.caPrefix.isPrefixOf(certToRenew->getIdentity()) || !certToRenew->isValid() ||
+      !ndn::security::verifySignature(*certToRenew, caCert)) {
+    NDN_LOG_ERROR("Invalid certificate to renew " << certToRenew->getName());
+    putResponse(generateErrorDataPacket(request.getName(), ErrorCode::BAD_SIGNATURE,
+                                        "The certificate to renew is not a valid certificate from this CA."));
+    return;
+  }
+  if (!ndn::security::verifySignature(request, *certToRenew)) {
+    NDN_LOG_ERROR("Invalid signature in the Interest packet.");
+    putResponse(generateErrorDataPacket(request.getName(), ErrorCode::BAD_SIGNATURE,
+                                        "Invalid signature in the Interest packet."));
+    return;
+  }
+
+  // the renewed certificate keeps the identity, but may use a new key
+  if (certRequest->getIdentity() != certToRenew->getIdentity() ||
+      !Certificate::isValidName(certRequest->getName())) {
+    NDN_LOG_ERROR("An invalid certificate name is being requested " << certRequest->getName());
+    putResponse(generateErrorDataPacket(request.getName(), ErrorCode::NAME_NOT_ALLOWED,
+                                        "An invalid certificate name is being requested."));
+    return;
+  }
+  auto [notBefore, notAfter] = certRequest->getValidityPeriod().getPeriod();
+  auto currentTime = time::system_clock::now();
+  if (notBefore < currentTime - REQUEST_VALIDITY_PERIOD_NOT_BEFORE_GRACE_PERIOD ||
+      notAfter > currentTime + m_config.caProfile.maxValidityPeriod ||
+      notAfter <= notBefore) {
+    NDN_LOG_ERROR("An invalid validity period is being requested.");
+    putResponse(generateErrorDataPacket(request.getName(), ErrorCode::BAD_VALIDITY_PERIOD,
+                                        "An invalid validity period is being requested."));
+    return;
+  }
+  if (!ndn::security::verifySignature(*certRequest, *certRequest)) {
+    NDN_LOG_ERROR("Invalid signature in the self-signed certificate.");
+    putResponse(generateErrorDataPacket(request.getName(), ErrorCode::BAD_SIGNATURE,
+                                        "Invalid signature in the self-signed certificate."));
+    return;
+  }
+
+  RequestState requestState;
+  requestState.caPrefix = m_config.caProfile.caPrefix;
+  requestState.requestType = RequestType::RENEW;
+  requestState.cert = *certRequest;
+  auto issuedCert = issueCertificate(requestState);
+  requestState.cert = issuedCert;
+  requestState.status = Status::SUCCESS;
+  NDN_LOG_TRACE("Certificate " << certToRenew->getName() << " has been renewed: " << issuedCert.getName());
+
+  Data result;
+  result.setName(request.getName());
+  result.setFreshnessPeriod(DEFAULT_DATA_FRESHNESS_PERIOD);
+  result.setContent(renewtlv::encodeDataContent(issuedCert));
+  m_keyChain.sign(result, signingByIdentity(m_config.caProfile.caPrefix));
+  putResponse(result);
   if (m_statusUpdateCallback) {
     m_statusUpdateCallback(requestState);
   }
@@ -371,103 +788,168 @@ CaModule::onNewRenewRevoke(const Interest& request, RequestType requestType)
 void
 CaModule::onChallenge(const Interest& request)
 {
+  // a retransmission may have been queued before the original request was answered
+  if (replayResponse(request)) {
+    return;
+  }
+
   // get certificate request state
   auto requestState = getCertificateRequest(request);
   if (requestState == nullptr) {
     NDN_LOG_ERROR("No certificate request state can be found.");
-    m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
-                                       "No certificate request state can be found."));
+    putResponse(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
+                                        "No certificate request state can be found."));
     return;
   }
 
   // verify signature
   if (!ndn::security::verifySignature(request, requestState->cert)) {
     NDN_LOG_ERROR("Invalid Signature in the Interest packet.");
-    m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::BAD_SIGNATURE,
-                                       "Invalid Signature in the Interest packet."));
+    putResponse(generateErrorDataPacket(request.getName(), ErrorCode::BAD_SIGNATURE,
+                                        "Invalid Signature in the Interest packet."));
     return;
   }
 
   // decrypt the parameters
-  ndn::Buffer paramTLVPayload;
+  Block paramTLV;
   try {
-    paramTLVPayload = decodeBlockWithAesGcm128(request.getApplicationParameters(), requestState->encryptionKey.data(),
-                                               requestState->requestId.data(), requestState->requestId.size(),
-                                               requestState->decryptionIv, requestState->encryptionIv);
+    paramTLV = decryptBlockWithAead(requestState->aead, request.getApplicationParameters(),
+                                    tlv::EncryptedPayload, requestState->aeadKey.data(),
+                                    requestState->requestId.data(), requestState->requestId.size(),
+                                    requestState->decryptionIv, requestState->encryptionIv);
   }
   catch (const std::exception& e) {
     NDN_LOG_ERROR("Interest paramaters decryption failed: " << e.what());
-    m_storage->deleteRequest(requestState->requestId);
-    m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
-                                       "Interest paramaters decryption failed."));
+    deleteRequest(requestState->requestId);
+    putResponse(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
+                                        "Interest paramaters decryption failed.", std::nullopt,
+                                        requestState.get()));
     return;
   }
-  if (paramTLVPayload.empty()) {
+  if (paramTLV.value_size() == 0) {
     NDN_LOG_ERROR("No parameters are found after decryption.");
-    m_storage->deleteRequest(requestState->requestId);
-    m_face.put(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
-                                       "No parameters are found after decryption."));
+    deleteRequest(requestState->requestId);
+    putResponse(generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER,
+                                        "No parameters are found after decryption.", std::nullopt,
+                                        requestState.get()));
     return;
   }
 
-  auto paramTLV = ndn::makeBinaryBlock(tlv::EncryptedPayload, paramTLVPayload);
   paramTLV.parse();
 
   // load the corresponding challenge module
   std::string challengeType = readString(paramTLV.get(tlv::SelectedChallenge));
-  auto challenge = ChallengeModule::createChallengeModule(challengeType);
-  if (challenge == nullptr) {
+  auto challengeIt = m_challengeModules.find(challengeType);
+  if (challengeIt == m_challengeModules.end()) {
     NDN_LOG_TRACE("Unrecognized challenge type: " << challengeType);
-    m_storage->deleteRequest(requestState->requestId);
-    m_face.put(
-      generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER, "Unrecognized challenge type."));
+    deleteRequest(requestState->requestId);
+    putResponse(
+      generateErrorDataPacket(request.getName(), ErrorCode::INVALID_PARAMETER, "Unrecognized challenge type.",
+                              std::nullopt, requestState.get()));
     return;
   }
 
   NDN_LOG_TRACE("CHALLENGE module to be load: " << challengeType);
-  auto errorInfo = challenge->handleChallengeRequest(paramTLV, *requestState);
-  if (std::get<0>(errorInfo) != ErrorCode::NO_ERROR) {
-    m_storage->deleteRequest(requestState->requestId);
-    m_face.put(generateErrorDataPacket(request.getName(), std::get<0>(errorInfo), std::get<1>(errorInfo)));
+  // the next step of a request cannot start before the module has completed the previous one
+  if (!m_challengesInProgress.insert(requestState->requestId).second) {
+    NDN_LOG_DEBUG("Challenge of request " << ndn::toHex(requestState->requestId)
+                  << " in progress, dropping " << request.getName());
     return;
   }
+  std::shared_ptr<RequestState> state = std::move(requestState);
+  try {
+    challengeIt->second->handleChallengeRequestAsync(paramTLV, state, m_face.getIoContext(),
+      [this, request, state] (ErrorCode errorCode, const std::string& errorInfo) {
+        m_challengesInProgress.erase(state->requestId);
+        onChallengeCompleted(request, *state, errorCode, errorInfo);
+      });
+  }
+  catch (const std::exception& e) {
+    NDN_LOG_ERROR("Challenge " << challengeType << " failed: " << e.what());
+    m_challengesInProgress.erase(state->requestId);
+    onChallengeCompleted(request, *state, ErrorCode::INVALID_PARAMETER, "Cannot handle the challenge request.");
+  }
+}
 
+void
+CaModule::onChallengeCompleted(const Interest& request, RequestState& requestState,
+                               ErrorCode errorCode, const std::string& errorInfo)
+{
+  if (errorCode == ErrorCode::SERVICE_UNAVAILABLE) {
+    // neither the FAILURE status nor the advanced IVs are stored, so the retry is decrypted again
+    NDN_LOG_DEBUG("Challenge of request " << ndn::toHex(requestState.requestId)
+                  << " temporarily failed: " << errorInfo);
+    m_face.put(generateErrorDataPacket(request.getName(), errorCode, errorInfo,
+                                       CHALLENGE_RETRY_AFTER, &requestState));
+    return;
+  }
+  if (errorCode != ErrorCode::NO_ERROR) {
+    deleteRequest(requestState.requestId);
+    putResponse(generateErrorDataPacket(request.getName(), errorCode, errorInfo,
+                                        std::nullopt, &requestState));
+    return;
+  }
+
+  auto payload = finishChallengeStep(requestState);
+
+  Data result;
+  result.setName(request.getName());
+  result.setFreshnessPeriod(DEFAULT_DATA_FRESHNESS_PERIOD);
+  result.setContent(payload);
+  // the payload is already authenticated by the session key, so only the issuance needs the CA key
+  const auto& params = request.getApplicationParameters();
+  if (m_config.sessionSigning && requestState.status != Status::SUCCESS &&
+      params.find(tlv::SessionSigning) != params.elements_end()) {
+    signWithSessionKey(result, requestState);
+  }
+  else {
+    m_keyChain.sign(result, signingByIdentity(m_config.caProfile.caPrefix));
+  }
+  putResponse(result);
+  if (m_statusUpdateCallback) {
+    m_statusUpdateCallback(requestState);
+  }
+}
+
+Block
+CaModule::finishChallengeStep(RequestState& requestState)
+{
   Block payload;
-  if (requestState->status == Status::PENDING) {
+  if (requestState.status == Status::PENDING) {
     // if challenge succeeded
-    if (requestState->requestType == RequestType::NEW || requestState->requestType == RequestType::RENEW) {
-      auto issuedCert = issueCertificate(*requestState);
-      requestState->cert = issuedCert;
-      requestState->status = Status::SUCCESS;
-      m_storage->deleteRequest(requestState->requestId);
-
-      payload = challengetlv::encodeDataContent(*requestState, issuedCert.getName(),
-                                                m_config.caProfile.forwardingHint);
+    if (requestState.requestType == RequestType::NEW || requestState.requestType == RequestType::RENEW) {
+      auto issuedCert = issueCertificate(requestState);
+      requestState.cert = issuedCert;
+      requestState.status = Status::SUCCESS;
+      deleteRequest(requestState.requestId);
+
+      // a ticket lets the requester skip ECDH in its next NEW or REVOKE request
+      Block ticket;
+      if (m_ticketKeys) {
+        auto secret = deriveResumptionSecret(requestState.encryptionKey.data(), requestState.encryptionKey.size(),
+                                             requestState.requestId.data(), requestState.requestId.size());
+        ticket = m_ticketKeys->seal(issuedCert.getKeyName(), secret);
+      }
+      // the certificate is delivered inline, saving the requester a fetch
+      payload = challengetlv::encodeDataContent(requestState, issuedCert.getName(),
+                                                m_config.caProfile.forwardingHint, ticket,
+                                                makeNestedBlock(tlv::IssuedCertificate, issuedCert));
       NDN_LOG_TRACE("Challenge succeeded. Certificate has been issued: " << issuedCert.getName());
     }
-    else if (requestState->requestType == RequestType::REVOKE) {
-      requestState->status = Status::SUCCESS;
-      m_storage->deleteRequest(requestState->requestId);
+    else if (requestState.requestType == RequestType::REVOKE) {
+      requestState.status = Status::SUCCESS;
+      deleteRequest(requestState.requestId);
       // TODO: where is the code to revoke?
-      payload = challengetlv::encodeDataContent(*requestState);
+      payload = challengetlv::encodeDataContent(requestState);
       NDN_LOG_TRACE("Challenge succeeded. Certificate has been revoked");
     }
   }
   else {
-    payload = challengetlv::encodeDataContent(*requestState);
-    m_storage->updateRequest(*requestState);
+    payload = challengetlv::encodeDataContent(requestState);
+    m_storage->updateRequest(requestState);
     NDN_LOG_TRACE("No failure no success. Challenge moves on");
   }
-
-  Data result;
-  result.setName(request.getName());
-  result.setFreshnessPeriod(DEFAULT_DATA_FRESHNESS_PERIOD);
-  result.setContent(payload);
-  m_keyChain.sign(result, signingByIdentity(m_config.caProfile.caPrefix));
-  m_face.put(result);
-  if (m_statusUpdateCallback) {
-    m_statusUpdateCallback(*requestState);
-  }
+  return payload;
 }
 
 Certificate
@@ -496,22 +978,55 @@ std::unique_ptr <RequestState>
 CaModule::getCertificateRequest(const Interest& request)
 {
   RequestId requestId;
-  try {
-    auto& component = request.getName().at(m_config.caProfile.caPrefix.size() + 2);
-    std::memcpy(requestId.data(), component.value(), component.value_size());
-  }
-  catch (const std::exception& e) {
-    NDN_LOG_ERROR("Cannot read the request ID out from the request: " << e.what());
+  const auto& name = request.getName();
+  if (name.size() <= m_config.caProfile.caPrefix.size() + 2 ||
+      name[m_config.caProfile.caPrefix.size() + 2].value_size() != requestId.size()) {
+    NDN_LOG_ERROR("Cannot read the request ID out from the request: " << name);
     return nullptr;
   }
-  try {
-    NDN_LOG_TRACE("Request Id to query the database " << ndn::toHex(requestId));
-    return std::make_unique<RequestState>(m_storage->getRequest(requestId));
+  const auto& component = name[m_config.caProfile.caPrefix.size() + 2];
+  std::memcpy(requestId.data(), component.value(), component.value_size());
+
+  // unknown request IDs are mostly rejected without querying the storage
+  if (!m_requestFilter.mayContain(requestId)) {
+    NDN_LOG_ERROR("Unknown request ID " << ndn::toHex(requestId));
+    return nullptr;
   }
-  catch (const std::exception& e) {
-    NDN_LOG_ERROR("Cannot get certificate request record from the storage: " << e.what());
+  NDN_LOG_TRACE("Request Id to query the database " << ndn::toHex(requestId));
+  auto requestState = m_storage->findRequest(requestId);
+  if (!requestState) {
+    NDN_LOG_ERROR("Cannot get certificate request record from the storage: " << ndn::toHex(requestId));
     return nullptr;
   }
+  return std::make_unique<RequestState>(std::move(*requestState));
+}
+
+void
+CaModule::deleteRequest(const RequestId& requestId)
+{
+  m_storage->deleteRequest(requestId);
+  m_requestFilter.erase(requestId);
+}
+
+bool
+CaModule::replayResponse(const Interest& request)
+{
+  auto response = m_replayCache.find(request.getName());
+  if (response == nullptr) {
+    return false;
+  }
+  NDN_LOG_TRACE("Replaying the response to retransmitted request " << request.getName());
+  m_face.put(*response);
+  return true;
+}
+
+void
+CaModule::putResponse(const Data& response)
+{
+  // the name of a NEW, RENEW, REVOKE, or CHALLENGE Interest covers its signed parameters,
+  // so only an exact retransmission can be answered with this response
+  m_replayCache.insert(response, REPLAY_CACHE_LIFETIME);
+  m_face.put(response);
 }
 
 void
@@ -520,14 +1035,78 @@ CaModule::onRegisterFailed(const std::string& reason)
   NDN_LOG_ERROR("Failed to register prefix in local hub's daemon, REASON: " << reason);
 }
 
+void
+CaModule::onRequestShed(const Interest& request, RequestClass requestClass)
+{
+  if (requestClass == RequestClass::INFO) {
+    // RDR discovery has no error format; the requester simply times out and retransmits
+    return;
+  }
+  auto retryAfter = time::duration_cast<time::milliseconds>(m_scheduler.estimateQueueingDelay());
+  retryAfter = std::clamp(retryAfter, MIN_RETRY_AFTER, MAX_RETRY_AFTER);
+
+  // shedding must stay much cheaper than serving, so the reply is never signed with the CA key;
+  // requesters accept it as a retry hint whose delay they bound
+  Data result;
+  result.setName(request.getName());
+  result.setFreshnessPeriod(DEFAULT_DATA_FRESHNESS_PERIOD);
+  result.setContent(errortlv::encodeDataContent(ErrorCode::SERVICE_UNAVAILABLE,
+                                                "The CA is overloaded, please retry later.", retryAfter));
+  m_keyChain.sign(result, ndn::security::signingWithSha256());
+  m_face.put(result);
+}
+
+void
+CaModule::signWithSessionKey(Data& data, const RequestState& session)
+{
+  auto hmacKey = deriveSessionHmacKey(session.encryptionKey.data(), session.encryptionKey.size(),
+                                      session.requestId.data(), session.requestId.size());
+  Name keyName = m_config.caProfile.caPrefix;
+  keyName.append("CA").append(Name::Component(session.requestId));
+  signDataWithHmacSha256(data, hmacKey.data(), hmacKey.size(), keyName);
+}
+
 Data
-CaModule::generateErrorDataPacket(const Name& name, ErrorCode error, const std::string& errorInfo)
+CaModule::generateErrorDataPacket(const Name& name, ErrorCode error, const std::string& errorInfo,
+                                  std::optional<time::milliseconds> retryAfter,
+                                  const RequestState* session)
 {
   Data result;
   result.setName(name);
   result.setFreshnessPeriod(DEFAULT_DATA_FRESHNESS_PERIOD);
-  result.setContent(errortlv::encodeDataContent(error, errorInfo));
-  m_keyChain.sign(result, signingByIdentity(m_config.caProfile.caPrefix));
+
+  // error messages come from a small fixed set, so their encoding is done only once
+  if (retryAfter) {
+    result.setContent(errortlv::encodeDataContent(error, errorInfo, retryAfter));
+  }
+  else {
+    auto it = m_errorContents.find({error, errorInfo});
+    if (it != m_errorContents.end()) {
+      result.setContent(it->second);
+    }
+    else {
+      auto content = errortlv::encodeDataContent(error, errorInfo);
+      if (m_errorContents.size() < MAX_CACHED_ERROR_CONTENTS) {
+        m_errorContents.emplace(std::make_pair(error, errorInfo), content);
+      }
+      result.setContent(content);
+    }
+  }
+
+  switch (m_config.errorSigning) {
+    case ErrorSigning::SESSION_HMAC:
+      if (session != nullptr) {
+        signWithSessionKey(result, *session);
+        break;
+      }
+      [[fallthrough]];
+    case ErrorSigning::DIGEST_SHA256:
+      m_keyChain.sign(result, ndn::security::signingWithSha256());
+      break;
+    case ErrorSigning::CA_KEY:
+      m_keyChain.sign(result, signingByIdentity(m_config.caProfile.caPrefix));
+      break;
+  }
   return result;
 }
 
@@ -21,13 +21,20 @@
 #ifndef NDNCERT_CA_MODULE_HPP
 #define NDNCERT_CA_MODULE_HPP
 
+#include "challenge/challenge-module.hpp"
 #include "detail/ca-configuration.hpp"
 #include "detail/crypto-helpers.hpp"
 #include "detail/ca-storage.hpp"
+#include "detail/counting-bloom-filter.hpp"
+#include "detail/request-scheduler.hpp"
+#include "detail/resumption-ticket.hpp"
 
 #include <ndn-cxx/face.hpp>
+#include <ndn-cxx/ims/in-memory-storage-lru.hpp>
 #include <ndn-cxx/security/key-chain.hpp>
 
+#include <set>
+
 namespace ndncert::ca {
 
 /**
@@ -42,6 +49,20 @@ using StatusUpdateCallback = std::function<void(const RequestState&)>;
 
 class CaModule : boost::noncopyable
 {
+public:
+  /**
+   * @brief Statistics of the cache of signed PROBE responses.
+   */
+  struct ProbeCacheStats
+  {
+    uint64_t nHits = 0;
+    uint64_t nMisses = 0;
+    /**
+     * @brief Estimated time saved by not signing the responses served from the cache.
+     */
+    time::nanoseconds savedSigningTime = 0_ns;
+  };
+
 public:
   CaModule(ndn::Face& face, ndn::KeyChain& keyChain, const std::string& configPath,
            const std::string& storageType = "ca-storage-sqlite3");
@@ -63,9 +84,37 @@ public:
   void
   setStatusUpdateCallback(const StatusUpdateCallback& onUpdateCallback);
 
+  /**
+   * @brief Get the first segment of the CA profile.
+   */
   Data
   getCaProfileData();
 
+  /**
+   * @brief Get all segments of the CA profile.
+   *
+   * The profile is published in a single segment, unless CaConfig::profileSegmentSize is set
+   * and the encoded profile is larger than that.
+   */
+  const std::vector<Data>&
+  getCaProfileSegments();
+
+  /**
+   * @brief Reload the configuration file the CA module has been created with.
+   *
+   * All cached responses are dropped, since they may depend on the old configuration.
+   * @throw std::runtime_error the configuration is invalid or changes the CA prefix; in that
+   *        case, the current configuration is kept.
+   */
+  void
+  reload();
+
+  const ProbeCacheStats&
+  getProbeCacheStats() const
+  {
+    return m_probeCacheStats;
+  }
+
 NDNCERT_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
   void
   onCaProfileDiscovery(const Interest& request);
@@ -76,31 +125,161 @@ NDNCERT_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
   void
   onNewRenewRevoke(const Interest& request, RequestType requestType);
 
+  /**
+   * @brief Renew a certificate without a challenge.
+   *
+   * The requester proves that it holds a currently valid certificate issued by this CA by
+   * signing the RENEW Interest with its key. The renewed certificate is issued right away, and
+   * nothing is written to the CA storage.
+   */
+  void
+  onRenew(const Interest& request);
+
   void
   onChallenge(const Interest& request);
 
+  /**
+   * @brief Respond to a CHALLENGE request once the challenge module has handled it.
+   *
+   * SERVICE_UNAVAILABLE from the module is a temporary failure: the stored request is left as it
+   * was and the reply is not cached, so that the requester can retry the same Interest.
+   */
+  void
+  onChallengeCompleted(const Interest& request, RequestState& requestState,
+                       ErrorCode errorCode, const std::string& errorInfo);
+
+  /**
+   * @brief Decrypt the first challenge step carried by a NEW request.
+   * @param aead The AEAD algorithm selected by the NEW request.
+   * @return the challenge parameters, or std::nullopt if they cannot be decrypted, e.g.,
+   *         because they are encrypted to an ECDH key the CA no longer has.
+   */
+  std::optional<Block>
+  decryptEarlyChallenge(const Block& earlyChallenge, ndn::span<const uint8_t> ecdhPub,
+                        const Certificate& certRequest, AeadAlgorithm aead);
+
+  /**
+   * @brief Respond to a NEW request carrying a challenge step once the challenge module has
+   *        handled it.
+   * @param content The content of the NEW response, to which the challenge result is added.
+   */
+  void
+  onEarlyChallengeCompleted(const Interest& request, RequestState& requestState, Block content,
+                            ErrorCode errorCode, const std::string& errorInfo);
+
+  /**
+   * @brief Record the outcome of a successful challenge step, issuing the certificate if the
+   *        challenge has been passed.
+   * @return the encrypted challenge result.
+   */
+  Block
+  finishChallengeStep(RequestState& requestState);
+
   void
   onRegisterFailed(const std::string& reason);
 
+  void
+  onRequestShed(const Interest& request, RequestClass requestClass);
+
+  /**
+   * @brief Answer an exact retransmission of a NEW, RENEW, REVOKE, or CHALLENGE request.
+   * @return whether the original response has been found and sent again.
+   */
+  bool
+  replayResponse(const Interest& request);
+
+  /**
+   * @brief Send a response to a NEW, RENEW, REVOKE, or CHALLENGE request, keeping it for replays.
+   */
+  void
+  putResponse(const Data& response);
+
   std::unique_ptr<RequestState>
   getCertificateRequest(const Interest& request);
 
+  /**
+   * @brief Delete a request from the storage and from the request ID filter.
+   */
+  void
+  deleteRequest(const RequestId& requestId);
+
   Certificate
   issueCertificate(const RequestState& requestState);
 
   void
   registerPrefix();
 
+  /**
+   * @brief Sign @p data with the HMAC key derived from the session key of @p session.
+   */
+  void
+  signWithSessionKey(Data& data, const RequestState& session);
+
+  /**
+   * @brief Generate a Data packet carrying an error.
+   *
+   * The packet is signed according to CaConfig::errorSigning; @p session is the state of the
+   * request the error belongs to, if the requester has already established a session key.
+   */
   Data
-  generateErrorDataPacket(const Name& name, ErrorCode error, const std::string& errorInfo);
+  generateErrorDataPacket(const Name& name, ErrorCode error, const std::string& errorInfo,
+                          std::optional<time::milliseconds> retryAfter = std::nullopt,
+                          const RequestState* session = nullptr);
 
 NDNCERT_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
   ndn::Face& m_face;
+  std::string m_configPath;
   CaConfig m_config;
   std::unique_ptr<CaStorage> m_storage;
+  /**
+   * IDs of the requests in m_storage, which must only be added and deleted through CaModule
+   */
+  CountingBloomFilter m_requestFilter;
   ndn::KeyChain& m_keyChain;
-  uint8_t m_requestIdGenKey[32];
-  std::unique_ptr<Data> m_profileData;
+  /**
+   * HMAC keyed with a random secret, which derives request IDs from certificate names
+   */
+  KeyedHmacSha256 m_requestIdHmac;
+  std::vector<Data> m_profileSegments;
+  /**
+   * Signed RDR metadata of the profile, reused until m_metadataExpiry
+   */
+  std::unique_ptr<Data> m_metadataData;
+  time::steady_clock::time_point m_metadataExpiry;
+  RequestScheduler m_scheduler;
+  /**
+   * Pre-encoded content of error responses, by error code and error info
+   */
+  std::map<std::pair<ErrorCode, std::string>, Block> m_errorContents;
+  /**
+   * Signed PROBE responses, kept for their freshness period
+   */
+  ndn::InMemoryStorageLru m_probeCache;
+  ProbeCacheStats m_probeCacheStats;
+  /**
+   * Moving average of the time spent signing a PROBE response
+   */
+  time::nanoseconds m_probeSigningTime = 0_ns;
+  /**
+   * Responses to NEW, REVOKE, and CHALLENGE requests, replayed on retransmissions
+   */
+  ndn::InMemoryStorageLru m_replayCache;
+  /**
+   * Configured instances of the supported challenges, by challenge type
+   */
+  std::map<std::string, std::unique_ptr<ChallengeModule>> m_challengeModules;
+  /**
+   * Requests whose current challenge step has not been completed by the challenge module
+   */
+  std::set<RequestId> m_challengesInProgress;
+  /**
+   * Keys sealing the resumption tickets, if the CA issues them
+   */
+  std::unique_ptr<ResumptionTicketKeys> m_ticketKeys;
+  /**
+   * Long-lived X25519 key published in the profile if CaConfig::earlyChallenge is set
+   */
+  ECDHState m_earlyEcdh;
   /**
    * StatusUpdate Callback function
    */
@@ -34,6 +34,11 @@ const std::string ChallengeEmail::NEED_CODE = "need-code";
 const std::string ChallengeEmail::WRONG_CODE = "wrong-code";
 const std::string ChallengeEmail::PARAMETER_KEY_EMAIL = "email";
 const std::string ChallengeEmail::PARAMETER_KEY_CODE = "code";
+const std::string ChallengeEmail::CONFIG_SCRIPT_PATH = "script-path";
+const std::string ChallengeEmail::CONFIG_SMTP_CONFIG = "smtp-config";
+const std::string ChallengeEmail::CONFIG_SEND_WORKERS = "send-workers";
+const std::string ChallengeEmail::CONFIG_SEND_QUEUE_CAPACITY = "send-queue-capacity";
+const std::string ChallengeEmail::CONFIG_SEND_MAX_ATTEMPTS = "send-max-attempts";
 
 ChallengeEmail::ChallengeEmail(const std::string& scriptPath,
                                const size_t& maxAttemptTimes,
@@ -43,6 +48,35 @@ ChallengeEmail::ChallengeEmail(const std::string& scriptPath,
 {
 }
 
+void
+ChallengeEmail::loadConfig(const JsonSection& config)
+{
+  ChallengeModule::loadConfig(config);
+
+  auto options = m_dispatcherOptions;
+  std::string smtpConfig;
+  try {
+    m_sendEmailScript = config.get(CONFIG_SCRIPT_PATH, m_sendEmailScript);
+    smtpConfig = config.get(CONFIG_SMTP_CONFIG, "");
+    options.nWorkers = config.get(CONFIG_SEND_WORKERS, options.nWorkers);
+    options.queueCapacity = config.get(CONFIG_SEND_QUEUE_CAPACITY, options.queueCapacity);
+    options.maxAttempts = config.get(CONFIG_SEND_MAX_ATTEMPTS, options.maxAttempts);
+  }
+  catch (const boost::property_tree::ptree_error& e) {
+    NDN_THROW(std::runtime_error("Invalid email challenge configuration: " + std::string(e.what())));
+  }
+  if (options.nWorkers == 0 || options.queueCapacity == 0 || options.maxAttempts == 0) {
+    NDN_THROW(std::runtime_error("Email sending workers, queue capacity, and attempts must be positive"));
+  }
+  auto smtpOptions = smtpConfig.empty() ? std::nullopt :
+                     std::make_optional(SmtpClient::loadOptions(smtpConfig));
+
+  // pending emails are dropped; the requester can ask for a new code once the secret expires
+  m_dispatcher.reset();
+  m_dispatcherOptions = options;
+  m_smtpClient = smtpOptions ? std::make_shared<SmtpClient>(*smtpOptions) : nullptr;
+}
+
 // For CA
 std::tuple<ErrorCode, std::string>
 ChallengeEmail::handleChallengeRequest(const Block& params, ca::RequestState& request)
@@ -61,7 +95,9 @@ ChallengeEmail::handleChallengeRequest(const Block& params, ca::RequestState& re
     JsonSection secretJson;
     secretJson.add(PARAMETER_KEY_CODE, emailCode);
     // send out the email
-    sendEmail(emailAddress, emailCode, request);
+    if (!sendEmail(emailAddress, emailCode, request)) {
+      return returnWithError(request, ErrorCode::SERVICE_UNAVAILABLE, "Cannot send email now.");
+    }
     NDN_LOG_TRACE("Secret for request " << ndn::toHex(request.requestId) << " : " << emailCode);
     return returnWithNewChallengeStatus(request, NEED_CODE, std::move(secretJson),
                                         m_maxAttemptTimes, m_secretLifetime);
@@ -157,23 +193,44 @@ ChallengeEmail::isValidEmailAddress(const std::string& emailAddress)
   return std::regex_match(emailAddress, emailPattern);
 }
 
-void
+bool
 ChallengeEmail::sendEmail(const std::string& emailAddress, const std::string& secret,
-                          const ca::RequestState& request) const
+                          const ca::RequestState& request)
+{
+  if (m_dispatcher == nullptr) {
+    EmailDispatcher::SendFunction send;
+    if (m_smtpClient != nullptr) {
+      send = [client = m_smtpClient] (const auto& message) {
+        client->send(message);
+        return true;
+      };
+    }
+    else {
+      send = [script = m_sendEmailScript] (const auto& message) {
+        return runSendEmailScript(script, message);
+      };
+    }
+    m_dispatcher = std::make_unique<EmailDispatcher>(std::move(send), m_dispatcherOptions);
+  }
+  return m_dispatcher->enqueue({emailAddress, secret, request.caPrefix.toUri(),
+                                request.cert.getName().toUri()});
+}
+
+bool
+ChallengeEmail::runSendEmailScript(const std::string& script, const EmailDispatcher::Message& message)
 {
-  std::string command = m_sendEmailScript;
-  command += " \"" + emailAddress + "\" \"" + secret + "\" \"" +
-             request.caPrefix.toUri() + "\" \"" +
-             request.cert.getName().toUri() + "\"";
+  std::string command = script;
+  command += " \"" + message.address + "\" \"" + message.secret + "\" \"" +
+             message.caPrefix + "\" \"" + message.certName + "\"";
   boost::process::child child(command);
   child.wait();
   if (child.exit_code() != 0) {
-    NDN_LOG_TRACE("EmailSending Script " + m_sendEmailScript + " fails.");
-  }
-  else {
-    NDN_LOG_TRACE("EmailSending Script " + m_sendEmailScript +
-              " was executed successfully with return value 0.");
+    NDN_LOG_TRACE("EmailSending Script " + script + " fails.");
+    return false;
   }
+  NDN_LOG_TRACE("EmailSending Script " + script +
+                " was executed successfully with return value 0.");
+  return true;
 }
 
 } // namespace ndncert
@@ -22,6 +22,8 @@
 #define NDNCERT_CHALLENGE_EMAIL_HPP
 
 #include "challenge-module.hpp"
+#include "challenge/email-dispatcher.hpp"
+#include "challenge/smtp-client.hpp"
 
 namespace ndncert {
 
@@ -41,6 +43,10 @@ namespace ndncert {
  *   FAILURE_MAXRETRY: When run out retry times.
  *   FAILURE_TIMEOUT: When the secret lifetime expires.
  *
+ * The email is handed to an EmailDispatcher and sent in the background, so the CHALLENGE
+ * response does not wait for the delivery to complete. Emails are delivered by the built-in
+ * SmtpClient when "smtp-config" is configured, and by the email sending script otherwise.
+ *
  * @sa https://github.com/named-data/ndncert/wiki/NDNCERT-Protocol-0.3-Challenges
  */
 class ChallengeEmail : public ChallengeModule
@@ -50,6 +56,14 @@ public:
                  const size_t& maxAttemptTimes = 3,
                  const time::seconds secretLifetime = time::seconds(300));
 
+  /**
+   * @brief Besides the common options, read the path of the email sending script from
+   *        "script-path", the SMTP settings file from "smtp-config", and the EmailDispatcher
+   *        options from "send-workers", "send-queue-capacity", and "send-max-attempts".
+   */
+  void
+  loadConfig(const JsonSection& config) override;
+
   // For CA
   std::tuple<ErrorCode, std::string>
   handleChallengeRequest(const Block& params, ca::RequestState& request) override;
@@ -68,17 +82,35 @@ public:
   // challenge parameters
   static const std::string PARAMETER_KEY_EMAIL;
   static const std::string PARAMETER_KEY_CODE;
+  // configuration
+  static const std::string CONFIG_SCRIPT_PATH;
+  static const std::string CONFIG_SMTP_CONFIG;
+  static const std::string CONFIG_SEND_WORKERS;
+  static const std::string CONFIG_SEND_QUEUE_CAPACITY;
+  static const std::string CONFIG_SEND_MAX_ATTEMPTS;
 
 NDNCERT_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
   static bool
   isValidEmailAddress(const std::string& emailAddress);
 
-  void
+  /**
+   * @brief Queue the email carrying @p secret for delivery.
+   * @return false if the email could not be queued.
+   */
+  bool
   sendEmail(const std::string& emailAddress, const std::string& secret,
-            const ca::RequestState& request) const;
+            const ca::RequestState& request);
 
-private:
+  static bool
+  runSendEmailScript(const std::string& script, const EmailDispatcher::Message& message);
+
+NDNCERT_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
   std::string m_sendEmailScript;
+  // shared with the send function of the dispatcher
+  std::shared_ptr<SmtpClient> m_smtpClient;
+  EmailDispatcher::Options m_dispatcherOptions;
+  // created on first use, so that requesters never start the worker threads
+  std::unique_ptr<EmailDispatcher> m_dispatcher;
 };
 
 } // namespace ndncert
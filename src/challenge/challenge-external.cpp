@@ -0,0 +1,233 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2024, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+
+#include "challenge-external.hpp"
+
+#include <ndn-cxx/util/logger.hpp>
+#include <ndn-cxx/util/string-helper.hpp>
+
+namespace ndncert {
+
+NDN_LOG_INIT(ndncert.challenge.external);
+NDNCERT_REGISTER_CHALLENGE(ChallengeExternal, "external");
+
+const std::string ChallengeExternal::PARAMETER_KEY_CREDENTIAL = "credential";
+const std::string ChallengeExternal::PARAMETER_KEY_RESPONSE = "response";
+const std::string ChallengeExternal::CONFIG_SOCKET_PATH = "socket-path";
+const std::string ChallengeExternal::CONFIG_CONNECTIONS = "connections";
+const std::string ChallengeExternal::CONFIG_TIMEOUT = "timeout";
+
+// key of the hex-encoded VerifierState in the challenge secrets
+const std::string SECRET_KEY_VERIFIER_STATE = "verifier-state";
+
+ChallengeExternal::ChallengeExternal()
+  : ChallengeModule("external", 3, time::seconds(300))
+{
+  m_clientOptions.socketPath = "/run/ndncert/verifier.sock";
+}
+
+void
+ChallengeExternal::loadConfig(const JsonSection& config)
+{
+  ChallengeModule::loadConfig(config);
+
+  auto options = m_clientOptions;
+  try {
+    options.socketPath = config.get(CONFIG_SOCKET_PATH, options.socketPath);
+    options.nConnections = config.get(CONFIG_CONNECTIONS, options.nConnections);
+    options.timeout = time::milliseconds(config.get(CONFIG_TIMEOUT, options.timeout.count()));
+  }
+  catch (const boost::property_tree::ptree_error& e) {
+    NDN_THROW(std::runtime_error("Invalid external challenge configuration: " + std::string(e.what())));
+  }
+  if (options.socketPath.empty() || options.nConnections == 0 || options.timeout <= 0_ms) {
+    NDN_THROW(std::runtime_error("External challenge needs a socket path, and positive connections and timeout"));
+  }
+  m_clientOptions = options;
+  m_client.reset();
+}
+
+// For CA
+std::tuple<ErrorCode, std::string>
+ChallengeExternal::handleChallengeRequest(const Block&, ca::RequestState& request)
+{
+  return returnWithError(request, ErrorCode::SERVICE_UNAVAILABLE,
+                         "External challenge requires asynchronous handling.");
+}
+
+void
+ChallengeExternal::handleChallengeRequestAsync(const Block& params, std::shared_ptr<ca::RequestState> request,
+                                               boost::asio::io_context& io, CompletionCallback onComplete)
+{
+  if (request->challengeState &&
+      time::system_clock::now() - request->challengeState->timestamp >= request->challengeState->remainingTime) {
+    auto [errorCode, errorInfo] = returnWithError(*request, ErrorCode::OUT_OF_TIME, "Secret expired.");
+    onComplete(errorCode, errorInfo);
+    return;
+  }
+
+  Block verifyRequest;
+  try {
+    verifyRequest = makeVerifyRequest(params, *request);
+  }
+  catch (const std::exception& e) {
+    NDN_LOG_ERROR("Cannot forward challenge parameters: " << e.what());
+    auto [errorCode, errorInfo] = returnWithError(*request, ErrorCode::BAD_PARAMETER_FORMAT,
+                                                  "Malformed challenge parameters.");
+    onComplete(errorCode, errorInfo);
+    return;
+  }
+
+  if (m_client == nullptr) {
+    m_client = std::make_unique<verifier::VerifierClient>(io, m_clientOptions);
+  }
+  // the client belongs to this module, so the callbacks never outlive it
+  m_client->call(std::move(verifyRequest),
+    [this, request, onComplete] (const Block& response) {
+      auto [errorCode, errorInfo] = onVerifyResponse(response, *request);
+      onComplete(errorCode, errorInfo);
+    },
+    [this, request, onComplete] (const std::string& reason) {
+      NDN_LOG_ERROR("Verifier call for request " << ndn::toHex(request->requestId) << " failed: " << reason);
+      auto [errorCode, errorInfo] = returnWithError(*request, ErrorCode::SERVICE_UNAVAILABLE,
+                                                    "Verifier unavailable.");
+      onComplete(errorCode, errorInfo);
+    });
+}
+
+Block
+ChallengeExternal::makeVerifyRequest(const Block& params, const ca::RequestState& request) const
+{
+  Block verifyRequest(verifier::tlv::VerifyRequest);
+  verifyRequest.push_back(ndn::makeBinaryBlock(tlv::RequestId, request.requestId));
+  verifyRequest.push_back(ndn::makeNestedBlock(tlv::CaPrefix, request.caPrefix));
+  verifyRequest.push_back(request.cert.getName().wireEncode());
+  if (request.challengeState) {
+    verifyRequest.push_back(ndn::makeStringBlock(tlv::ChallengeStatus,
+                                                 request.challengeState->challengeStatus));
+    auto state = request.challengeState->secrets.get(SECRET_KEY_VERIFIER_STATE, "");
+    if (!state.empty()) {
+      verifyRequest.push_back(ndn::makeBinaryBlock(verifier::tlv::VerifierState, *ndn::fromHex(state)));
+    }
+  }
+  params.parse();
+  for (const auto& element : params.elements()) {
+    if (element.type() == tlv::ParameterKey || element.type() == tlv::ParameterValue) {
+      verifyRequest.push_back(element);
+    }
+  }
+  verifyRequest.encode();
+  return verifyRequest;
+}
+
+std::tuple<ErrorCode, std::string>
+ChallengeExternal::onVerifyResponse(const Block& response, ca::RequestState& request)
+{
+  try {
+    response.parse();
+    auto result = static_cast<verifier::VerifyResult>(
+      ndn::readNonNegativeInteger(response.get(verifier::tlv::VerifyResult)));
+    switch (result) {
+      case verifier::VerifyResult::SUCCESS:
+        NDN_LOG_TRACE("Verifier accepted request " << ndn::toHex(request.requestId));
+        return returnWithSuccess(request);
+      case verifier::VerifyResult::CONTINUE: {
+        auto challengeStatus = readString(response.get(tlv::ChallengeStatus));
+        // the verifier may lower, but not raise, the number of tries left
+        size_t maxTries = m_maxAttemptTimes;
+        if (request.challengeState) {
+          if (request.challengeState->remainingTries <= 1) {
+            NDN_LOG_TRACE("Request " << ndn::toHex(request.requestId) << " ran out of tries");
+            return returnWithError(request, ErrorCode::OUT_OF_TRIES, "Ran out of tries.");
+          }
+          maxTries = request.challengeState->remainingTries - 1;
+        }
+        size_t remainingTries = maxTries;
+        auto remainingTime = m_secretLifetime;
+        JsonSection secrets;
+        for (const auto& element : response.elements()) {
+          switch (element.type()) {
+            case tlv::RemainingTries:
+              remainingTries = std::min<uint64_t>(ndn::readNonNegativeInteger(element), maxTries);
+              break;
+            case tlv::RemainingTime:
+              // nor extend the lifetime of the challenge status beyond secret-lifetime
+              remainingTime = time::seconds(std::min<uint64_t>(ndn::readNonNegativeInteger(element),
+                                                               m_secretLifetime.count()));
+              break;
+            case verifier::tlv::VerifierState:
+              secrets.add(SECRET_KEY_VERIFIER_STATE, ndn::toHex(element.value_bytes()));
+              break;
+          }
+        }
+        NDN_LOG_TRACE("Verifier moved request " << ndn::toHex(request.requestId) << " to " << challengeStatus);
+        return returnWithNewChallengeStatus(request, challengeStatus, std::move(secrets),
+                                            remainingTries, remainingTime);
+      }
+      case verifier::VerifyResult::FAILURE: {
+        auto info = response.find(tlv::ErrorInfo);
+        return returnWithError(request, ErrorCode::INVALID_PARAMETER,
+                               info != response.elements_end() ? readString(*info) : "Verification failed.");
+      }
+    }
+    NDN_LOG_ERROR("Unknown verify result " << static_cast<uint64_t>(result));
+  }
+  catch (const std::exception& e) {
+    NDN_LOG_ERROR("Malformed verifier response: " << e.what());
+  }
+  return returnWithError(request, ErrorCode::SERVICE_UNAVAILABLE, "Malformed verifier response.");
+}
+
+// For Client
+std::multimap<std::string, std::string>
+ChallengeExternal::getRequestedParameterList(Status status, const std::string& challengeStatus)
+{
+  std::multimap<std::string, std::string> result;
+  if (status == Status::BEFORE_CHALLENGE) {
+    result.emplace(PARAMETER_KEY_CREDENTIAL, "Please input your credential");
+  }
+  else if (status == Status::CHALLENGE) {
+    result.emplace(PARAMETER_KEY_RESPONSE, "Please input your response to " + challengeStatus);
+  }
+  else {
+    NDN_THROW(std::runtime_error("Unexpected status or challenge status."));
+  }
+  return result;
+}
+
+Block
+ChallengeExternal::genChallengeRequestTLV(Status status, const std::string& challengeStatus,
+                                          const std::multimap<std::string, std::string>& params)
+{
+  Block request(tlv::EncryptedPayload);
+  if (status != Status::BEFORE_CHALLENGE && status != Status::CHALLENGE) {
+    NDN_THROW(std::runtime_error("Unexpected status or challenge status."));
+  }
+  request.push_back(ndn::makeStringBlock(tlv::SelectedChallenge, CHALLENGE_TYPE));
+  for (const auto& [key, value] : params) {
+    request.push_back(ndn::makeStringBlock(tlv::ParameterKey, key));
+    request.push_back(ndn::makeStringBlock(tlv::ParameterValue, value));
+  }
+  request.encode();
+  return request;
+}
+
+} // namespace ndncert
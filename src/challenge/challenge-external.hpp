@@ -0,0 +1,110 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2024, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+
+#ifndef NDNCERT_CHALLENGE_EXTERNAL_HPP
+#define NDNCERT_CHALLENGE_EXTERNAL_HPP
+
+#include "challenge-module.hpp"
+#include "challenge/verifier-client.hpp"
+
+namespace ndncert {
+
+/**
+ * @brief Provide a challenge verified by an external process.
+ *
+ * Every challenge step is forwarded to a local verifier process through the protocol described
+ * in verifier-client.hpp, so that site-specific verification (directory lookups, device
+ * attestation, etc.) can be implemented and scaled outside the CA. The verifier decides
+ * whether the challenge succeeds, fails, or moves to a new challenge status; it may keep
+ * per-request state in the CA through VerifierState.
+ *
+ * The main process of this challenge module is:
+ *   1. Requester provides a credential.
+ *   2. The verifier accepts or rejects it, or asks for a response under a new challenge status.
+ *   3. Requester provides the response, and so on.
+ *
+ * Every step asking for a response costs a try, whatever RemainingTries the verifier reports,
+ * so a request never gets more than "max-attempts" steps. Likewise, a RemainingTime reported by
+ * the verifier is capped at "secret-lifetime".
+ *
+ * Failure info when application fails:
+ *   SERVICE_UNAVAILABLE: When the verifier cannot be reached, does not answer in time, or answers
+ *                        with a malformed response. The CA keeps the request, so that the
+ *                        requester can retry the step.
+ *   OUT_OF_TIME: When the challenge status has expired.
+ *   OUT_OF_TRIES: When the verifier asks for another response but no tries are left.
+ *   INVALID_PARAMETER: When the verifier rejects the request.
+ */
+class ChallengeExternal : public ChallengeModule
+{
+public:
+  ChallengeExternal();
+
+  /**
+   * @brief Besides the common options, read the verifier socket from "socket-path", the number
+   *        of connections from "connections", and the call timeout in milliseconds from "timeout".
+   */
+  void
+  loadConfig(const JsonSection& config) override;
+
+  // For CA
+  /**
+   * @brief Not supported, the verifier is only called asynchronously.
+   */
+  std::tuple<ErrorCode, std::string>
+  handleChallengeRequest(const Block& params, ca::RequestState& request) override;
+
+  void
+  handleChallengeRequestAsync(const Block& params, std::shared_ptr<ca::RequestState> request,
+                              boost::asio::io_context& io, CompletionCallback onComplete) override;
+
+  // For Client
+  std::multimap<std::string, std::string>
+  getRequestedParameterList(Status status, const std::string& challengeStatus) override;
+
+  Block
+  genChallengeRequestTLV(Status status, const std::string& challengeStatus,
+                         const std::multimap<std::string, std::string>& params) override;
+
+  // challenge parameters
+  static const std::string PARAMETER_KEY_CREDENTIAL;
+  static const std::string PARAMETER_KEY_RESPONSE;
+  // configuration
+  static const std::string CONFIG_SOCKET_PATH;
+  static const std::string CONFIG_CONNECTIONS;
+  static const std::string CONFIG_TIMEOUT;
+
+NDNCERT_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
+  Block
+  makeVerifyRequest(const Block& params, const ca::RequestState& request) const;
+
+  std::tuple<ErrorCode, std::string>
+  onVerifyResponse(const Block& response, ca::RequestState& request);
+
+NDNCERT_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
+  verifier::VerifierClient::Options m_clientOptions;
+  // created on first use, on the io_context of the CA
+  std::unique_ptr<verifier::VerifierClient> m_client;
+};
+
+} // namespace ndncert
+
+#endif // NDNCERT_CHALLENGE_EXTERNAL_HPP
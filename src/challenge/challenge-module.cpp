@@ -24,6 +24,9 @@
 
 namespace ndncert {
 
+const std::string ChallengeModule::CONFIG_MAX_ATTEMPTS = "max-attempts";
+const std::string ChallengeModule::CONFIG_SECRET_LIFETIME = "secret-lifetime";
+
 ChallengeModule::ChallengeModule(const std::string& challengeType,
                                  size_t maxAttemptTimes,
                                  time::seconds secretLifetime)
@@ -33,6 +36,30 @@ ChallengeModule::ChallengeModule(const std::string& challengeType,
 {
 }
 
+void
+ChallengeModule::loadConfig(const JsonSection& config)
+{
+  try {
+    m_maxAttemptTimes = config.get(CONFIG_MAX_ATTEMPTS, m_maxAttemptTimes);
+    m_secretLifetime = time::seconds(config.get(CONFIG_SECRET_LIFETIME, m_secretLifetime.count()));
+  }
+  catch (const boost::property_tree::ptree_error& e) {
+    NDN_THROW(std::runtime_error("Invalid configuration of challenge " + CHALLENGE_TYPE + ": " + e.what()));
+  }
+  if (m_maxAttemptTimes == 0 || m_secretLifetime <= 0_s) {
+    NDN_THROW(std::runtime_error("Challenge " + CHALLENGE_TYPE + " needs positive " + CONFIG_MAX_ATTEMPTS +
+                                 " and " + CONFIG_SECRET_LIFETIME));
+  }
+}
+
+void
+ChallengeModule::handleChallengeRequestAsync(const Block& params, std::shared_ptr<ca::RequestState> request,
+                                             boost::asio::io_context&, CompletionCallback onComplete)
+{
+  auto [errorCode, errorInfo] = handleChallengeRequest(params, *request);
+  onComplete(errorCode, errorInfo);
+}
+
 bool
 ChallengeModule::isChallengeSupported(const std::string& challengeType)
 {
@@ -22,7 +22,11 @@
 #define NDNCERT_CHALLENGE_MODULE_HPP
 
 #include "detail/ca-request-state.hpp"
+#include "detail/ca-storage.hpp"
 
+#include <boost/asio/io_context.hpp>
+
+#include <functional>
 #include <map>
 #include <tuple>
 
@@ -36,10 +40,52 @@ public:
   virtual
   ~ChallengeModule() = default;
 
+  /**
+   * @brief Configure the module from its section of the CA configuration.
+   *
+   * The base implementation reads "max-attempts" and "secret-lifetime" (in seconds), keeping
+   * the current values for the ones that are absent.
+   * @throw std::runtime_error the section cannot be correctly parsed.
+   */
+  virtual void
+  loadConfig(const JsonSection& config);
+
+  /**
+   * @brief Give the module the storage of the CA, where it can keep state that must outlive
+   *        the module, e.g., across configuration reloads.
+   *
+   * @p storage must outlive the module.
+   */
+  void
+  setCaStorage(ca::CaStorage& storage)
+  {
+    m_caStorage = &storage;
+  }
+
   // For CA
   virtual std::tuple<ErrorCode, std::string>
   handleChallengeRequest(const Block& params, ca::RequestState& request) = 0;
 
+  /**
+   * @brief Callback of handleChallengeRequestAsync(), receiving what handleChallengeRequest()
+   *        would have returned.
+   */
+  using CompletionCallback = std::function<void(ErrorCode, const std::string&)>;
+
+  /**
+   * @brief Handle a challenge request without blocking the CA.
+   *
+   * Modules that wait on I/O override this function to start the work and return right away.
+   * @p onComplete must be invoked exactly once, from the thread running @p io, after
+   * @p request has been updated; it may be invoked before this function returns. A module that
+   * is destroyed before completing a request must not invoke @p onComplete.
+   *
+   * The default implementation completes synchronously through handleChallengeRequest().
+   */
+  virtual void
+  handleChallengeRequestAsync(const Block& params, std::shared_ptr<ca::RequestState> request,
+                              boost::asio::io_context& io, CompletionCallback onComplete);
+
   // For Client
   virtual std::multimap<std::string, std::string>
   getRequestedParameterList(Status status, const std::string& challengeStatus) = 0;
@@ -81,9 +127,14 @@ protected: // helpers used by concrete challenge modules
 public:
   const std::string CHALLENGE_TYPE;
 
+public:
+  static const std::string CONFIG_MAX_ATTEMPTS;
+  static const std::string CONFIG_SECRET_LIFETIME;
+
 protected:
-  const size_t m_maxAttemptTimes;
-  const time::seconds m_secretLifetime;
+  size_t m_maxAttemptTimes;
+  time::seconds m_secretLifetime;
+  ca::CaStorage* m_caStorage = nullptr;
 
 private:
   using CreateFunc = std::function<std::unique_ptr<ChallengeModule>()>;
@@ -37,6 +37,11 @@ const std::string ChallengePossession::PARAMETER_KEY_CREDENTIAL_CERT = "issued-c
 const std::string ChallengePossession::PARAMETER_KEY_NONCE = "nonce";
 const std::string ChallengePossession::PARAMETER_KEY_PROOF = "proof";
 const std::string ChallengePossession::NEED_PROOF = "need-proof";
+const std::string ChallengePossession::CONFIG_ANCHOR_FILE = "anchor-file";
+
+const size_t MAX_VERIFIED_CREDENTIALS = 4096;
+const size_t MAX_PENDING_CREDENTIALS = 4096;
+const time::seconds VERIFIED_CREDENTIAL_LIFETIME = 1_h;
 
 ChallengePossession::ChallengePossession(const std::string& configPath)
   : ChallengeModule("Possession", 1, time::seconds(60))
@@ -49,6 +54,17 @@ ChallengePossession::ChallengePossession(const std::string& configPath)
   }
 }
 
+void
+ChallengePossession::loadConfig(const JsonSection& config)
+{
+  ChallengeModule::loadConfig(config);
+  auto anchorFile = config.get_optional<std::string>(CONFIG_ANCHOR_FILE);
+  if (anchorFile) {
+    m_configFile = *anchorFile;
+    parseConfigFile();
+  }
+}
+
 void
 ChallengePossession::parseConfigFile()
 {
@@ -77,6 +93,62 @@ ChallengePossession::parseConfigFile()
     }
     m_trustAnchors.push_back(*cert);
   }
+  indexTrustAnchors();
+}
+
+void
+ChallengePossession::indexTrustAnchors()
+{
+  m_anchorIndex.clear();
+  for (const auto& anchor : m_trustAnchors) {
+    m_anchorIndex.emplace(anchor.getKeyName(), &anchor);
+    m_anchorIndex.emplace(anchor.getName(), &anchor);
+  }
+  m_verifiedCredentials.clear();
+}
+
+bool
+ChallengePossession::isTrustedCredential(const Certificate& credential)
+{
+  if (!credential.isValid()) {
+    return false;
+  }
+
+  auto now = time::system_clock::now();
+  auto fullName = credential.getFullName();
+  auto cached = m_verifiedCredentials.find(fullName);
+  if (cached != m_verifiedCredentials.end()) {
+    if (cached->second > now) {
+      return true;
+    }
+    m_verifiedCredentials.erase(cached);
+  }
+
+  const auto& sigInfo = credential.getSignatureInfo();
+  if (!sigInfo.hasKeyLocator() || sigInfo.getKeyLocator().getType() != ndn::tlv::Name) {
+    return false;
+  }
+  auto range = m_anchorIndex.equal_range(sigInfo.getKeyLocator().getName());
+  bool isTrusted = std::any_of(range.first, range.second, [&] (const auto& entry) {
+    return ndn::security::verifySignature(credential, *entry.second);
+  });
+  if (!isTrusted) {
+    return false;
+  }
+
+  if (m_verifiedCredentials.size() >= MAX_VERIFIED_CREDENTIALS) {
+    for (auto it = m_verifiedCredentials.begin(); it != m_verifiedCredentials.end();) {
+      it = it->second <= now ? m_verifiedCredentials.erase(it) : std::next(it);
+    }
+    if (m_verifiedCredentials.size() >= MAX_VERIFIED_CREDENTIALS) {
+      m_verifiedCredentials.clear();
+    }
+  }
+  // the credential is not trusted from the cache after it has expired
+  auto expiry = std::min<time::system_clock::time_point>(now + VERIFIED_CREDENTIAL_LIFETIME,
+                                                         credential.getValidityPeriod().getPeriod().second);
+  m_verifiedCredentials.emplace(std::move(fullName), expiry);
+  return true;
 }
 
 // For CA
@@ -118,14 +190,7 @@ ChallengePossession::handleChallengeRequest(const Block& params, ca::RequestStat
     if (!credential.hasContent() || signatureLen != 0) {
       return returnWithError(request, ErrorCode::BAD_INTEREST_FORMAT, "Cannot find certificate");
     }
-    auto keyLocator = credential.getSignatureInfo().getKeyLocator().getName();
-    ndn::security::transform::PublicKey key;
-    key.loadPkcs8(credential.getPublicKey());
-    bool checkOK = std::any_of(m_trustAnchors.begin(), m_trustAnchors.end(), [&] (const auto& anchor) {
-      return (anchor.getKeyName() == keyLocator || anchor.getName() == keyLocator) &&
-             ndn::security::verifySignature(credential, anchor);
-    });
-    if (!checkOK) {
+    if (!isTrustedCredential(credential)) {
       return returnWithError(request, ErrorCode::INVALID_PARAMETER, "Certificate cannot be verified");
     }
 
@@ -135,6 +200,16 @@ ChallengePossession::handleChallengeRequest(const Block& params, ca::RequestStat
     JsonSection secretJson;
     secretJson.add(PARAMETER_KEY_NONCE, ndn::toHex(secretCode));
     secretJson.add(PARAMETER_KEY_CREDENTIAL_CERT, ndn::toHex(credential.wireEncode()));
+    auto now = time::system_clock::now();
+    if (m_pendingCredentials.size() >= MAX_PENDING_CREDENTIALS) {
+      for (auto it = m_pendingCredentials.begin(); it != m_pendingCredentials.end();) {
+        it = it->second.expiry <= now ? m_pendingCredentials.erase(it) : std::next(it);
+      }
+    }
+    if (m_pendingCredentials.size() < MAX_PENDING_CREDENTIALS) {
+      m_pendingCredentials.insert_or_assign(request.requestId,
+                                            PendingCredential{credential, now + m_secretLifetime});
+    }
     NDN_LOG_TRACE("Secret for request " << ndn::toHex(request.requestId) << " : " << ndn::toHex(secretCode));
     return returnWithNewChallengeStatus(request, NEED_PROOF, std::move(secretJson), m_maxAttemptTimes, m_secretLifetime);
   }
@@ -144,7 +219,14 @@ ChallengePossession::handleChallengeRequest(const Block& params, ca::RequestStat
     if (credential.hasContent() || signatureLen == 0) {
       return returnWithError(request, ErrorCode::BAD_INTEREST_FORMAT, "Cannot find certificate");
     }
-    credential = Certificate(Block(ndn::fromHex(request.challengeState->secrets.get(PARAMETER_KEY_CREDENTIAL_CERT, ""))));
+    auto pending = m_pendingCredentials.find(request.requestId);
+    if (pending != m_pendingCredentials.end()) {
+      credential = std::move(pending->second.credential);
+      m_pendingCredentials.erase(pending);
+    }
+    else {
+      credential = Certificate(Block(ndn::fromHex(request.challengeState->secrets.get(PARAMETER_KEY_CREDENTIAL_CERT, ""))));
+    }
     auto secretCode = *ndn::fromHex(request.challengeState->secrets.get(PARAMETER_KEY_NONCE, ""));
 
     //check the proof
@@ -24,6 +24,8 @@
 
 #include <ndn-cxx/security/key-chain.hpp>
 
+#include <unordered_map>
+
 namespace ndncert {
 
 /**
@@ -47,6 +49,12 @@ namespace ndncert {
  *   INVALID_PARAMETER: When the cert issued from trust anchor or self-signed cert
  *     cannot be validated.
  *   FAILURE_INVALID_FORMAT: When the credential format is wrong.
+ *
+ * Trust anchors are indexed by key name and certificate name, and credentials that have been
+ * verified are remembered by their implicit digest, so each step does a constant number of
+ * lookups regardless of the number of anchors. The credential of a request waiting for its
+ * proof is kept decoded in memory; the hex copy in the challenge secrets is only decoded
+ * when the in-memory copy is missing, e.g., after the CA has been restarted.
  */
 class ChallengePossession : public ChallengeModule
 {
@@ -54,6 +62,14 @@ public:
   explicit
   ChallengePossession(const std::string& configPath = "");
 
+  /**
+   * @brief Besides the common options, read the trust anchor file from "anchor-file".
+   *
+   * The trust anchors are loaded right away, instead of on the first challenge request.
+   */
+  void
+  loadConfig(const JsonSection& config) override;
+
   // For CA
   std::tuple<ErrorCode, std::string>
   handleChallengeRequest(const Block& params, ca::RequestState& request) override;
@@ -76,13 +92,40 @@ public:
   static const std::string PARAMETER_KEY_NONCE;
   static const std::string PARAMETER_KEY_PROOF;
   static const std::string NEED_PROOF;
+  // configuration
+  static const std::string CONFIG_ANCHOR_FILE;
 
 NDNCERT_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
   void
   parseConfigFile();
 
+  /**
+   * @brief Rebuild the anchor index from m_trustAnchors and forget verified credentials.
+   */
+  void
+  indexTrustAnchors();
+
+  /**
+   * @brief Check whether @p credential is currently valid and signed by one of the trust anchors.
+   *
+   * A verified credential is remembered until it expires, or for at most an hour.
+   */
+  bool
+  isTrustedCredential(const Certificate& credential);
+
 NDNCERT_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
+  struct PendingCredential
+  {
+    Certificate credential;
+    time::system_clock::time_point expiry;
+  };
+
   std::list<Certificate> m_trustAnchors;
+  // points into m_trustAnchors, by both key name and certificate name
+  std::unordered_multimap<Name, const Certificate*> m_anchorIndex;
+  // credentials that passed verification, by full name, with the expiry of the cache entry
+  std::unordered_map<Name, time::system_clock::time_point> m_verifiedCredentials;
+  std::map<RequestId, PendingCredential> m_pendingCredentials;
   std::string m_configFile;
 };
 
@@ -0,0 +1,216 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2024, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+
+#include "challenge-token.hpp"
+#include "detail/crypto-helpers.hpp"
+
+#include <ndn-cxx/util/logger.hpp>
+#include <ndn-cxx/util/random.hpp>
+#include <ndn-cxx/util/string-helper.hpp>
+
+#include <boost/endian/conversion.hpp>
+
+#include <openssl/crypto.h>
+
+#include <cstring>
+
+namespace ndncert {
+
+NDN_LOG_INIT(ndncert.challenge.token);
+NDNCERT_REGISTER_CHALLENGE(ChallengeToken, "token");
+
+const std::string ChallengeToken::PARAMETER_KEY_TOKEN = "token";
+const std::string ChallengeToken::CONFIG_TOKEN_KEY = "token-key";
+const std::string ChallengeToken::CONFIG_MAX_TOKEN_LIFETIME = "max-token-lifetime";
+
+ChallengeToken::ChallengeToken()
+  : ChallengeModule("token", 1, time::seconds(300))
+{
+}
+
+void
+ChallengeToken::loadConfig(const JsonSection& config)
+{
+  ChallengeModule::loadConfig(config);
+
+  std::vector<uint8_t> key;
+  auto maxTokenLifetime = m_maxTokenLifetime;
+  try {
+    auto keyHex = config.get(CONFIG_TOKEN_KEY, "");
+    if (!keyHex.empty()) {
+      auto buffer = ndn::fromHex(keyHex);
+      key.assign(buffer->begin(), buffer->end());
+    }
+    maxTokenLifetime = time::seconds(config.get(CONFIG_MAX_TOKEN_LIFETIME, m_maxTokenLifetime.count()));
+  }
+  catch (const std::exception& e) {
+    NDN_THROW(std::runtime_error("Invalid token challenge configuration: " + std::string(e.what())));
+  }
+  if (key.size() < 16) {
+    NDN_THROW(std::runtime_error("Token challenge needs a " + CONFIG_TOKEN_KEY + " of at least 16 bytes"));
+  }
+  if (maxTokenLifetime <= 0_s) {
+    NDN_THROW(std::runtime_error("Token challenge needs a positive " + CONFIG_MAX_TOKEN_LIFETIME));
+  }
+  m_key = std::move(key);
+  m_maxTokenLifetime = maxTokenLifetime;
+}
+
+// For CA
+std::tuple<ErrorCode, std::string>
+ChallengeToken::handleChallengeRequest(const Block& params, ca::RequestState& request)
+{
+  if (request.status != Status::BEFORE_CHALLENGE) {
+    return returnWithError(request, ErrorCode::INVALID_PARAMETER, "Unexpected status or challenge status.");
+  }
+  if (m_key.empty()) {
+    NDN_LOG_ERROR("Token challenge used without " << CONFIG_TOKEN_KEY);
+    return returnWithError(request, ErrorCode::SERVICE_UNAVAILABLE, "Token challenge is not configured.");
+  }
+
+  params.parse();
+  std::string token;
+  const auto& elements = params.elements();
+  for (size_t i = 0; i + 1 < elements.size(); ++i) {
+    if (elements[i].type() == tlv::ParameterKey && readString(elements[i]) == PARAMETER_KEY_TOKEN &&
+        elements[i + 1].type() == tlv::ParameterValue) {
+      token = readString(elements[i + 1]);
+    }
+  }
+
+  // token = <expiry>.<nonce>.<tag>
+  auto firstDot = token.find('.');
+  auto secondDot = firstDot == std::string::npos ? firstDot : token.find('.', firstDot + 1);
+  if (secondDot == std::string::npos || firstDot == 0 || firstDot > 12 ||
+      token.find_first_not_of("0123456789") < firstDot) {
+    return returnWithError(request, ErrorCode::BAD_PARAMETER_FORMAT, "Malformed token.");
+  }
+  uint64_t expirySeconds = std::stoull(token.substr(0, firstDot));
+  uint64_t nonce = 0;
+  ndn::ConstBufferPtr tag;
+  try {
+    auto nonceBuffer = ndn::fromHex(token.substr(firstDot + 1, secondDot - firstDot - 1));
+    tag = ndn::fromHex(token.substr(secondDot + 1));
+    if (nonceBuffer->size() != sizeof(nonce) || tag->size() != 32) {
+      return returnWithError(request, ErrorCode::BAD_PARAMETER_FORMAT, "Malformed token.");
+    }
+    std::memcpy(&nonce, nonceBuffer->data(), sizeof(nonce));
+    boost::endian::big_to_native_inplace(nonce);
+  }
+  catch (const ndn::StringHelperError&) {
+    return returnWithError(request, ErrorCode::BAD_PARAMETER_FORMAT, "Malformed token.");
+  }
+
+  auto now = time::system_clock::now();
+  auto expiry = time::fromUnixTimestamp(time::seconds(expirySeconds));
+  if (expiry <= now) {
+    return returnWithError(request, ErrorCode::OUT_OF_TIME, "Token expired.");
+  }
+  if (expiry - now > m_maxTokenLifetime) {
+    return returnWithError(request, ErrorCode::INVALID_PARAMETER, "Token lifetime is too long.");
+  }
+  auto expectedTag = computeTag(m_key, request.caPrefix, request.cert.getIdentity(), expirySeconds, nonce);
+  if (CRYPTO_memcmp(expectedTag.data(), tag->data(), expectedTag.size()) != 0) {
+    NDN_LOG_TRACE("Invalid token for request " << ndn::toHex(request.requestId));
+    return returnWithError(request, ErrorCode::INVALID_PARAMETER, "Invalid token.");
+  }
+  if (!markUsed(nonce, expiry)) {
+    NDN_LOG_TRACE("Replayed token for request " << ndn::toHex(request.requestId));
+    return returnWithError(request, ErrorCode::INVALID_PARAMETER, "Token already used.");
+  }
+  NDN_LOG_TRACE("Valid token. Challenge succeeded.");
+  return returnWithSuccess(request);
+}
+
+std::string
+ChallengeToken::makeToken(ndn::span<const uint8_t> key, const Name& caPrefix, const Name& identity,
+                          const time::system_clock::time_point& expiry)
+{
+  uint64_t expirySeconds = time::duration_cast<time::seconds>(time::toUnixTimestamp(expiry)).count();
+  uint64_t nonce = ndn::random::generateSecureWord64();
+  auto tag = computeTag(key, caPrefix, identity, expirySeconds, nonce);
+  boost::endian::native_to_big_inplace(nonce);
+  return std::to_string(expirySeconds) + "." +
+         ndn::toHex(ndn::make_span(reinterpret_cast<const uint8_t*>(&nonce), sizeof(nonce)), false) + "." +
+         ndn::toHex(tag, false);
+}
+
+std::array<uint8_t, 32>
+ChallengeToken::computeTag(ndn::span<const uint8_t> key, const Name& caPrefix, const Name& identity,
+                           uint64_t expiry, uint64_t nonce)
+{
+  const auto& caPrefixBlock = caPrefix.wireEncode();
+  const auto& identityBlock = identity.wireEncode();
+  std::vector<uint8_t> input(caPrefixBlock.begin(), caPrefixBlock.end());
+  input.insert(input.end(), identityBlock.begin(), identityBlock.end());
+  for (auto value : {expiry, nonce}) {
+    boost::endian::native_to_big_inplace(value);
+    auto bytes = reinterpret_cast<const uint8_t*>(&value);
+    input.insert(input.end(), bytes, bytes + sizeof(value));
+  }
+
+  std::array<uint8_t, 32> tag;
+  hmacSha256(input.data(), input.size(), key.data(), key.size(), tag.data());
+  return tag;
+}
+
+bool
+ChallengeToken::markUsed(uint64_t nonce, const time::system_clock::time_point& expiry)
+{
+  auto& storage = m_caStorage != nullptr ? *m_caStorage : m_ownStorage;
+  return storage.addUsedToken(nonce, expiry);
+}
+
+// For Client
+std::multimap<std::string, std::string>
+ChallengeToken::getRequestedParameterList(Status status, const std::string&)
+{
+  std::multimap<std::string, std::string> result;
+  if (status == Status::BEFORE_CHALLENGE) {
+    result.emplace(PARAMETER_KEY_TOKEN, "Please input your enrollment token");
+  }
+  else {
+    NDN_THROW(std::runtime_error("Unexpected status or challenge status."));
+  }
+  return result;
+}
+
+Block
+ChallengeToken::genChallengeRequestTLV(Status status, const std::string&,
+                                       const std::multimap<std::string, std::string>& params)
+{
+  Block request(tlv::EncryptedPayload);
+  if (status == Status::BEFORE_CHALLENGE) {
+    if (params.size() != 1 || params.find(PARAMETER_KEY_TOKEN) == params.end()) {
+      NDN_THROW(std::runtime_error("Wrong parameter provided."));
+    }
+    request.push_back(ndn::makeStringBlock(tlv::SelectedChallenge, CHALLENGE_TYPE));
+    request.push_back(ndn::makeStringBlock(tlv::ParameterKey, PARAMETER_KEY_TOKEN));
+    request.push_back(ndn::makeStringBlock(tlv::ParameterValue, params.find(PARAMETER_KEY_TOKEN)->second));
+  }
+  else {
+    NDN_THROW(std::runtime_error("Unexpected status or challenge status."));
+  }
+  request.encode();
+  return request;
+}
+
+} // namespace ndncert
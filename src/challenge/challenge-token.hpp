@@ -0,0 +1,113 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2024, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+
+#ifndef NDNCERT_CHALLENGE_TOKEN_HPP
+#define NDNCERT_CHALLENGE_TOKEN_HPP
+
+#include "challenge-module.hpp"
+#include "detail/ca-memory.hpp"
+
+namespace ndncert {
+
+/**
+ * @brief Provide a challenge passed by presenting a pre-authorized one-time enrollment token.
+ *
+ * Tokens are issued out of band, e.g., by a device provisioning line, with makeToken() and a
+ * key shared with the CA. A token authorizes one certificate for one identity until it expires:
+ *
+ *     <expiry>.<nonce>.<tag>
+ *
+ * where expiry is in seconds since the Unix epoch, nonce is 8 random bytes in hex, and tag is
+ * the hex HMAC-SHA256, under the token key, of the CA prefix, the identity, the expiry, and
+ * the nonce.
+ *
+ * The requester sends the token with its first CHALLENGE, and the CA verifies it with the key
+ * alone, so the certificate is issued after a single CHALLENGE round trip and the request is
+ * never updated in the CA storage. The nonces of used tokens are remembered in the CA storage
+ * until the tokens expire, so that each token is accepted once, also after the configuration
+ * is reloaded. The lifetime of acceptable tokens is bounded by "max-token-lifetime".
+ *
+ * Failure info when application fails:
+ *   BAD_PARAMETER_FORMAT: When the token is missing or malformed.
+ *   OUT_OF_TIME: When the token has expired.
+ *   INVALID_PARAMETER: When the token is not valid for the request, or has already been used.
+ */
+class ChallengeToken : public ChallengeModule
+{
+public:
+  ChallengeToken();
+
+  /**
+   * @brief Besides the common options, read the hex-encoded token key from "token-key", and
+   *        the longest acceptable token lifetime in seconds from "max-token-lifetime"
+   *        (default: 15 minutes).
+   */
+  void
+  loadConfig(const JsonSection& config) override;
+
+  // For CA
+  std::tuple<ErrorCode, std::string>
+  handleChallengeRequest(const Block& params, ca::RequestState& request) override;
+
+  // For Client
+  std::multimap<std::string, std::string>
+  getRequestedParameterList(Status status, const std::string& challengeStatus) override;
+
+  Block
+  genChallengeRequestTLV(Status status, const std::string& challengeStatus,
+                         const std::multimap<std::string, std::string>& params) override;
+
+  /**
+   * @brief Create a token authorizing @p identity to obtain a certificate from the CA
+   *        @p caPrefix until @p expiry.
+   */
+  static std::string
+  makeToken(ndn::span<const uint8_t> key, const Name& caPrefix, const Name& identity,
+            const time::system_clock::time_point& expiry);
+
+  // parameters
+  static const std::string PARAMETER_KEY_TOKEN;
+  // configuration
+  static const std::string CONFIG_TOKEN_KEY;
+  static const std::string CONFIG_MAX_TOKEN_LIFETIME;
+
+NDNCERT_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
+  static std::array<uint8_t, 32>
+  computeTag(ndn::span<const uint8_t> key, const Name& caPrefix, const Name& identity,
+             uint64_t expiry, uint64_t nonce);
+
+  /**
+   * @brief Remember @p nonce as used until @p expiry.
+   * @return false if @p nonce was already used.
+   */
+  bool
+  markUsed(uint64_t nonce, const time::system_clock::time_point& expiry);
+
+NDNCERT_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
+  std::vector<uint8_t> m_key;
+  time::seconds m_maxTokenLifetime = time::minutes(15);
+  // remembers used tokens when the module has no CA storage
+  ca::CaMemory m_ownStorage;
+};
+
+} // namespace ndncert
+
+#endif // NDNCERT_CHALLENGE_TOKEN_HPP
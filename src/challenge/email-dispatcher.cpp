@@ -0,0 +1,167 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2024, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+
+#include "challenge/email-dispatcher.hpp"
+
+#include <ndn-cxx/util/logger.hpp>
+
+namespace ndncert {
+
+NDN_LOG_INIT(ndncert.challenge.email-dispatcher);
+
+EmailDispatcher::EmailDispatcher(SendFunction send)
+  : EmailDispatcher(std::move(send), Options{})
+{
+}
+
+EmailDispatcher::EmailDispatcher(SendFunction send, const Options& options)
+  : m_send(std::move(send))
+  , m_options(options)
+{
+  if (options.nWorkers == 0 || options.queueCapacity == 0 || options.maxAttempts == 0) {
+    NDN_THROW(std::invalid_argument("Email dispatcher workers, queue capacity, and attempts must be positive"));
+  }
+  for (size_t i = 0; i < options.nWorkers; ++i) {
+    m_workers.emplace_back([this] { run(); });
+  }
+}
+
+EmailDispatcher::~EmailDispatcher()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_shouldStop = true;
+    if (!m_queue.empty()) {
+      NDN_LOG_WARN("Dropping " << m_queue.size() << " unsent emails");
+      m_counters.nDropped += m_queue.size();
+    }
+  }
+  m_workAvailable.notify_all();
+  m_stopRequested.notify_all();
+  for (auto& worker : m_workers) {
+    worker.join();
+  }
+}
+
+bool
+EmailDispatcher::enqueue(Message message)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto key = std::make_pair(message.address, message.certName);
+    auto it = m_queuedByRecipient.find(key);
+    if (it != m_queuedByRecipient.end()) {
+      NDN_LOG_TRACE("Replacing queued email to " << message.address);
+      *it->second = std::move(message);
+      ++m_counters.nCoalesced;
+      return true;
+    }
+    if (m_queue.size() >= m_options.queueCapacity) {
+      NDN_LOG_ERROR("Email queue full, dropping email to " << message.address);
+      ++m_counters.nDropped;
+      return false;
+    }
+    m_queue.push_back(std::move(message));
+    m_queuedByRecipient.emplace(std::move(key), std::prev(m_queue.end()));
+    ++m_counters.nQueued;
+  }
+  m_workAvailable.notify_one();
+  return true;
+}
+
+EmailDispatcher::Counters
+EmailDispatcher::getCounters() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_counters;
+}
+
+void
+EmailDispatcher::waitUntilIdle()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_idle.wait(lock, [this] { return (m_queue.empty() && m_nInFlight == 0) || m_shouldStop; });
+}
+
+void
+EmailDispatcher::run()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true) {
+    m_workAvailable.wait(lock, [this] { return m_shouldStop || !m_queue.empty(); });
+    if (m_shouldStop) {
+      return;
+    }
+
+    auto message = std::move(m_queue.front());
+    m_queuedByRecipient.erase({message.address, message.certName});
+    m_queue.pop_front();
+    ++m_nInFlight;
+
+    lock.unlock();
+    bool isSent = deliver(message);
+    lock.lock();
+
+    --m_nInFlight;
+    if (isSent) {
+      ++m_counters.nSent;
+    }
+    else {
+      ++m_counters.nFailed;
+    }
+    if (m_queue.empty() && m_nInFlight == 0) {
+      m_idle.notify_all();
+    }
+  }
+}
+
+bool
+EmailDispatcher::deliver(const Message& message)
+{
+  auto backoff = m_options.initialBackoff;
+  for (size_t attempt = 1; ; ++attempt) {
+    bool isSent = false;
+    try {
+      isSent = m_send(message);
+    }
+    catch (const std::exception& e) {
+      NDN_LOG_ERROR("Error sending email to " << message.address << ": " << e.what());
+    }
+    if (isSent) {
+      NDN_LOG_TRACE("Email sent to " << message.address << " after " << attempt << " attempt(s)");
+      return true;
+    }
+    if (attempt >= m_options.maxAttempts) {
+      NDN_LOG_ERROR("Giving up sending email to " << message.address << " after " << attempt << " attempts");
+      return false;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    ++m_counters.nRetried;
+    if (m_stopRequested.wait_for(lock, std::chrono::milliseconds(backoff.count()),
+                                 [this] { return m_shouldStop; })) {
+      return false;
+    }
+    backoff *= 2;
+  }
+}
+
+} // namespace ndncert
@@ -0,0 +1,148 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2024, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+
+#ifndef NDNCERT_CHALLENGE_EMAIL_DISPATCHER_HPP
+#define NDNCERT_CHALLENGE_EMAIL_DISPATCHER_HPP
+
+#include "detail/ndncert-common.hpp"
+
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace ndncert {
+
+/**
+ * @brief Delivers challenge emails in the background.
+ *
+ * Messages are queued by the CA thread and sent by a fixed pool of worker threads, so that the
+ * CHALLENGE response does not wait for the email to be delivered. While a message is still
+ * queued, a new message to the same address about the same certificate replaces it, since only
+ * the latest secret is valid. A failed delivery is retried with exponential backoff.
+ */
+class EmailDispatcher : boost::noncopyable
+{
+public:
+  struct Message
+  {
+    std::string address;
+    std::string secret;
+    std::string caPrefix;
+    std::string certName;
+  };
+
+  /**
+   * @brief Deliver one message, returning whether it has been accepted by the mail system.
+   *
+   * Called from the worker threads.
+   */
+  using SendFunction = std::function<bool(const Message&)>;
+
+  struct Options
+  {
+    /**
+     * @brief Number of worker threads, i.e., maximum number of concurrent deliveries.
+     */
+    size_t nWorkers = 2;
+    /**
+     * @brief Maximum number of messages waiting for a worker.
+     */
+    size_t queueCapacity = 256;
+    /**
+     * @brief Number of delivery attempts of a message before giving up.
+     */
+    size_t maxAttempts = 3;
+    /**
+     * @brief Delay before the first retry, doubled before each subsequent one.
+     */
+    time::milliseconds initialBackoff = 1_s;
+  };
+
+  struct Counters
+  {
+    uint64_t nQueued = 0;
+    uint64_t nCoalesced = 0;
+    uint64_t nDropped = 0;
+    uint64_t nSent = 0;
+    uint64_t nRetried = 0;
+    uint64_t nFailed = 0;
+  };
+
+public:
+  explicit
+  EmailDispatcher(SendFunction send);
+
+  /**
+   * @throw std::invalid_argument any of the options is zero.
+   */
+  EmailDispatcher(SendFunction send, const Options& options);
+
+  /**
+   * @brief Stop the workers; messages that have not been sent yet are dropped.
+   */
+  ~EmailDispatcher();
+
+  /**
+   * @brief Queue a message for delivery.
+   * @return false if the queue is full and the message has been dropped.
+   */
+  bool
+  enqueue(Message message);
+
+  Counters
+  getCounters() const;
+
+  /**
+   * @brief Block until all queued messages have been delivered or given up on.
+   */
+  void
+  waitUntilIdle();
+
+private:
+  void
+  run();
+
+  bool
+  deliver(const Message& message);
+
+private:
+  SendFunction m_send;
+  const Options m_options;
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_workAvailable;
+  std::condition_variable m_stopRequested;
+  std::condition_variable m_idle;
+  std::list<Message> m_queue;
+  std::map<std::pair<std::string, std::string>, std::list<Message>::iterator> m_queuedByRecipient;
+  Counters m_counters;
+  size_t m_nInFlight = 0;
+  bool m_shouldStop = false;
+
+  std::vector<std::thread> m_workers;
+};
+
+} // namespace ndncert
+
+#endif // NDNCERT_CHALLENGE_EMAIL_DISPATCHER_HPP
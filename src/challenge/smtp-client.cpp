@@ -0,0 +1,541 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2024, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+
+#include "challenge/smtp-client.hpp"
+
+#include <ndn-cxx/security/transform/base64-encode.hpp>
+#include <ndn-cxx/security/transform/buffer-source.hpp>
+#include <ndn-cxx/security/transform/stream-sink.hpp>
+#include <ndn-cxx/util/logger.hpp>
+
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/algorithm/string/replace.hpp>
+#include <boost/asio/connect.hpp>
+#include <boost/asio/ip/host_name.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/asio/streambuf.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/property_tree/ini_parser.hpp>
+
+#include <ctime>
+#include <set>
+
+namespace ndncert {
+
+NDN_LOG_INIT(ndncert.challenge.smtp);
+
+namespace asio = boost::asio;
+using asio::ip::tcp;
+
+// limit on the size of a single reply, protecting against a misbehaving server
+const size_t MAX_REPLY_SIZE = 65536;
+const std::string MULTIPART_BOUNDARY = "=_ndncert_alternative_=";
+
+static std::string
+toBase64(const std::string& str)
+{
+  namespace tr = ndn::security::transform;
+  std::ostringstream os;
+  tr::bufferSource(str) >> tr::base64Encode(false) >> tr::streamSink(os);
+  return os.str();
+}
+
+static std::string
+expandTemplate(std::string text, const EmailDispatcher::Message& message)
+{
+  boost::algorithm::replace_all(text, "{0}", message.secret);
+  boost::algorithm::replace_all(text, "{1}", message.caPrefix);
+  boost::algorithm::replace_all(text, "{2}", message.certName);
+  return text;
+}
+
+static bool
+isSafeHeaderValue(const std::string& value)
+{
+  return value.find_first_of("\r\n") == std::string::npos;
+}
+
+class SmtpClient::Connection : boost::noncopyable
+{
+public:
+  /**
+   * @brief Open the connection, then perform the TLS, EHLO, and AUTH exchanges.
+   */
+  explicit
+  Connection(const Options& options);
+
+  /**
+   * @brief Run one mail transaction.
+   * @param content the message headers and body, with CRLF line endings.
+   */
+  void
+  sendMessage(const std::string& from, const std::string& to, const std::string& content);
+
+  /**
+   * @brief Politely end the session, ignoring errors.
+   */
+  void
+  quit() noexcept;
+
+  size_t
+  getMessageCount() const
+  {
+    return m_nMessages;
+  }
+
+private:
+  struct Reply
+  {
+    int code = 0;
+    std::vector<std::string> lines;
+  };
+
+  template<typename Initiate>
+  void
+  run(const std::string& what, Initiate&& initiate);
+
+  void
+  handshake();
+
+  void
+  write(const std::string& data);
+
+  Reply
+  readReply();
+
+  Reply
+  expect(int expectedCode, const std::string& command);
+
+  void
+  ehlo();
+
+private:
+  const Options& m_options;
+  asio::io_context m_io;
+  asio::ssl::context m_sslContext;
+  asio::ssl::stream<tcp::socket> m_stream;
+  asio::streambuf m_buffer;
+  std::set<std::string> m_extensions;
+  size_t m_nMessages = 0;
+  bool m_isTls = false;
+};
+
+SmtpClient::Connection::Connection(const Options& options)
+  : m_options(options)
+  , m_sslContext(asio::ssl::context::tls_client)
+  , m_stream(m_io, m_sslContext)
+  , m_buffer(MAX_REPLY_SIZE)
+{
+  tcp::resolver resolver(m_io);
+  tcp::resolver::results_type endpoints;
+  run("resolve", [&] (auto handler) {
+    resolver.async_resolve(m_options.server, m_options.port,
+      [&endpoints, handler] (const boost::system::error_code& ec, tcp::resolver::results_type results) {
+        endpoints = std::move(results);
+        handler(ec);
+      });
+  });
+  run("connect", [&] (auto handler) { asio::async_connect(m_stream.next_layer(), endpoints, handler); });
+
+  if (m_options.security == Security::TLS) {
+    handshake();
+  }
+  expect(220, "Greeting");
+  ehlo();
+
+  if (m_options.security == Security::STARTTLS) {
+    if (m_extensions.count("STARTTLS") == 0) {
+      NDN_THROW(Error("Server " + m_options.server + " does not support STARTTLS"));
+    }
+    write("STARTTLS\r\n");
+    expect(220, "STARTTLS");
+    handshake();
+    // the extensions may change once the session is encrypted
+    ehlo();
+  }
+
+  if (!m_options.username.empty()) {
+    write("AUTH PLAIN " + toBase64('\0' + m_options.username + '\0' + m_options.password) + "\r\n");
+    expect(235, "AUTH");
+  }
+  NDN_LOG_DEBUG("Connected to " << m_options.server << ":" << m_options.port);
+}
+
+template<typename Initiate>
+void
+SmtpClient::Connection::run(const std::string& what, Initiate&& initiate)
+{
+  boost::system::error_code result = asio::error::would_block;
+  initiate([&result] (const boost::system::error_code& ec, auto&&...) { result = ec; });
+
+  m_io.restart();
+  m_io.run_for(std::chrono::milliseconds(m_options.timeout.count()));
+  if (result == asio::error::would_block) {
+    // let the cancelled operation complete before its handler state goes out of scope
+    boost::system::error_code ec;
+    m_stream.lowest_layer().close(ec);
+    m_io.restart();
+    m_io.run();
+    NDN_THROW(Error("SMTP " + what + " timed out"));
+  }
+  if (result) {
+    NDN_THROW(Error("SMTP " + what + " failed: " + result.message()));
+  }
+}
+
+void
+SmtpClient::Connection::handshake()
+{
+  m_sslContext.set_default_verify_paths();
+  m_stream.set_verify_mode(asio::ssl::verify_peer);
+#if BOOST_VERSION >= 107300
+  m_stream.set_verify_callback(asio::ssl::host_name_verification(m_options.server));
+#else
+  m_stream.set_verify_callback(asio::ssl::rfc2818_verification(m_options.server));
+#endif
+  // Server Name Indication
+  SSL_set_tlsext_host_name(m_stream.native_handle(), m_options.server.data());
+
+  run("TLS handshake", [&] (auto handler) {
+    m_stream.async_handshake(asio::ssl::stream_base::client, handler);
+  });
+  m_isTls = true;
+}
+
+void
+SmtpClient::Connection::write(const std::string& data)
+{
+  run("write", [&] (auto handler) {
+    if (m_isTls) {
+      asio::async_write(m_stream, asio::buffer(data), handler);
+    }
+    else {
+      asio::async_write(m_stream.next_layer(), asio::buffer(data), handler);
+    }
+  });
+}
+
+SmtpClient::Connection::Reply
+SmtpClient::Connection::readReply()
+{
+  Reply reply;
+  while (true) {
+    run("read", [&] (auto handler) {
+      if (m_isTls) {
+        asio::async_read_until(m_stream, m_buffer, "\r\n", handler);
+      }
+      else {
+        asio::async_read_until(m_stream.next_layer(), m_buffer, "\r\n", handler);
+      }
+    });
+
+    std::istream is(&m_buffer);
+    std::string line;
+    std::getline(is, line);
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (line.size() < 3 || !std::all_of(line.begin(), line.begin() + 3, ::isdigit) ||
+        (line.size() > 3 && line[3] != ' ' && line[3] != '-')) {
+      NDN_THROW(Error("Malformed SMTP reply: " + line));
+    }
+    reply.code = std::stoi(line.substr(0, 3));
+    reply.lines.push_back(line.size() > 4 ? line.substr(4) : "");
+    // the last line of a multiline reply has a space after the code
+    if (line.size() == 3 || line[3] == ' ') {
+      return reply;
+    }
+  }
+}
+
+SmtpClient::Connection::Reply
+SmtpClient::Connection::expect(int expectedCode, const std::string& command)
+{
+  auto reply = readReply();
+  // the first digit tells success, intermediate, or failure; e.g., RCPT may answer 251
+  if (reply.code / 100 != expectedCode / 100) {
+    NDN_THROW(Error(command + " rejected by " + m_options.server + ": " +
+                    std::to_string(reply.code) + " " + reply.lines.back()));
+  }
+  return reply;
+}
+
+void
+SmtpClient::Connection::ehlo()
+{
+  write("EHLO " + asio::ip::host_name() + "\r\n");
+  auto reply = expect(250, "EHLO");
+  m_extensions.clear();
+  // the first line is the greeting, each following line starts with an extension keyword
+  for (size_t i = 1; i < reply.lines.size(); ++i) {
+    auto keyword = reply.lines[i].substr(0, reply.lines[i].find(' '));
+    m_extensions.insert(boost::algorithm::to_upper_copy(keyword));
+  }
+}
+
+void
+SmtpClient::Connection::sendMessage(const std::string& from, const std::string& to,
+                                    const std::string& content)
+{
+  std::string mailFrom = "MAIL FROM:<" + from + ">\r\n";
+  std::string rcptTo = "RCPT TO:<" + to + ">\r\n";
+  if (m_extensions.count("PIPELINING") > 0) {
+    write(mailFrom + rcptTo + "DATA\r\n");
+    expect(250, "MAIL FROM");
+    expect(250, "RCPT TO");
+    expect(354, "DATA");
+  }
+  else {
+    write(mailFrom);
+    expect(250, "MAIL FROM");
+    write(rcptTo);
+    expect(250, "RCPT TO");
+    write("DATA\r\n");
+    expect(354, "DATA");
+  }
+
+  // dot-stuffing (RFC 5321 Section 4.5.2)
+  std::string data;
+  data.reserve(content.size() + 16);
+  size_t lineStart = 0;
+  while (lineStart < content.size()) {
+    auto lineEnd = content.find("\r\n", lineStart);
+    lineEnd = lineEnd == std::string::npos ? content.size() : lineEnd + 2;
+    if (content[lineStart] == '.') {
+      data += '.';
+    }
+    data.append(content, lineStart, lineEnd - lineStart);
+    lineStart = lineEnd;
+  }
+  if (data.size() < 2 || data.compare(data.size() - 2, 2, "\r\n") != 0) {
+    data += "\r\n";
+  }
+  write(data + ".\r\n");
+  expect(250, "Message");
+  ++m_nMessages;
+}
+
+void
+SmtpClient::Connection::quit() noexcept
+{
+  try {
+    write("QUIT\r\n");
+    readReply();
+  }
+  catch (const std::exception& e) {
+    NDN_LOG_TRACE("Error closing SMTP connection: " << e.what());
+  }
+}
+
+SmtpClient::Options
+SmtpClient::loadOptions(const std::string& fileName)
+{
+  boost::property_tree::ptree config;
+  Options options;
+  try {
+    boost::property_tree::read_ini(fileName, config);
+
+    options.server = config.get<std::string>("ndncert_smtp_settings.SMTP_SERVER");
+    options.port = config.get<std::string>("ndncert_smtp_settings.SMTP_PORT");
+    auto mode = config.get<std::string>("ndncert_smtp_settings.ENCRYPT_MODE");
+    if (mode == "none") {
+      options.security = Security::NONE;
+    }
+    else if (mode == "tls") {
+      options.security = Security::STARTTLS;
+    }
+    else if (mode == "ssl") {
+      options.security = Security::TLS;
+    }
+    else {
+      NDN_THROW(std::runtime_error("Unknown ENCRYPT_MODE '" + mode + "' in " + fileName));
+    }
+    options.username = config.get("ndncert_smtp_settings.SMTP_USER", "");
+    options.password = config.get("ndncert_smtp_settings.SMTP_PASSWORD", "");
+    options.maxConnections = config.get("ndncert_smtp_settings.MAX_CONNECTIONS", options.maxConnections);
+    options.maxMessagesPerConnection = config.get("ndncert_smtp_settings.MAX_MESSAGES_PER_CONNECTION",
+                                                  options.maxMessagesPerConnection);
+    options.timeout = time::seconds(config.get("ndncert_smtp_settings.TIMEOUT",
+                                               time::duration_cast<time::seconds>(options.timeout).count()));
+
+    options.mailFrom = config.get<std::string>("ndncert_email_settings.MAIL_FROM");
+    options.subject = config.get<std::string>("ndncert_email_settings.SUBJECT");
+    options.textTemplate = config.get<std::string>("ndncert_email_settings.TEXT_TEMPLATE");
+    options.htmlTemplate = config.get("ndncert_email_settings.HTML_TEMPLATE", "");
+  }
+  catch (const boost::property_tree::ptree_error& e) {
+    NDN_THROW(std::runtime_error("Cannot load SMTP settings from " + fileName + ": " + e.what()));
+  }
+  if (options.maxConnections == 0 || options.maxMessagesPerConnection == 0 ||
+      options.timeout <= 0_ms) {
+    NDN_THROW(std::runtime_error("SMTP connection limits and timeout must be positive in " + fileName));
+  }
+  return options;
+}
+
+SmtpClient::SmtpClient(const Options& options)
+  : m_options(options)
+  , m_envelopeFrom(options.mailFrom)
+{
+  // MAIL FROM takes the bare address of "Display Name <address>"
+  auto begin = m_envelopeFrom.rfind('<');
+  auto end = m_envelopeFrom.rfind('>');
+  if (begin != std::string::npos && end != std::string::npos && begin < end) {
+    m_envelopeFrom = m_envelopeFrom.substr(begin + 1, end - begin - 1);
+  }
+  if (!isSafeHeaderValue(m_options.mailFrom) || !isSafeHeaderValue(m_options.subject)) {
+    NDN_THROW(std::invalid_argument("SMTP sender and subject must be single lines"));
+  }
+}
+
+SmtpClient::~SmtpClient()
+{
+  for (auto& connection : m_idleConnections) {
+    connection->quit();
+  }
+}
+
+void
+SmtpClient::send(const EmailDispatcher::Message& message)
+{
+  if (message.address.empty() ||
+      message.address.find_first_of("\r\n<> \t") != std::string::npos ||
+      !isSafeHeaderValue(message.secret) || !isSafeHeaderValue(message.caPrefix) ||
+      !isSafeHeaderValue(message.certName)) {
+    NDN_THROW(Error("Refusing to send email with unsafe address or parameters"));
+  }
+  auto content = formatMessage(message);
+
+  for (int attempt = 0; ; ++attempt) {
+    auto connection = acquireConnection();
+    bool isPooled = connection->getMessageCount() > 0;
+    try {
+      connection->sendMessage(m_envelopeFrom, message.address, content);
+    }
+    catch (const Error& e) {
+      releaseConnection(std::move(connection), false);
+      // the server may have closed a pooled connection while it was idle
+      if (isPooled && attempt == 0) {
+        NDN_LOG_DEBUG("Pooled SMTP connection failed (" << e.what() << "), reconnecting");
+        continue;
+      }
+      throw;
+    }
+    releaseConnection(std::move(connection), true);
+    return;
+  }
+}
+
+size_t
+SmtpClient::getConnectionCount() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_nConnections;
+}
+
+std::string
+SmtpClient::formatMessage(const EmailDispatcher::Message& message) const
+{
+  auto toCrlf = [] (std::string text) {
+    boost::algorithm::replace_all(text, "\r\n", "\n");
+    boost::algorithm::replace_all(text, "\n", "\r\n");
+    return text;
+  };
+
+  char date[64];
+  std::time_t now = std::time(nullptr);
+  std::tm tm{};
+  gmtime_r(&now, &tm);
+  std::strftime(date, sizeof(date), "%a, %d %b %Y %H:%M:%S +0000", &tm);
+
+  std::string content = "From: " + m_options.mailFrom + "\r\n"
+                        "To: " + message.address + "\r\n"
+                        "Subject: " + m_options.subject + "\r\n"
+                        "Date: " + date + "\r\n"
+                        "MIME-Version: 1.0\r\n";
+  auto text = toCrlf(expandTemplate(m_options.textTemplate, message));
+  if (m_options.htmlTemplate.empty()) {
+    content += "Content-Type: text/plain; charset=utf-8\r\n\r\n" + text + "\r\n";
+  }
+  else {
+    auto html = toCrlf(expandTemplate(m_options.htmlTemplate, message));
+    content += "Content-Type: multipart/alternative; boundary=\"" + MULTIPART_BOUNDARY + "\"\r\n\r\n"
+               "--" + MULTIPART_BOUNDARY + "\r\n"
+               "Content-Type: text/plain; charset=utf-8\r\n\r\n" + text + "\r\n"
+               "--" + MULTIPART_BOUNDARY + "\r\n"
+               "Content-Type: text/html; charset=utf-8\r\n\r\n" + html + "\r\n"
+               "--" + MULTIPART_BOUNDARY + "--\r\n";
+  }
+  return content;
+}
+
+std::unique_ptr<SmtpClient::Connection>
+SmtpClient::acquireConnection()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_connectionReleased.wait(lock, [this] {
+    return !m_idleConnections.empty() || m_nConnections < m_options.maxConnections;
+  });
+  if (!m_idleConnections.empty()) {
+    auto connection = std::move(m_idleConnections.back());
+    m_idleConnections.pop_back();
+    return connection;
+  }
+
+  ++m_nConnections;
+  lock.unlock();
+  try {
+    return std::make_unique<Connection>(m_options);
+  }
+  catch (...) {
+    lock.lock();
+    --m_nConnections;
+    m_connectionReleased.notify_one();
+    throw;
+  }
+}
+
+void
+SmtpClient::releaseConnection(std::unique_ptr<Connection> connection, bool isReusable)
+{
+  if (isReusable && connection->getMessageCount() >= m_options.maxMessagesPerConnection) {
+    connection->quit();
+    isReusable = false;
+  }
+  if (!isReusable) {
+    connection.reset();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (isReusable) {
+      m_idleConnections.push_back(std::move(connection));
+    }
+    else {
+      --m_nConnections;
+    }
+  }
+  m_connectionReleased.notify_one();
+}
+
+} // namespace ndncert
@@ -0,0 +1,137 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2024, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+
+#ifndef NDNCERT_CHALLENGE_SMTP_CLIENT_HPP
+#define NDNCERT_CHALLENGE_SMTP_CLIENT_HPP
+
+#include "challenge/email-dispatcher.hpp"
+
+#include <condition_variable>
+#include <mutex>
+
+namespace ndncert {
+
+/**
+ * @brief Native SMTP submission client used by the email challenge.
+ *
+ * Sending a message borrows an open, authenticated connection from a pool, or opens a new one
+ * when none is idle and the pool is below its limit. After a successful transaction the
+ * connection is returned to the pool, so consecutive emails skip the TCP, TLS, and AUTH
+ * handshakes. When the server advertises PIPELINING, the MAIL, RCPT, and DATA commands of a
+ * message are sent in a single write.
+ *
+ * The client is thread-safe; each connection is used by one thread at a time.
+ */
+class SmtpClient : boost::noncopyable
+{
+public:
+  class Error : public std::runtime_error
+  {
+  public:
+    using std::runtime_error::runtime_error;
+  };
+
+  enum class Security {
+    NONE,
+    STARTTLS,
+    TLS,
+  };
+
+  struct Options
+  {
+    std::string server = "localhost";
+    std::string port = "25";
+    Security security = Security::NONE;
+    std::string username;
+    std::string password;
+    std::string mailFrom;
+    std::string subject;
+    /**
+     * @brief Body templates, where "{0}", "{1}", and "{2}" are replaced by the secret,
+     *        the CA prefix, and the certificate name; an empty HTML template sends plain text only.
+     */
+    std::string textTemplate;
+    std::string htmlTemplate;
+    /**
+     * @brief Maximum number of connections open at the same time.
+     */
+    size_t maxConnections = 4;
+    /**
+     * @brief Number of messages after which a connection is closed and replaced.
+     */
+    size_t maxMessagesPerConnection = 100;
+    /**
+     * @brief Time limit of each network operation.
+     */
+    time::milliseconds timeout = 10_s;
+  };
+
+  /**
+   * @brief Load the options from an INI file in the format of ndncert-mail.conf.
+   * @throw std::runtime_error the file cannot be read or a mandatory setting is missing.
+   */
+  static Options
+  loadOptions(const std::string& fileName);
+
+  explicit
+  SmtpClient(const Options& options);
+
+  ~SmtpClient();
+
+  /**
+   * @brief Deliver @p message, blocking until the server has accepted it.
+   * @throw Error the message is rejected or the connection fails.
+   */
+  void
+  send(const EmailDispatcher::Message& message);
+
+  /**
+   * @return number of connections currently open, idle or in use.
+   */
+  size_t
+  getConnectionCount() const;
+
+NDNCERT_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
+  std::string
+  formatMessage(const EmailDispatcher::Message& message) const;
+
+private:
+  class Connection;
+
+  std::unique_ptr<Connection>
+  acquireConnection();
+
+  void
+  releaseConnection(std::unique_ptr<Connection> connection, bool isReusable);
+
+private:
+  const Options m_options;
+  std::string m_envelopeFrom;
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_connectionReleased;
+  std::vector<std::unique_ptr<Connection>> m_idleConnections;
+  size_t m_nConnections = 0;
+};
+
+} // namespace ndncert
+
+#endif // NDNCERT_CHALLENGE_SMTP_CLIENT_HPP
@@ -0,0 +1,309 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2024, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+
+#include "challenge/verifier-client.hpp"
+
+#include <ndn-cxx/util/logger.hpp>
+
+#include <boost/asio/local/stream_protocol.hpp>
+#include <boost/asio/write.hpp>
+
+namespace ndncert::verifier {
+
+NDN_LOG_INIT(ndncert.challenge.verifier);
+
+namespace asio = boost::asio;
+using asio::local::stream_protocol;
+
+class VerifierClient::Connection : public std::enable_shared_from_this<Connection>
+{
+public:
+  Connection(asio::io_context& io, const std::string& socketPath)
+    : m_socket(io)
+    , m_endpoint(socketPath)
+  {
+  }
+
+  /**
+   * @brief Queue @p frame, connecting first if needed.
+   */
+  void
+  send(const Block& frame)
+  {
+    m_queue.push_back(frame);
+    if (m_state == State::IDLE) {
+      connect();
+    }
+    else if (m_state == State::CONNECTED) {
+      write();
+    }
+  }
+
+  /**
+   * @brief Close the socket without invoking the callbacks.
+   */
+  void
+  close()
+  {
+    onFrame = nullptr;
+    onFailure = nullptr;
+    m_state = State::CLOSED;
+    boost::system::error_code ec;
+    m_socket.close(ec);
+  }
+
+  bool
+  isClosed() const
+  {
+    return m_state == State::CLOSED;
+  }
+
+public:
+  std::function<void(const Block&)> onFrame;
+  std::function<void(const std::string&)> onFailure;
+
+private:
+  void
+  connect()
+  {
+    m_state = State::CONNECTING;
+    m_socket.async_connect(m_endpoint, [self = shared_from_this()] (const auto& ec) {
+      if (self->isClosed()) {
+        return;
+      }
+      if (ec) {
+        self->fail("cannot connect: " + ec.message());
+        return;
+      }
+      self->m_state = State::CONNECTED;
+      self->read();
+      self->write();
+    });
+  }
+
+  void
+  write()
+  {
+    if (m_isWriting || m_queue.empty()) {
+      return;
+    }
+    // pipelining: everything queued so far goes out in one write
+    m_isWriting = true;
+    m_sending.swap(m_queue);
+    std::vector<asio::const_buffer> buffers;
+    buffers.reserve(m_sending.size());
+    for (const auto& frame : m_sending) {
+      buffers.emplace_back(frame.data(), frame.size());
+    }
+    asio::async_write(m_socket, buffers, [self = shared_from_this()] (const auto& ec, size_t) {
+      self->m_isWriting = false;
+      self->m_sending.clear();
+      if (self->isClosed()) {
+        return;
+      }
+      if (ec) {
+        self->fail("cannot write: " + ec.message());
+        return;
+      }
+      self->write();
+    });
+  }
+
+  void
+  read()
+  {
+    auto buffer = asio::buffer(m_buffer.data() + m_bufferSize, m_buffer.size() - m_bufferSize);
+    m_socket.async_read_some(buffer, [self = shared_from_this()] (const auto& ec, size_t nBytes) {
+      if (self->isClosed()) {
+        return;
+      }
+      if (ec) {
+        self->fail(ec == asio::error::eof ? "closed by verifier" : "cannot read: " + ec.message());
+        return;
+      }
+      self->m_bufferSize += nBytes;
+      self->processFrames();
+    });
+  }
+
+  void
+  processFrames()
+  {
+    size_t offset = 0;
+    while (offset < m_bufferSize) {
+      auto [isOk, frame] = Block::fromBuffer(ndn::make_span(m_buffer.data() + offset,
+                                                               m_bufferSize - offset));
+      if (!isOk) {
+        break;
+      }
+      offset += frame.size();
+      if (onFrame) {
+        onFrame(frame);
+      }
+      if (isClosed()) {
+        return;
+      }
+    }
+    if (offset == 0 && m_bufferSize == m_buffer.size()) {
+      fail("frame too large");
+      return;
+    }
+    std::copy(m_buffer.begin() + offset, m_buffer.begin() + m_bufferSize, m_buffer.begin());
+    m_bufferSize -= offset;
+    read();
+  }
+
+  void
+  fail(const std::string& reason)
+  {
+    auto onFailureCallback = std::move(onFailure);
+    close();
+    if (onFailureCallback) {
+      onFailureCallback(reason);
+    }
+  }
+
+private:
+  enum class State {
+    IDLE,
+    CONNECTING,
+    CONNECTED,
+    CLOSED,
+  };
+
+  stream_protocol::socket m_socket;
+  stream_protocol::endpoint m_endpoint;
+  State m_state = State::IDLE;
+  std::vector<Block> m_queue;
+  std::vector<Block> m_sending;
+  bool m_isWriting = false;
+  std::array<uint8_t, ndn::MAX_NDN_PACKET_SIZE> m_buffer;
+  size_t m_bufferSize = 0;
+};
+
+VerifierClient::VerifierClient(asio::io_context& io, const Options& options)
+  : m_io(io)
+  , m_options(options)
+  , m_scheduler(io)
+{
+  if (options.nConnections == 0 || options.timeout <= 0_ms) {
+    NDN_THROW(std::invalid_argument("Verifier connections and timeout must be positive"));
+  }
+  m_connections.resize(options.nConnections);
+}
+
+VerifierClient::~VerifierClient()
+{
+  for (auto& connection : m_connections) {
+    if (connection != nullptr) {
+      connection->close();
+    }
+  }
+}
+
+void
+VerifierClient::call(Block request, ResponseCallback onResponse, ErrorCallback onError)
+{
+  auto callId = m_nextCallId++;
+  request.parse();
+  request.insert(request.elements_begin(), ndn::makeNonNegativeIntegerBlock(tlv::CallId, callId));
+  request.encode();
+
+  auto connection = getConnection();
+  auto& call = m_pendingCalls[callId];
+  call.connection = connection.get();
+  call.onResponse = std::move(onResponse);
+  call.onError = std::move(onError);
+  call.timeoutEvent = m_scheduler.schedule(m_options.timeout, [this, callId] {
+    failCall(callId, "timed out");
+  });
+  connection->send(request);
+}
+
+std::shared_ptr<VerifierClient::Connection>
+VerifierClient::getConnection()
+{
+  auto& connection = m_connections[m_nextConnection];
+  m_nextConnection = (m_nextConnection + 1) % m_connections.size();
+  if (connection == nullptr || connection->isClosed()) {
+    connection = std::make_shared<Connection>(m_io, m_options.socketPath);
+    connection->onFrame = [this] (const Block& frame) { onFrame(frame); };
+    connection->onFailure = [this, ptr = connection.get()] (const std::string& reason) {
+      onConnectionFailed(ptr, reason);
+    };
+  }
+  return connection;
+}
+
+void
+VerifierClient::onFrame(const Block& frame)
+{
+  uint64_t callId = 0;
+  try {
+    frame.parse();
+    if (frame.type() != tlv::VerifyResponse) {
+      NDN_THROW(ndn::tlv::Error("Unexpected frame type " + std::to_string(frame.type())));
+    }
+    callId = ndn::readNonNegativeInteger(frame.get(tlv::CallId));
+  }
+  catch (const std::exception& e) {
+    NDN_LOG_ERROR("Malformed frame from verifier: " << e.what());
+    return;
+  }
+
+  auto it = m_pendingCalls.find(callId);
+  if (it == m_pendingCalls.end()) {
+    NDN_LOG_DEBUG("Response to unknown or expired call " << callId);
+    return;
+  }
+  auto onResponse = std::move(it->second.onResponse);
+  m_pendingCalls.erase(it);
+  onResponse(frame);
+}
+
+void
+VerifierClient::onConnectionFailed(const Connection* connection, const std::string& reason)
+{
+  NDN_LOG_WARN("Connection to verifier " << m_options.socketPath << " failed: " << reason);
+  std::vector<uint64_t> failedCalls;
+  for (const auto& [callId, call] : m_pendingCalls) {
+    if (call.connection == connection) {
+      failedCalls.push_back(callId);
+    }
+  }
+  for (auto callId : failedCalls) {
+    failCall(callId, reason);
+  }
+}
+
+void
+VerifierClient::failCall(uint64_t callId, const std::string& reason)
+{
+  auto it = m_pendingCalls.find(callId);
+  if (it == m_pendingCalls.end()) {
+    return;
+  }
+  auto onError = std::move(it->second.onError);
+  m_pendingCalls.erase(it);
+  onError(reason);
+}
+
+} // namespace ndncert::verifier
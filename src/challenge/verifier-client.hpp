@@ -0,0 +1,170 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2024, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+
+#ifndef NDNCERT_CHALLENGE_VERIFIER_CLIENT_HPP
+#define NDNCERT_CHALLENGE_VERIFIER_CLIENT_HPP
+
+#include "detail/ndncert-common.hpp"
+
+#include <ndn-cxx/util/scheduler.hpp>
+
+#include <map>
+
+/**
+ * @file
+ *
+ * Protocol between the CA and an external challenge verifier.
+ *
+ * The verifier is a long-lived local process listening on a Unix stream socket. Each message
+ * is a single TLV element, so frames are delimited by their TLV length:
+ *
+ *     VerifyRequest = VERIFY-REQUEST-TYPE TLV-LENGTH
+ *                       CallId
+ *                       RequestId
+ *                       CaPrefix
+ *                       Name ; requested certificate name
+ *                       [ChallengeStatus] ; absent on the first step
+ *                       [VerifierState]
+ *                       *(ParameterKey ParameterValue)
+ *
+ *     VerifyResponse = VERIFY-RESPONSE-TYPE TLV-LENGTH
+ *                        CallId
+ *                        VerifyResult
+ *                        [ChallengeStatus] ; when the result is CONTINUE
+ *                        [RemainingTries]
+ *                        [RemainingTime]
+ *                        [VerifierState] ; returned in the next VerifyRequest of the request
+ *                        [ErrorInfo] ; when the result is FAILURE
+ *
+ * The CA may send several requests before reading the responses, and the verifier may answer
+ * them in any order; CallId matches responses to requests. CaPrefix, ParameterKey,
+ * ParameterValue, ChallengeStatus, RemainingTries, RemainingTime, ErrorInfo, and RequestId
+ * have the same types and encoding as in the NDNCERT protocol.
+ */
+
+namespace ndncert::verifier {
+
+namespace tlv {
+
+enum : uint32_t {
+  VerifyRequest = 231,
+  VerifyResponse = 233,
+  CallId = 235,
+  VerifyResult = 237,
+  VerifierState = 239,
+};
+
+} // namespace tlv
+
+enum class VerifyResult : uint64_t {
+  SUCCESS = 0,
+  CONTINUE = 1,
+  FAILURE = 2,
+};
+
+/**
+ * @brief Client of the external verifier protocol.
+ *
+ * Calls are spread over a fixed number of connections in turn, and pipelined on each
+ * connection. A connection is opened on first use, and opened again after a failure. All
+ * operations and callbacks run on the thread of the io_context.
+ */
+class VerifierClient : boost::noncopyable
+{
+public:
+  using ResponseCallback = std::function<void(const Block& response)>;
+  using ErrorCallback = std::function<void(const std::string& reason)>;
+
+  struct Options
+  {
+    std::string socketPath;
+    /**
+     * @brief Number of connections to the verifier.
+     */
+    size_t nConnections = 2;
+    /**
+     * @brief Time limit of each call.
+     */
+    time::milliseconds timeout = 5_s;
+  };
+
+public:
+  /**
+   * @throw std::invalid_argument the number of connections or the timeout is not positive.
+   */
+  VerifierClient(boost::asio::io_context& io, const Options& options);
+
+  /**
+   * @brief Close the connections; the callbacks of pending calls are not invoked.
+   */
+  ~VerifierClient();
+
+  /**
+   * @brief Send a VerifyRequest.
+   * @param request VerifyRequest without CallId, which is inserted first by this function.
+   * @param onResponse invoked with the VerifyResponse.
+   * @param onError invoked if the call times out or its connection fails.
+   */
+  void
+  call(Block request, ResponseCallback onResponse, ErrorCallback onError);
+
+  size_t
+  getPendingCallCount() const
+  {
+    return m_pendingCalls.size();
+  }
+
+private:
+  class Connection;
+
+  struct PendingCall
+  {
+    const Connection* connection;
+    ResponseCallback onResponse;
+    ErrorCallback onError;
+    ndn::scheduler::ScopedEventId timeoutEvent;
+  };
+
+  std::shared_ptr<Connection>
+  getConnection();
+
+  void
+  onFrame(const Block& frame);
+
+  void
+  onConnectionFailed(const Connection* connection, const std::string& reason);
+
+  void
+  failCall(uint64_t callId, const std::string& reason);
+
+private:
+  boost::asio::io_context& m_io;
+  const Options m_options;
+  ndn::Scheduler m_scheduler;
+  std::vector<std::shared_ptr<Connection>> m_connections;
+  size_t m_nextConnection = 0;
+  uint64_t m_nextCallId = 1;
+  std::map<uint64_t, PendingCall> m_pendingCalls;
+};
+
+} // namespace ndncert::verifier
+
+#endif // NDNCERT_CHALLENGE_VERIFIER_CLIENT_HPP
@@ -22,8 +22,11 @@
 
 #include <ndn-cxx/util/io.hpp>
 
+#include <boost/algorithm/string/case_conv.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
+#include <algorithm>
+
 namespace ndncert::ca {
 
 void
@@ -86,6 +89,63 @@ CaConfig::load(const std::string& fileName)
       nameAssignmentFuncs.push_back(std::move(func));
     }
   }
+
+  // parse error signing type if present
+  auto errorSigningStr = configJson.get(CONFIG_ERROR_SIGNING, "ca-key");
+  if (errorSigningStr == "ca-key") {
+    errorSigning = ErrorSigning::CA_KEY;
+  }
+  else if (errorSigningStr == "digest-sha256") {
+    errorSigning = ErrorSigning::DIGEST_SHA256;
+  }
+  else if (errorSigningStr == "session-hmac") {
+    errorSigning = ErrorSigning::SESSION_HMAC;
+  }
+  else {
+    NDN_THROW(std::runtime_error("Unrecognized error signing type: " + errorSigningStr));
+  }
+
+  // parse profile segment size if present
+  profileSegmentSize = configJson.get<size_t>(CONFIG_PROFILE_SEGMENT_SIZE, 0);
+
+  // parse whether NEW requests may carry a challenge step, if present
+  earlyChallenge = configJson.get(CONFIG_EARLY_CHALLENGE, false);
+
+  // parse the lifetime of resumption tickets, if present
+  resumptionTicketLifetime = time::seconds(configJson.get(CONFIG_RESUMPTION_TICKET_LIFETIME, 0));
+
+  // parse whether CHALLENGE responses may be signed with the session key, if present
+  sessionSigning = configJson.get(CONFIG_SESSION_SIGNING, false);
+
+  // parse challenge configurations if present
+  challengeConfigs.clear();
+  auto challengeConfigItem = configJson.get_child_optional(CONFIG_CHALLENGE_CONFIG);
+  if (challengeConfigItem) {
+    for (const auto& item : *challengeConfigItem) {
+      auto challengeType = boost::algorithm::to_lower_copy(item.first);
+      const auto& supported = caProfile.supportedChallenges;
+      if (std::find(supported.begin(), supported.end(), challengeType) == supported.end()) {
+        NDN_THROW(std::runtime_error("Challenge " + challengeType + " is configured but not supported."));
+      }
+      challengeConfigs[challengeType] = item.second;
+    }
+  }
+
+  // parse request scheduler section if present
+  schedulerOptions = {};
+  auto schedulerItem = configJson.get_child_optional(CONFIG_REQUEST_SCHEDULER);
+  if (schedulerItem) {
+    auto& options = schedulerOptions;
+    options.capacity = schedulerItem->get(CONFIG_QUEUE_CAPACITY, options.capacity);
+    auto& weights = options.weights;
+    weights[0] = schedulerItem->get(CONFIG_CHALLENGE_WEIGHT, weights[0]);
+    weights[1] = schedulerItem->get(CONFIG_NEW_WEIGHT, weights[1]);
+    weights[2] = schedulerItem->get(CONFIG_PROBE_WEIGHT, weights[2]);
+    weights[3] = schedulerItem->get(CONFIG_INFO_WEIGHT, weights[3]);
+    if (options.capacity == 0 || std::count(weights.begin(), weights.end(), 0) > 0) {
+      NDN_THROW(std::runtime_error("Request scheduler capacity and weights must be positive."));
+    }
+  }
 }
 
 } // namespace ndncert::ca
@@ -22,11 +22,41 @@
 #define NDNCERT_DETAIL_CA_CONFIGURATION_HPP
 
 #include "ca-profile.hpp"
+#include "detail/request-scheduler.hpp"
 #include "name-assignment/assignment-func.hpp"
 #include "redirection/redirection-policy.hpp"
 
+#include <map>
+
 namespace ndncert::ca {
 
+// used in parsing the CA-only sections of the CA configuration file
+const std::string CONFIG_REQUEST_SCHEDULER = "request-scheduler";
+const std::string CONFIG_QUEUE_CAPACITY = "queue-capacity";
+const std::string CONFIG_CHALLENGE_WEIGHT = "challenge-weight";
+const std::string CONFIG_NEW_WEIGHT = "new-weight";
+const std::string CONFIG_PROBE_WEIGHT = "probe-weight";
+const std::string CONFIG_INFO_WEIGHT = "info-weight";
+const std::string CONFIG_ERROR_SIGNING = "error-signing";
+const std::string CONFIG_PROFILE_SEGMENT_SIZE = "profile-segment-size";
+const std::string CONFIG_CHALLENGE_CONFIG = "challenge-config";
+const std::string CONFIG_EARLY_CHALLENGE = "early-challenge";
+const std::string CONFIG_RESUMPTION_TICKET_LIFETIME = "resumption-ticket-lifetime";
+const std::string CONFIG_SESSION_SIGNING = "session-signing";
+
+/**
+ * @brief How the CA signs Data packets that carry an error.
+ *
+ * A DigestSha256 or HMAC signature is orders of magnitude cheaper than an ECDSA one, at the cost
+ * of error responses outside a request session not being authenticated. A forged error can only
+ * abort a request, which an attacker on the path could also achieve by dropping packets.
+ */
+enum class ErrorSigning {
+  CA_KEY,        ///< with the CA's key, like any other response ("ca-key", the default)
+  DIGEST_SHA256, ///< with a DigestSha256 ("digest-sha256")
+  SESSION_HMAC,  ///< with the request session's HMAC key, DigestSha256 outside a session ("session-hmac")
+};
+
 /**
  * @brief CA's configuration on NDNCERT.
  *
@@ -45,7 +75,24 @@ namespace ndncert::ca {
  *  [
  *    {"challenge": ""},
  *    {"challenge": ""}
- *  ]
+ *  ],
+ *  "error-signing": "",
+ *  "profile-segment-size": "",
+ *  "early-challenge": "",
+ *  "resumption-ticket-lifetime": "",
+ *  "session-signing": "",
+ *  "challenge-config":
+ *  {
+ *    "<challenge type>": {"max-attempts": "", "secret-lifetime": "", ...}
+ *  },
+ *  "request-scheduler":
+ *  {
+ *    "queue-capacity": "",
+ *    "challenge-weight": "",
+ *    "new-weight": "",
+ *    "probe-weight": "",
+ *    "info-weight": ""
+ *  }
  * }
  */
 class CaConfig
@@ -71,6 +118,36 @@ public:
    * @brief Name Assignment Functions
    */
   std::vector<std::unique_ptr<NameAssignmentFunc>> nameAssignmentFuncs;
+  /**
+   * @brief Queue capacity and per-class weights of the request scheduler
+   */
+  RequestScheduler::Options schedulerOptions;
+  /**
+   * @brief How error responses are signed
+   */
+  ErrorSigning errorSigning = ErrorSigning::CA_KEY;
+  /**
+   * @brief Maximum content size of a CA profile segment, 0 to publish the profile in one Data
+   */
+  size_t profileSegmentSize = 0;
+  /**
+   * @brief Whether NEW requests may carry the first step of a challenge, encrypted to an ECDH
+   *        key published in the CA profile
+   */
+  bool earlyChallenge = false;
+  /**
+   * @brief Lifetime of the resumption tickets issued with certificates, 0 to issue no tickets
+   */
+  time::seconds resumptionTicketLifetime = 0_s;
+  /**
+   * @brief Whether intermediate CHALLENGE responses are signed with the session HMAC key for
+   *        requesters that accept it, instead of the CA key
+   */
+  bool sessionSigning = false;
+  /**
+   * @brief Configuration sections of the supported challenges, by challenge type
+   */
+  std::map<std::string, JsonSection> challengeConfigs;
 };
 
 } // namespace ndncert::ca
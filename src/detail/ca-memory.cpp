@@ -32,10 +32,20 @@ CaMemory::CaMemory(const Name&, const std::string&)
 
 RequestState
 CaMemory::getRequest(const RequestId& requestId)
+{
+  auto request = findRequest(requestId);
+  if (!request) {
+    NDN_THROW(std::runtime_error("Request " + ndn::toHex(requestId) + " does not exist"));
+  }
+  return std::move(*request);
+}
+
+std::optional<RequestState>
+CaMemory::findRequest(const RequestId& requestId)
 {
   auto it = m_requests.find(requestId);
   if (it == m_requests.end()) {
-    NDN_THROW(std::runtime_error("Request " + ndn::toHex(requestId) + " does not exist"));
+    return std::nullopt;
   }
   return it->second;
 }
@@ -83,4 +93,18 @@ CaMemory::listAllRequests(const Name& caName)
   return result;
 }
 
+bool
+CaMemory::addUsedToken(uint64_t nonce, const time::system_clock::time_point& expiry)
+{
+  if (m_usedTokens.size() >= m_pruneThreshold) {
+    // expired tokens are rejected before being looked up, so they can be forgotten
+    auto now = time::system_clock::now();
+    for (auto it = m_usedTokens.begin(); it != m_usedTokens.end();) {
+      it = it->second <= now ? m_usedTokens.erase(it) : std::next(it);
+    }
+    m_pruneThreshold = std::max<size_t>(1024, m_usedTokens.size() * 2);
+  }
+  return m_usedTokens.emplace(nonce, expiry).second;
+}
+
 } // namespace ndncert::ca
@@ -23,6 +23,8 @@
 
 #include "detail/ca-storage.hpp"
 
+#include <unordered_map>
+
 namespace ndncert::ca {
 
 class CaMemory : public CaStorage
@@ -37,6 +39,9 @@ public:
   RequestState
   getRequest(const RequestId& requestId) override;
 
+  std::optional<RequestState>
+  findRequest(const RequestId& requestId) override;
+
   void
   addRequest(const RequestState& request) override;
 
@@ -52,8 +57,16 @@ public:
   std::list<RequestState>
   listAllRequests(const Name& caName) override;
 
+  bool
+  addUsedToken(uint64_t nonce, const time::system_clock::time_point& expiry) override;
+
 private:
   std::map<RequestId, RequestState> m_requests;
+
+NDNCERT_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
+  // nonces of used tokens, with the expiry of the tokens
+  std::unordered_map<uint64_t, time::system_clock::time_point> m_usedTokens;
+  size_t m_pruneThreshold = 1024;
 };
 
 } // namespace ndncert::ca
@@ -99,6 +99,42 @@ public:
    * @brief CA's certificate. Only Client side will have m_cert.
    */
   std::shared_ptr<Certificate> cert;
+  /**
+   * @brief The CA's long-lived ECDH public key, to which a NEW request can encrypt the first
+   *        step of a challenge. Empty if the CA does not accept such requests.
+   *
+   * Only carried by the INFO packet, and not saved in the profile storage, since the key is
+   * replaced whenever the CA restarts.
+   */
+  std::vector<uint8_t> ecdhPub;
+  /**
+   * @brief Whether the CA accepts NEW requests carrying a certificate request in the compact
+   *        format, see requesttlv::encodeCompactCertRequest().
+   *
+   * Only carried by the INFO packet.
+   */
+  bool acceptsCompactCertRequest = false;
+  /**
+   * @brief The key agreement algorithms the CA accepts in NEW and REVOKE requests, in order of
+   *        preference. Empty if the CA only accepts P-256.
+   *
+   * Only carried by the INFO packet.
+   */
+  std::vector<KeyAgreement> keyAgreements;
+  /**
+   * @brief The AEAD algorithms the CA accepts for the encrypted payloads of a request session,
+   *        in order of preference. Empty if the CA only accepts AES-128-GCM.
+   *
+   * Only carried by the INFO packet.
+   */
+  std::vector<AeadAlgorithm> aeadAlgorithms;
+  /**
+   * @brief Whether the CA may sign error replies with a DigestSha256 instead of its key.
+   *
+   * A requester only accepts such error replies from a CA announcing this.
+   * Only carried by the INFO packet.
+   */
+  bool signsErrorsWithDigest = false;
 };
 
 } // namespace ndncert
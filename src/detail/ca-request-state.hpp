@@ -115,11 +115,19 @@ struct RequestState
    */
   std::array<uint8_t, 16> encryptionKey = {};
   /**
-   * @brief The last Initialization Vector used by the AES encryption.
+   * @brief The AEAD algorithm selected by the requester.
+   */
+  AeadAlgorithm aead = AeadAlgorithm::AES_128_GCM;
+  /**
+   * @brief The key of the AEAD algorithm, derived from the encryption key with deriveAeadKey().
+   */
+  std::array<uint8_t, 32> aeadKey = {};
+  /**
+   * @brief The last Initialization Vector used by the AEAD encryption.
    */
   std::vector<uint8_t> encryptionIv;
   /**
-   * @brief The last Initialization Vector used by the other side's AES encryption.
+   * @brief The last Initialization Vector used by the other side's AEAD encryption.
    */
   std::vector<uint8_t> decryptionIv;
   /**
@@ -19,6 +19,7 @@
  */
 
 #include "detail/ca-sqlite.hpp"
+#include "detail/crypto-helpers.hpp"
 
 #include <sqlite3.h>
 
@@ -53,6 +54,21 @@ convertString2Json(const std::string& jsonContent)
   return json;
 }
 
+/**
+ * @brief Load the AEAD key of @p state from @p column, or derive it for requests stored without one.
+ */
+static void
+loadAeadKey(RequestState& state, Sqlite3Statement& statement, int column)
+{
+  if (statement.getSize(column) == static_cast<int>(state.aeadKey.size())) {
+    std::memcpy(state.aeadKey.data(), statement.getBlob(column), state.aeadKey.size());
+  }
+  else {
+    state.aeadKey = deriveAeadKey(state.aead, state.encryptionKey.data(),
+                                  state.requestId.data(), state.requestId.size());
+  }
+}
+
 const std::string INITIALIZATION = R"SQL(
 CREATE TABLE IF NOT EXISTS
   RequestStates(
@@ -70,10 +86,19 @@ CREATE TABLE IF NOT EXISTS
     challenge_secrets TEXT,
     encryption_key BLOB NOT NULL,
     encryption_iv BLOB,
-    decryption_iv BLOB
+    decryption_iv BLOB,
+    aead INTEGER NOT NULL DEFAULT 0,
+    aead_key BLOB
   );
 CREATE UNIQUE INDEX IF NOT EXISTS
   RequestStateIdIndex ON RequestStates(request_id);
+CREATE TABLE IF NOT EXISTS
+  UsedTokens(
+    nonce INTEGER PRIMARY KEY,
+    expiry INTEGER NOT NULL
+  );
+CREATE INDEX IF NOT EXISTS
+  UsedTokenExpiryIndex ON UsedTokens(expiry);
 )SQL";
 
 CaSqlite::CaSqlite(const Name& caName, const std::string& path)
@@ -118,6 +143,29 @@ CaSqlite::CaSqlite(const Name& caName, const std::string& path)
     sqlite3_free(errorMessage);
     NDN_THROW(std::runtime_error("CaSqlite DB cannot be initialized"));
   }
+
+  // databases created before the AEAD algorithm became negotiable lack the AEAD columns
+  const std::pair<const char*, const char*> addedColumns[] = {
+    {"aead", "ALTER TABLE RequestStates ADD COLUMN aead INTEGER NOT NULL DEFAULT 0"},
+    {"aead_key", "ALTER TABLE RequestStates ADD COLUMN aead_key BLOB"},
+  };
+  for (const auto& [column, alteration] : addedColumns) {
+    bool hasColumn = true;
+    {
+      Sqlite3Statement statement(m_database,
+                                 R"_SQLTEXT_(SELECT COUNT(*) FROM pragma_table_info('RequestStates')
+                                 WHERE name = ?)_SQLTEXT_");
+      statement.bind(1, column, SQLITE_TRANSIENT);
+      hasColumn = statement.step() != SQLITE_ROW || statement.getInt(0) != 0;
+    }
+    if (!hasColumn) {
+      result = sqlite3_exec(m_database, alteration, nullptr, nullptr, &errorMessage);
+      if (result != SQLITE_OK) {
+        sqlite3_free(errorMessage);
+        NDN_THROW(std::runtime_error("CaSqlite DB cannot be upgraded"));
+      }
+    }
+  }
 }
 
 CaSqlite::~CaSqlite()
@@ -127,13 +175,23 @@ CaSqlite::~CaSqlite()
 
 RequestState
 CaSqlite::getRequest(const RequestId& requestId)
+{
+  auto request = findRequest(requestId);
+  if (!request) {
+    NDN_THROW(std::runtime_error("Request " + ndn::toHex(requestId) + " cannot be fetched from database"));
+  }
+  return std::move(*request);
+}
+
+std::optional<RequestState>
+CaSqlite::findRequest(const RequestId& requestId)
 {
   Sqlite3Statement statement(m_database,
                              R"_SQLTEXT_(SELECT id, ca_name, status,
                              challenge_status, cert_request,
                              challenge_type, challenge_secrets,
                              challenge_tp, remaining_tries, remaining_time,
-                             request_type, encryption_key, encryption_iv, decryption_iv
+                             request_type, encryption_key, encryption_iv, decryption_iv, aead, aead_key
                              FROM RequestStates where request_id = ?)_SQLTEXT_");
   statement.bind(1, requestId.data(), requestId.size(), SQLITE_TRANSIENT);
 
@@ -148,6 +206,8 @@ CaSqlite::getRequest(const RequestId& requestId)
     std::memcpy(state.encryptionKey.data(), statement.getBlob(11), statement.getSize(11));
     state.encryptionIv = std::vector<uint8_t>(statement.getBlob(12), statement.getBlob(12) + statement.getSize(12));
     state.decryptionIv = std::vector<uint8_t>(statement.getBlob(13), statement.getBlob(13) + statement.getSize(13));
+    state.aead = static_cast<AeadAlgorithm>(statement.getInt(14));
+    loadAeadKey(state, statement, 15);
     if (!state.challengeType.empty()) {
       ChallengeState challengeState(statement.getString(3), time::fromIsoString(statement.getString(7)),
                                     statement.getInt(8), time::seconds(statement.getInt(9)),
@@ -156,9 +216,7 @@ CaSqlite::getRequest(const RequestId& requestId)
     }
     return state;
   }
-  else {
-    NDN_THROW(std::runtime_error("Request " + ndn::toHex(requestId) + " cannot be fetched from database"));
-  }
+  return std::nullopt;
 }
 
 void
@@ -168,8 +226,9 @@ CaSqlite::addRequest(const RequestState& request)
       m_database,
       R"_SQLTEXT_(INSERT OR ABORT INTO RequestStates (request_id, ca_name, status, request_type,
                   cert_request, challenge_type, challenge_status, challenge_secrets,
-                  challenge_tp, remaining_tries, remaining_time, encryption_key, encryption_iv, decryption_iv)
-                  values (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?))_SQLTEXT_");
+                  challenge_tp, remaining_tries, remaining_time, encryption_key, encryption_iv, decryption_iv,
+                  aead, aead_key)
+                  values (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?))_SQLTEXT_");
   statement.bind(1, request.requestId.data(), request.requestId.size(), SQLITE_TRANSIENT);
   statement.bind(2, request.caPrefix.wireEncode(), SQLITE_TRANSIENT);
   statement.bind(3, static_cast<int>(request.status));
@@ -178,6 +237,8 @@ CaSqlite::addRequest(const RequestState& request)
   statement.bind(12, request.encryptionKey.data(), request.encryptionKey.size(), SQLITE_TRANSIENT);
   statement.bind(13, request.encryptionIv.data(), request.encryptionIv.size(), SQLITE_TRANSIENT);
   statement.bind(14, request.decryptionIv.data(), request.decryptionIv.size(), SQLITE_TRANSIENT);
+  statement.bind(15, static_cast<int>(request.aead));
+  statement.bind(16, request.aeadKey.data(), request.aeadKey.size(), SQLITE_TRANSIENT);
   if (request.challengeState) {
     statement.bind(6, request.challengeType, SQLITE_TRANSIENT);
     statement.bind(7, request.challengeState->challengeStatus, SQLITE_TRANSIENT);
@@ -232,7 +293,7 @@ CaSqlite::listAllRequests()
   Sqlite3Statement statement(m_database, R"_SQLTEXT_(SELECT id, request_id, ca_name, status,
                              challenge_status, cert_request, challenge_type, challenge_secrets,
                              challenge_tp, remaining_tries, remaining_time, request_type,
-                             encryption_key, encryption_iv, decryption_iv
+                             encryption_key, encryption_iv, decryption_iv, aead, aead_key
                              FROM RequestStates)_SQLTEXT_");
   while (statement.step() == SQLITE_ROW) {
     RequestState state;
@@ -245,6 +306,8 @@ CaSqlite::listAllRequests()
     std::memcpy(state.encryptionKey.data(), statement.getBlob(12), statement.getSize(12));
     state.encryptionIv = std::vector<uint8_t>(statement.getBlob(13), statement.getBlob(13) + statement.getSize(13));
     state.decryptionIv = std::vector<uint8_t>(statement.getBlob(14), statement.getBlob(14) + statement.getSize(14));
+    state.aead = static_cast<AeadAlgorithm>(statement.getInt(15));
+    loadAeadKey(state, statement, 16);
     if (state.challengeType != "") {
       ChallengeState challengeState(statement.getString(4), time::fromIsoString(statement.getString(8)),
                                     statement.getInt(9), time::seconds(statement.getInt(10)),
@@ -264,7 +327,7 @@ CaSqlite::listAllRequests(const Name& caName)
                              R"_SQLTEXT_(SELECT id, request_id, ca_name, status,
                              challenge_status, cert_request, challenge_type, challenge_secrets,
                              challenge_tp, remaining_tries, remaining_time, request_type,
-                             encryption_key, encryption_iv, decryption_iv
+                             encryption_key, encryption_iv, decryption_iv, aead, aead_key
                              FROM RequestStates WHERE ca_name = ?)_SQLTEXT_");
   statement.bind(1, caName.wireEncode(), SQLITE_TRANSIENT);
 
@@ -279,6 +342,8 @@ CaSqlite::listAllRequests(const Name& caName)
     std::memcpy(state.encryptionKey.data(), statement.getBlob(12), statement.getSize(12));
     state.encryptionIv = std::vector<uint8_t>(statement.getBlob(13), statement.getBlob(13) + statement.getSize(13));
     state.decryptionIv = std::vector<uint8_t>(statement.getBlob(14), statement.getBlob(14) + statement.getSize(14));
+    state.aead = static_cast<AeadAlgorithm>(statement.getInt(15));
+    loadAeadKey(state, statement, 16);
     if (!state.challengeType.empty()) {
       ChallengeState challengeState(statement.getString(4), time::fromIsoString(statement.getString(8)),
                                     statement.getInt(9), time::seconds(statement.getInt(10)),
@@ -299,4 +364,26 @@ CaSqlite::deleteRequest(const RequestId& requestId)
   statement.step();
 }
 
+bool
+CaSqlite::addUsedToken(uint64_t nonce, const time::system_clock::time_point& expiry)
+{
+  // expired tokens are rejected before being looked up, so they can be forgotten;
+  // the expiry index keeps this from scanning the unexpired ones
+  {
+    Sqlite3Statement statement(m_database, R"_SQLTEXT_(DELETE FROM UsedTokens WHERE expiry <= ?)_SQLTEXT_");
+    sqlite3_bind_int64(statement, 1, time::toUnixTimestamp(time::system_clock::now()).count());
+    statement.step();
+  }
+
+  Sqlite3Statement statement(m_database,
+                             R"_SQLTEXT_(INSERT OR IGNORE INTO UsedTokens (nonce, expiry)
+                             VALUES (?, ?))_SQLTEXT_");
+  sqlite3_bind_int64(statement, 1, static_cast<sqlite3_int64>(nonce));
+  sqlite3_bind_int64(statement, 2, time::toUnixTimestamp(expiry).count());
+  if (statement.step() != SQLITE_DONE) {
+    NDN_THROW(std::runtime_error("Used token cannot be added to the database"));
+  }
+  return sqlite3_changes(m_database) > 0;
+}
+
 } // namespace ndncert::ca
@@ -41,6 +41,9 @@ public:
   RequestState
   getRequest(const RequestId& requestId) override;
 
+  std::optional<RequestState>
+  findRequest(const RequestId& requestId) override;
+
   void
   addRequest(const RequestState& request) override;
 
@@ -56,6 +59,9 @@ public:
   std::list<RequestState>
   listAllRequests(const Name& caName) override;
 
+  bool
+  addUsedToken(uint64_t nonce, const time::system_clock::time_point& expiry) override;
+
 private:
   sqlite3* m_database;
 };
@@ -24,6 +24,7 @@
 #include "detail/ca-request-state.hpp"
 
 #include <map>
+#include <optional>
 
 namespace ndncert::ca {
 
@@ -39,6 +40,13 @@ public:
   virtual RequestState
   getRequest(const RequestId& requestId) = 0;
 
+  /**
+   * @brief Look up a request without throwing when it does not exist.
+   * @return the request, or std::nullopt if there is no request with @p requestId
+   */
+  virtual std::optional<RequestState>
+  findRequest(const RequestId& requestId) = 0;
+
   /**
    * @throw std::runtime_error There is an existing request with the same request ID
    */
@@ -57,6 +65,16 @@ public:
   virtual std::list<RequestState>
   listAllRequests(const Name& caName) = 0;
 
+  /**
+   * @brief Remember that the one-time token identified by @p nonce has been used.
+   *
+   * The token is remembered at least until @p expiry, after which it may be forgotten.
+   * @return false if @p nonce is already remembered.
+   * @throw std::runtime_error The token cannot be recorded in underlying data storage
+   */
+  virtual bool
+  addUsedToken(uint64_t nonce, const time::system_clock::time_point& expiry) = 0;
+
 public: // factory
   template<class CaStorageType>
   static void
@@ -23,7 +23,8 @@
 namespace ndncert::challengetlv {
 
 Block
-encodeDataContent(ca::RequestState& request, const Name& issuedCertName, const Name& forwardingHint)
+encodeDataContent(ca::RequestState& request, const Name& issuedCertName, const Name& forwardingHint,
+                  const Block& resumptionTicket, const Block& issuedCertificate)
 {
   Block response(tlv::EncryptedPayload);
   response.push_back(ndn::makeNonNegativeIntegerBlock(tlv::Status, static_cast<uint64_t>(request.status)));
@@ -43,21 +44,26 @@ encodeDataContent(ca::RequestState& request, const Name& issuedCertName, const N
     response.push_back(makeNestedBlock(tlv::IssuedCertName, issuedCertName));
     response.push_back(makeNestedBlock(ndn::tlv::ForwardingHint, forwardingHint));
   }
+  if (issuedCertificate.isValid()) {
+    response.push_back(issuedCertificate);
+  }
+  if (resumptionTicket.isValid()) {
+    response.push_back(resumptionTicket);
+  }
   response.encode();
 
-  return encodeBlockWithAesGcm128(ndn::tlv::Content, request.encryptionKey.data(),
-                                  response.value(), response.value_size(),
-                                  request.requestId.data(), request.requestId.size(),
-                                  request.encryptionIv);
+  return encodeBlockWithAead(request.aead, ndn::tlv::Content, request.aeadKey.data(),
+                             response.value(), response.value_size(),
+                             request.requestId.data(), request.requestId.size(),
+                             request.encryptionIv);
 }
 
 void
 decodeDataContent(const Block& contentBlock, requester::Request& state)
 {
-  auto result = decodeBlockWithAesGcm128(contentBlock, state.m_aesKey.data(),
-                                         state.m_requestId.data(), state.m_requestId.size(),
-                                         state.m_decryptionIv, state.m_encryptionIv);
-  auto data = ndn::makeBinaryBlock(tlv::EncryptedPayload, result);
+  auto data = decryptBlockWithAead(state.m_aead, contentBlock, tlv::EncryptedPayload, state.m_aeadKey.data(),
+                                   state.m_requestId.data(), state.m_requestId.size(),
+                                   state.m_decryptionIv, state.m_encryptionIv);
   data.parse();
 
   int numStatus = 0;
@@ -85,6 +91,12 @@ decodeDataContent(const Block& contentBlock, requester::Request& state)
         case ndn::tlv::ForwardingHint:
           state.m_forwardingHint = Name(item.blockFromValue());
           break;
+        case tlv::IssuedCertificate:
+          state.m_issuedCert = std::make_shared<Certificate>(item.blockFromValue());
+          break;
+        case tlv::ResumptionTicket:
+          state.m_resumptionTicket = item;
+          break;
         case tlv::ParameterKey:
           if (readString(item) == "nonce") {
             lookingForNonce = true;
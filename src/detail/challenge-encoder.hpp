@@ -26,9 +26,16 @@
 
 namespace ndncert::challengetlv {
 
+/**
+ * @param resumptionTicket A ResumptionTicket element issued with the certificate, or an invalid
+ *                         Block if the CA does not issue one.
+ * @param issuedCertificate An IssuedCertificate element carrying the issued certificate, or an
+ *                          invalid Block if the requester has to fetch it by name.
+ */
 Block
 encodeDataContent(ca::RequestState& request, const Name& issuedCertName = Name(),
-                  const Name& forwardingHint = Name());
+                  const Name& forwardingHint = Name(), const Block& resumptionTicket = Block(),
+                  const Block& issuedCertificate = Block());
 
 void
 decodeDataContent(const Block& contentBlock, requester::Request& state);
@@ -0,0 +1,109 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2024, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+
+#include "detail/counting-bloom-filter.hpp"
+
+#include <ndn-cxx/util/random.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace ndncert {
+
+CountingBloomFilter::CountingBloomFilter(size_t nCounters, size_t nHashes)
+  : m_nHashes(nHashes)
+  , m_salt(ndn::random::generateSecureWord64())
+{
+  if (nCounters == 0 || nHashes == 0) {
+    NDN_THROW(std::invalid_argument("Bloom filter size and number of hashes must be positive"));
+  }
+  size_t size = 1;
+  while (size < nCounters) {
+    size <<= 1;
+  }
+  m_counters.resize(size);
+  m_mask = size - 1;
+}
+
+template<typename Function>
+void
+CountingBloomFilter::forEachPosition(ndn::span<const uint8_t> item, const Function& f) const
+{
+  // salted FNV-1a, split into two halves for double hashing
+  uint64_t hash = 14695981039346656037ULL ^ m_salt;
+  for (auto byte : item) {
+    hash ^= byte;
+    hash *= 1099511628211ULL;
+  }
+  hash ^= hash >> 29;
+  hash *= 0xbf58476d1ce4e5b9ULL;
+  hash ^= hash >> 32;
+
+  uint64_t h1 = hash & 0xffffffff;
+  uint64_t h2 = (hash >> 32) | 1;
+  for (size_t i = 0; i < m_nHashes; ++i) {
+    f(static_cast<size_t>(h1 + i * h2) & m_mask);
+  }
+}
+
+void
+CountingBloomFilter::insert(ndn::span<const uint8_t> item)
+{
+  forEachPosition(item, [this] (size_t pos) {
+    if (m_counters[pos] < std::numeric_limits<uint8_t>::max()) {
+      ++m_counters[pos];
+    }
+  });
+  ++m_size;
+}
+
+void
+CountingBloomFilter::erase(ndn::span<const uint8_t> item)
+{
+  forEachPosition(item, [this] (size_t pos) {
+    // a saturated counter no longer knows how many items it counts
+    if (m_counters[pos] > 0 && m_counters[pos] < std::numeric_limits<uint8_t>::max()) {
+      --m_counters[pos];
+    }
+  });
+  if (m_size > 0) {
+    --m_size;
+  }
+}
+
+bool
+CountingBloomFilter::mayContain(ndn::span<const uint8_t> item) const
+{
+  bool result = true;
+  forEachPosition(item, [&] (size_t pos) {
+    result = result && m_counters[pos] > 0;
+  });
+  return result;
+}
+
+void
+CountingBloomFilter::clear()
+{
+  std::fill(m_counters.begin(), m_counters.end(), 0);
+  m_size = 0;
+}
+
+} // namespace ndncert
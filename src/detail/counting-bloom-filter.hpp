@@ -0,0 +1,92 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2024, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+
+#ifndef NDNCERT_DETAIL_COUNTING_BLOOM_FILTER_HPP
+#define NDNCERT_DETAIL_COUNTING_BLOOM_FILTER_HPP
+
+#include "detail/ndncert-common.hpp"
+
+#include <vector>
+
+namespace ndncert {
+
+/**
+ * @brief A counting Bloom filter over byte strings.
+ *
+ * Membership tests have no false negatives, but may have false positives. Unlike a plain Bloom
+ * filter, items can be removed. A counter that saturates is never decremented again, which
+ * only makes false positives more likely.
+ *
+ * Positions are computed from a hash seeded with a random salt, so that a remote party cannot
+ * craft items that collide with the inserted ones.
+ */
+class CountingBloomFilter
+{
+public:
+  /**
+   * @param nCounters Number of counters, rounded up to a power of two.
+   * @param nHashes Number of counters an item maps to.
+   */
+  explicit
+  CountingBloomFilter(size_t nCounters = 65536, size_t nHashes = 4);
+
+  void
+  insert(ndn::span<const uint8_t> item);
+
+  /**
+   * @brief Remove an item previously inserted.
+   *
+   * Removing an item that has not been inserted corrupts the filter.
+   */
+  void
+  erase(ndn::span<const uint8_t> item);
+
+  /**
+   * @return false if @p item has definitely not been inserted.
+   */
+  bool
+  mayContain(ndn::span<const uint8_t> item) const;
+
+  void
+  clear();
+
+  size_t
+  size() const
+  {
+    return m_size;
+  }
+
+private:
+  template<typename Function>
+  void
+  forEachPosition(ndn::span<const uint8_t> item, const Function& f) const;
+
+private:
+  std::vector<uint8_t> m_counters;
+  size_t m_mask;
+  size_t m_nHashes;
+  uint64_t m_salt;
+  size_t m_size = 0;
+};
+
+} // namespace ndncert
+
+#endif // NDNCERT_DETAIL_COUNTING_BLOOM_FILTER_HPP
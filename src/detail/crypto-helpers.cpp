@@ -25,176 +25,432 @@
 #include <ndn-cxx/encoding/buffer-stream.hpp>
 #include <ndn-cxx/security/transform/base64-decode.hpp>
 #include <ndn-cxx/security/transform/base64-encode.hpp>
+#include <ndn-cxx/security/transform/bool-sink.hpp>
 #include <ndn-cxx/security/transform/buffer-source.hpp>
+#include <ndn-cxx/security/transform/private-key.hpp>
+#include <ndn-cxx/security/transform/signer-filter.hpp>
 #include <ndn-cxx/security/transform/stream-sink.hpp>
+#include <ndn-cxx/security/transform/verifier-filter.hpp>
 #include <ndn-cxx/util/random.hpp>
 
 #include <openssl/ec.h>
 #include <openssl/err.h>
 #include <openssl/hmac.h>
-#include <openssl/kdf.h>
 #include <openssl/pem.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+#endif
 
+#include <algorithm>
 #include <cstring>
 
 namespace ndncert {
 
+namespace {
+
+/**
+ * @brief The prime256v1 group parameters, generated once per process and shared by every
+ *        ECDHState, both to generate keys and to load peer keys.
+ */
+class P256Parameters : boost::noncopyable
+{
+public:
+  P256Parameters()
+  {
+    EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+    if (ctx == nullptr || EVP_PKEY_paramgen_init(ctx) <= 0 ||
+        EVP_PKEY_CTX_set_ec_paramgen_curve_nid(ctx, NID_X9_62_prime256v1) <= 0 ||
+        EVP_PKEY_paramgen(ctx, &m_params) <= 0) {
+      m_params = nullptr;
+    }
+    EVP_PKEY_CTX_free(ctx);
+  }
+
+  ~P256Parameters()
+  {
+    EVP_PKEY_free(m_params);
+  }
+
+  EVP_PKEY*
+  get() const
+  {
+    if (m_params == nullptr) {
+      NDN_THROW(std::runtime_error("Cannot generate the prime256v1 parameters"));
+    }
+    return m_params;
+  }
+
+private:
+  EVP_PKEY* m_params = nullptr;
+};
+
+EVP_PKEY*
+getP256Parameters()
+{
+  static const P256Parameters params;
+  return params.get();
+}
+
+} // namespace
+
 ECDHState::ECDHState()
+  : ECDHState(KeyAgreement::P256)
 {
-  auto EC_NID = NID_X9_62_prime256v1;
-  // params context
-  EVP_PKEY_CTX* ctx_params = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
-  EVP_PKEY_paramgen_init(ctx_params);
-  EVP_PKEY_CTX_set_ec_paramgen_curve_nid(ctx_params, EC_NID);
-  // generate params
-  EVP_PKEY* params = nullptr;
-  EVP_PKEY_paramgen(ctx_params, &params);
-  // key generation context
-  EVP_PKEY_CTX* ctx_keygen = EVP_PKEY_CTX_new(params, nullptr);
-  EVP_PKEY_keygen_init(ctx_keygen);
-  auto resultCode = EVP_PKEY_keygen(ctx_keygen, &m_privkey);
-  EVP_PKEY_CTX_free(ctx_keygen);
-  EVP_PKEY_free(params);
-  EVP_PKEY_CTX_free(ctx_params);
+}
+
+ECDHState::ECDHState(KeyAgreement algorithm)
+  : m_algorithm(algorithm)
+{
+  EVP_PKEY_CTX* ctx = nullptr;
+  if (m_algorithm == KeyAgreement::X25519) {
+    ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_X25519, nullptr);
+  }
+  else if (m_algorithm == KeyAgreement::P256) {
+    ctx = EVP_PKEY_CTX_new(getP256Parameters(), nullptr);
+  }
+  else {
+    NDN_THROW(std::invalid_argument("Unsupported key agreement algorithm"));
+  }
+  auto resultCode = ctx == nullptr ? 0 : EVP_PKEY_keygen_init(ctx);
+  if (resultCode > 0) {
+    resultCode = EVP_PKEY_keygen(ctx, &m_privkey);
+  }
+  EVP_PKEY_CTX_free(ctx);
   if (resultCode <= 0) {
     NDN_THROW(std::runtime_error("Error in initiating ECDH"));
   }
-}
 
-ECDHState::~ECDHState()
-{
-  if (m_privkey != nullptr) {
+  // the public key is sent in every request, so it is encoded only once; the encoding is the
+  // uncompressed point for prime256v1 and the raw key for X25519
+  uint8_t* pubKey = nullptr;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  auto pubKeyLen = EVP_PKEY_get1_encoded_public_key(m_privkey, &pubKey);
+#else
+  auto pubKeyLen = EVP_PKEY_get1_tls_encodedpoint(m_privkey, &pubKey);
+#endif
+  if (pubKeyLen == 0) {
     EVP_PKEY_free(m_privkey);
+    NDN_THROW(std::runtime_error("Error in encoding the ECDH public key"));
   }
+  m_pubKey.assign(pubKey, pubKey + pubKeyLen);
+  OPENSSL_free(pubKey);
 }
 
-const std::vector <uint8_t>&
-ECDHState::getSelfPubKey()
+ECDHState::~ECDHState()
 {
-  auto privECKey = EVP_PKEY_get1_EC_KEY(m_privkey);
-  auto ecPoint = EC_KEY_get0_public_key(privECKey);
-  auto group = EC_KEY_get0_group(privECKey);
-  auto requiredBufLen = EC_POINT_point2oct(group, ecPoint, POINT_CONVERSION_UNCOMPRESSED, nullptr, 0, nullptr);
-  m_pubKey.resize(requiredBufLen);
-  auto resultCode = EC_POINT_point2oct(group, ecPoint, POINT_CONVERSION_UNCOMPRESSED,
-                                       m_pubKey.data(), requiredBufLen, nullptr);
-  EC_KEY_free(privECKey);
-  if (resultCode == 0) {
-    NDN_THROW(std::runtime_error("Error in getting EC Public Key in the format of octet string"));
-  }
-  return m_pubKey;
+  EVP_PKEY_CTX_free(m_deriveCtx);
+  EVP_PKEY_free(m_privkey);
 }
 
 const std::vector<uint8_t>&
-ECDHState::deriveSecret(const std::vector <uint8_t>& peerKey)
-{
-  // prepare self private key
-  auto privECKey = EVP_PKEY_get1_EC_KEY(m_privkey);
-  auto group = EC_KEY_get0_group(privECKey);
-  EC_KEY_free(privECKey);
-  // prepare the peer public key
-  auto peerPoint = EC_POINT_new(group);
-  EC_POINT_oct2point(group, peerPoint, peerKey.data(), peerKey.size(), nullptr);
-  EC_KEY* ecPeerkey = EC_KEY_new();
-  EC_KEY_set_group(ecPeerkey, group);
-  EC_KEY_set_public_key(ecPeerkey, peerPoint);
-  EVP_PKEY* evpPeerkey = EVP_PKEY_new();
-  EVP_PKEY_set1_EC_KEY(evpPeerkey, ecPeerkey);
-  EC_KEY_free(ecPeerkey);
-  EC_POINT_free(peerPoint);
-  // ECDH context
-  EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new(m_privkey, nullptr);
-  // Initialize
-  EVP_PKEY_derive_init(ctx);
-  // Provide the peer public key
-  EVP_PKEY_derive_set_peer(ctx, evpPeerkey);
-  // Determine buffer length for shared secret
-  size_t secretLen = 0;
-  EVP_PKEY_derive(ctx, nullptr, &secretLen);
+ECDHState::deriveSecret(ndn::span<const uint8_t> peerKey)
+{
+  EVP_PKEY* evpPeerkey = nullptr;
+  if (m_algorithm == KeyAgreement::X25519) {
+    if (peerKey.size() != 32) {
+      NDN_THROW(std::runtime_error("Invalid X25519 public key size"));
+    }
+    evpPeerkey = EVP_PKEY_new_raw_public_key(EVP_PKEY_X25519, nullptr, peerKey.data(), peerKey.size());
+  }
+  else {
+    // the peer key shares the group parameters of the own key; setting the encoded point
+    // rejects points that are not on the curve
+    evpPeerkey = EVP_PKEY_new();
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    if (evpPeerkey != nullptr &&
+        (EVP_PKEY_copy_parameters(evpPeerkey, m_privkey) != 1 ||
+         EVP_PKEY_set1_encoded_public_key(evpPeerkey, peerKey.data(), peerKey.size()) != 1)) {
+#else
+    if (evpPeerkey != nullptr &&
+        (EVP_PKEY_copy_parameters(evpPeerkey, m_privkey) != 1 ||
+         EVP_PKEY_set1_tls_encodedpoint(evpPeerkey, peerKey.data(), peerKey.size()) != 1)) {
+#endif
+      EVP_PKEY_free(evpPeerkey);
+      evpPeerkey = nullptr;
+    }
+  }
+  if (evpPeerkey == nullptr) {
+    NDN_THROW(std::runtime_error("Cannot load the peer public key"));
+  }
+
+  if (m_deriveCtx == nullptr) {
+    m_deriveCtx = EVP_PKEY_CTX_new(m_privkey, nullptr);
+  }
+  // both prime256v1 and X25519 secrets are 32 bytes long;
+  // OpenSSL rejects low-order X25519 peer keys, which would yield an all-zero secret
+  size_t secretLen = 32;
   m_secret.resize(secretLen);
-  // Derive the shared secret
-  auto resultCode = EVP_PKEY_derive(ctx, m_secret.data(), &secretLen);
-  EVP_PKEY_CTX_free(ctx);
+  auto resultCode = m_deriveCtx == nullptr ? 0 : EVP_PKEY_derive_init(m_deriveCtx);
+  if (resultCode > 0) {
+    resultCode = EVP_PKEY_derive_set_peer(m_deriveCtx, evpPeerkey);
+  }
+  if (resultCode > 0) {
+    resultCode = EVP_PKEY_derive(m_deriveCtx, m_secret.data(), &secretLen);
+  }
   EVP_PKEY_free(evpPeerkey);
-  if (resultCode == 0) {
+  if (resultCode <= 0 || secretLen != m_secret.size()) {
     NDN_THROW(std::runtime_error("Error when calling ECDH"));
   }
   return m_secret;
+}
+
+namespace {
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+
+/**
+ * @brief The OpenSSL algorithm implementations, fetched once per process.
+ *
+ * Initializing a context with EVP_aes_128_gcm() and the like fetches the implementation from
+ * the provider again on every call.
+ */
+struct Algorithms : boost::noncopyable
+{
+  Algorithms()
+    : aes128Gcm(EVP_CIPHER_fetch(nullptr, "AES-128-GCM", nullptr))
+    , chacha20Poly1305(EVP_CIPHER_fetch(nullptr, "ChaCha20-Poly1305", nullptr))
+    , hmac(EVP_MAC_fetch(nullptr, "HMAC", nullptr))
+  {
+  }
+
+  ~Algorithms()
+  {
+    EVP_CIPHER_free(aes128Gcm);
+    EVP_CIPHER_free(chacha20Poly1305);
+    EVP_MAC_free(hmac);
+  }
+
+  EVP_CIPHER* aes128Gcm;
+  EVP_CIPHER* chacha20Poly1305;
+  EVP_MAC* hmac;
+};
+
+using HmacContext = EVP_MAC_CTX;
+
+#else
 
-//  // prepare self private key
-//  auto privECKey = EVP_PKEY_get1_EC_KEY(m_privkey);
-//  if (privECKey == nullptr) {
-//    NDN_THROW(std::runtime_error("Cannot not get key when calling EVP_PKEY_get1_EC_KEY()"));
-//  }
-//  auto group = EC_KEY_get0_group(privECKey);
-//  EC_KEY_free(privECKey);
-//  // prepare the peer public key
-//  auto peerPoint = EC_POINT_new(group);
-//  if (peerPoint == nullptr) {
-//    NDN_THROW(std::runtime_error("Cannot create the EC_POINT for peer key when calling EC_POINT_new()"));
-//  }
-//  if (EC_POINT_oct2point(group, peerPoint, peerKey.data(), peerKey.size(), nullptr) == 0) {
-//    EC_POINT_free(peerPoint);
-//    NDN_THROW(std::runtime_error("Cannot convert peer's key into a EC point when calling EC_POINT_oct2point()"));
-//  }
-//  EC_KEY* ecPeerkey = EC_KEY_new();
-//  if (ecPeerkey == nullptr) {
-//    EC_POINT_free(peerPoint);
-//    NDN_THROW(std::runtime_error("Cannot create EC_KEY for peer key when calling EC_KEY_new()"));
-//  }
-//  if (EC_KEY_set_group(ecPeerkey, group) != 1) {
-//    EC_POINT_free(peerPoint);
-//    NDN_THROW(std::runtime_error("Cannot set group for peer key's EC_KEY when calling EC_KEY_set_group()"));
-//  }
-//  if (EC_KEY_set_public_key(ecPeerkey, peerPoint) == 0) {
-//    EC_KEY_free(ecPeerkey);
-//    EC_POINT_free(peerPoint);
-//    NDN_THROW(
-//      std::runtime_error("Cannot initialize peer EC_KEY with the EC_POINT when calling EC_KEY_set_public_key()"));
-//  }
-//  EVP_PKEY* evpPeerkey = EVP_PKEY_new();
-//  if (EVP_PKEY_set1_EC_KEY(evpPeerkey, ecPeerkey) == 0) {
-//    EC_KEY_free(ecPeerkey);
-//    EC_POINT_free(peerPoint);
-//    NDN_THROW(std::runtime_error("Cannot create EVP_PKEY for peer key when calling EVP_PKEY_new()"));
-//  }
-//  EC_KEY_free(ecPeerkey);
-//  EC_POINT_free(peerPoint);
-//  // ECDH context
-//  EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new(m_privkey, nullptr);
-//  if (ctx == nullptr) {
-//    EVP_PKEY_free(evpPeerkey);
-//    NDN_THROW(std::runtime_error("Cannot create context for ECDH when calling EVP_PKEY_CTX_new()"));
-//  }
-//  // Initialize
-//  if (1 != EVP_PKEY_derive_init(ctx)) {
-//    EVP_PKEY_CTX_free(ctx);
-//    EVP_PKEY_free(evpPeerkey);
-//    NDN_THROW(std::runtime_error("Cannot initialize context for ECDH when calling EVP_PKEY_derive_init()"));
-//  }
-//  // Provide the peer public key
-//  if (1 != EVP_PKEY_derive_set_peer(ctx, evpPeerkey)) {
-//    EVP_PKEY_CTX_free(ctx);
-//    EVP_PKEY_free(evpPeerkey);
-//    NDN_THROW(std::runtime_error("Cannot set peer key for ECDH when calling EVP_PKEY_derive_set_peer()"));
-//  }
-//  // Determine buffer length for shared secret
-//  size_t secretLen = 0;
-//  if (1 != EVP_PKEY_derive(ctx, nullptr, &secretLen)) {
-//    EVP_PKEY_CTX_free(ctx);
-//    EVP_PKEY_free(evpPeerkey);
-//    NDN_THROW(std::runtime_error("Cannot determine the needed buffer length when calling EVP_PKEY_derive()"));
-//  }
-//  m_secret.resize(secretLen);
-//  // Derive the shared secret
-//  if (1 != (EVP_PKEY_derive(ctx, m_secret.data(), &secretLen))) {
-//    EVP_PKEY_CTX_free(ctx);
-//    EVP_PKEY_free(evpPeerkey);
-//    NDN_THROW(std::runtime_error("Cannot derive ECDH secret when calling EVP_PKEY_derive()"));
-//  }
-//  EVP_PKEY_CTX_free(ctx);
-//  EVP_PKEY_free(evpPeerkey);
-//  return m_secret;
+struct Algorithms
+{
+  const EVP_CIPHER* aes128Gcm = EVP_aes_128_gcm();
+  const EVP_CIPHER* chacha20Poly1305 = EVP_chacha20_poly1305();
+  const EVP_MD* sha256 = EVP_sha256();
+};
+
+using HmacContext = HMAC_CTX;
+
+#endif // OPENSSL_VERSION_NUMBER >= 0x30000000L
+
+const Algorithms&
+getAlgorithms()
+{
+  static const Algorithms algorithms;
+  return algorithms;
+}
+
+HmacContext*
+newHmacContext()
+{
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  auto mac = getAlgorithms().hmac;
+  EVP_MAC_CTX* ctx = mac == nullptr ? nullptr : EVP_MAC_CTX_new(mac);
+  OSSL_PARAM params[] = {
+    OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, const_cast<char*>("SHA256"), 0),
+    OSSL_PARAM_construct_end(),
+  };
+  if (ctx != nullptr && EVP_MAC_CTX_set_params(ctx, params) != 1) {
+    EVP_MAC_CTX_free(ctx);
+    ctx = nullptr;
+  }
+#else
+  HMAC_CTX* ctx = HMAC_CTX_new();
+#endif
+  if (ctx == nullptr) {
+    NDN_THROW(std::runtime_error("Cannot create the HMAC context"));
+  }
+  return ctx;
+}
+
+void
+freeHmacContext(HmacContext* ctx)
+{
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  EVP_MAC_CTX_free(ctx);
+#else
+  HMAC_CTX_free(ctx);
+#endif
+}
+
+/**
+ * @brief Start an HMAC computation.
+ * @param key The HMAC key, or nullptr to keep the key of the previous computation.
+ */
+void
+hmacInit(HmacContext* ctx, const uint8_t* key, size_t keyLen)
+{
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  auto resultCode = EVP_MAC_init(ctx, key, keyLen, nullptr);
+#else
+  auto resultCode = HMAC_Init_ex(ctx, key, keyLen, key == nullptr ? nullptr : getAlgorithms().sha256, nullptr);
+#endif
+  if (resultCode != 1) {
+    NDN_THROW(std::runtime_error("Error computing HMAC"));
+  }
+}
+
+void
+hmacUpdate(HmacContext* ctx, const uint8_t* data, size_t dataLen)
+{
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  auto resultCode = EVP_MAC_update(ctx, data, dataLen);
+#else
+  auto resultCode = HMAC_Update(ctx, data, dataLen);
+#endif
+  if (resultCode != 1) {
+    NDN_THROW(std::runtime_error("Error computing HMAC"));
+  }
+}
+
+void
+hmacFinal(HmacContext* ctx, uint8_t* result)
+{
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  size_t resultLen = 0;
+  auto resultCode = EVP_MAC_final(ctx, result, &resultLen, 32);
+#else
+  unsigned int resultLen = 0;
+  auto resultCode = HMAC_Final(ctx, result, &resultLen);
+#endif
+  if (resultCode != 1) {
+    NDN_THROW(std::runtime_error("Error computing HMAC"));
+  }
+}
+
+/**
+ * @brief The OpenSSL contexts of a thread, created on first use and reused by all its
+ *        computations.
+ *
+ * Cipher contexts are initialized with their cipher once, so that each operation only sets
+ * the key and the IV.
+ */
+class ThreadContexts : boost::noncopyable
+{
+public:
+  ~ThreadContexts()
+  {
+    EVP_CIPHER_CTX_free(m_aes128Gcm);
+    EVP_CIPHER_CTX_free(m_chacha20Poly1305);
+    freeHmacContext(m_hmac);
+  }
+
+  EVP_CIPHER_CTX*
+  getCipher(AeadAlgorithm algorithm)
+  {
+    bool isAes = algorithm == AeadAlgorithm::AES_128_GCM;
+    auto& ctx = isAes ? m_aes128Gcm : m_chacha20Poly1305;
+    if (ctx == nullptr) {
+      auto cipher = isAes ? getAlgorithms().aes128Gcm : getAlgorithms().chacha20Poly1305;
+      ctx = EVP_CIPHER_CTX_new();
+      if (ctx == nullptr || cipher == nullptr ||
+          EVP_CipherInit_ex(ctx, cipher, nullptr, nullptr, nullptr, 1) != 1) {
+        EVP_CIPHER_CTX_free(ctx);
+        ctx = nullptr;
+        NDN_THROW(std::runtime_error("Cannot create the cipher context"));
+      }
+    }
+    return ctx;
+  }
+
+  HmacContext*
+  getHmac()
+  {
+    if (m_hmac == nullptr) {
+      m_hmac = newHmacContext();
+    }
+    return m_hmac;
+  }
+
+private:
+  EVP_CIPHER_CTX* m_aes128Gcm = nullptr;
+  EVP_CIPHER_CTX* m_chacha20Poly1305 = nullptr;
+  HmacContext* m_hmac = nullptr;
+};
+
+ThreadContexts&
+getThreadContexts()
+{
+  thread_local ThreadContexts contexts;
+  return contexts;
+}
+
+const char*
+getAeadName(AeadAlgorithm algorithm)
+{
+  return algorithm == AeadAlgorithm::AES_128_GCM ? "AES GCM" : "ChaCha20-Poly1305";
+}
+
+size_t
+aeadEncrypt(AeadAlgorithm algorithm, const uint8_t* plaintext, size_t plaintextLen,
+            const uint8_t* associated, size_t associatedLen, const uint8_t* key, const uint8_t* iv,
+            uint8_t* ciphertext, uint8_t* tag)
+{
+  auto ctx = getThreadContexts().getCipher(algorithm);
+  int len = 0;
+  int finalLen = 0;
+  if (EVP_EncryptInit_ex(ctx, nullptr, nullptr, key, iv) != 1 ||
+      EVP_EncryptUpdate(ctx, nullptr, &len, associated, associatedLen) != 1 ||
+      EVP_EncryptUpdate(ctx, ciphertext, &len, plaintext, plaintextLen) != 1 ||
+      EVP_EncryptFinal_ex(ctx, ciphertext + len, &finalLen) != 1 ||
+      EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, 16, tag) != 1) {
+    NDN_THROW(std::runtime_error(std::string("Error in encryption plaintext with ") + getAeadName(algorithm)));
+  }
+  return len + finalLen;
+}
+
+size_t
+aeadDecrypt(AeadAlgorithm algorithm, const uint8_t* ciphertext, size_t ciphertextLen,
+            const uint8_t* associated, size_t associatedLen, const uint8_t* tag,
+            const uint8_t* key, const uint8_t* iv, uint8_t* plaintext)
+{
+  auto ctx = getThreadContexts().getCipher(algorithm);
+  int len = 0;
+  int finalLen = 0;
+  if (EVP_DecryptInit_ex(ctx, nullptr, nullptr, key, iv) != 1 ||
+      EVP_DecryptUpdate(ctx, nullptr, &len, associated, associatedLen) != 1 ||
+      EVP_DecryptUpdate(ctx, plaintext, &len, ciphertext, ciphertextLen) != 1 ||
+      EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG, 16, const_cast<uint8_t*>(tag)) != 1 ||
+      EVP_DecryptFinal_ex(ctx, plaintext + len, &finalLen) != 1) {
+    NDN_THROW(std::runtime_error(std::string("Error in decrypting ciphertext with ") + getAeadName(algorithm)));
+  }
+  return len + finalLen;
+}
+
+} // namespace
+
+KeyedHmacSha256::KeyedHmacSha256(const uint8_t* key, size_t keyLen)
+  : m_ctx(newHmacContext())
+{
+  static const uint8_t emptyKey = 0;
+  try {
+    hmacInit(m_ctx, key == nullptr ? &emptyKey : key, keyLen);
+  }
+  catch (const std::runtime_error&) {
+    freeHmacContext(m_ctx);
+    throw;
+  }
+}
+
+KeyedHmacSha256::~KeyedHmacSha256()
+{
+  freeHmacContext(m_ctx);
+}
+
+void
+KeyedHmacSha256::compute(const uint8_t* data, size_t dataLen, uint8_t* result)
+{
+  hmacInit(m_ctx, nullptr, 0);
+  hmacUpdate(m_ctx, data, dataLen);
+  hmacFinal(m_ctx, result);
 }
 
 void
@@ -202,10 +458,11 @@ hmacSha256(const uint8_t* data, size_t dataLen,
            const uint8_t* key, size_t keyLen,
            uint8_t* result)
 {
-  auto ret = HMAC(EVP_sha256(), key, keyLen, data, dataLen, result, nullptr);
-  if (ret == nullptr) {
-    NDN_THROW(std::runtime_error("Error computing HMAC when calling HMAC()"));
-  }
+  static const uint8_t emptyKey = 0;
+  auto ctx = getThreadContexts().getHmac();
+  hmacInit(ctx, key == nullptr ? &emptyKey : key, keyLen);
+  hmacUpdate(ctx, data, dataLen);
+  hmacFinal(ctx, result);
 }
 
 size_t
@@ -213,153 +470,71 @@ hkdf(const uint8_t* secret, size_t secretLen, const uint8_t* salt,
      size_t saltLen, uint8_t* output, size_t outputLen,
      const uint8_t* info, size_t infoLen)
 {
-  EVP_PKEY_CTX* pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, nullptr);
-  EVP_PKEY_derive_init(pctx);
-  EVP_PKEY_CTX_set_hkdf_md(pctx, EVP_sha256());
-  EVP_PKEY_CTX_set1_hkdf_salt(pctx, salt, saltLen);
-  EVP_PKEY_CTX_set1_hkdf_key(pctx, secret, secretLen);
-  EVP_PKEY_CTX_add1_hkdf_info(pctx, info, infoLen);
-  size_t outLen = outputLen;
-  auto resultCode = EVP_PKEY_derive(pctx, output, &outLen);
-  EVP_PKEY_CTX_free(pctx);
-  if (resultCode == 0) {
-    NDN_THROW(std::runtime_error("Error when calling HKDF"));
-  }
-  return outLen;
-
-//  if (EVP_PKEY_derive_init(pctx) <= 0) {
-//    EVP_PKEY_CTX_free(pctx);
-//    NDN_THROW(std::runtime_error("HKDF: Cannot init ctx when calling EVP_PKEY_derive_init()"));
-//  }
-//  if (EVP_PKEY_CTX_set_hkdf_md(pctx, EVP_sha256()) <= 0) {
-//    EVP_PKEY_CTX_free(pctx);
-//    NDN_THROW(std::runtime_error("HKDF: Cannot set md when calling EVP_PKEY_CTX_set_hkdf_md()"));
-//  }
-//  if (EVP_PKEY_CTX_set1_hkdf_salt(pctx, salt, saltLen) <= 0) {
-//    EVP_PKEY_CTX_free(pctx);
-//    NDN_THROW(std::runtime_error("HKDF: Cannot set salt when calling EVP_PKEY_CTX_set1_hkdf_salt()"));
-//  }
-//  if (EVP_PKEY_CTX_set1_hkdf_key(pctx, secret, secretLen) <= 0) {
-//    EVP_PKEY_CTX_free(pctx);
-//    NDN_THROW(std::runtime_error("HKDF: Cannot set secret when calling EVP_PKEY_CTX_set1_hkdf_key()"));
-//  }
-//  if (EVP_PKEY_CTX_add1_hkdf_info(pctx, info, infoLen) <= 0) {
-//    EVP_PKEY_CTX_free(pctx);
-//    NDN_THROW(std::runtime_error("HKDF: Cannot set info when calling EVP_PKEY_CTX_add1_hkdf_info()"));
-//  }
-//  size_t outLen = outputLen;
-//  if (EVP_PKEY_derive(pctx, output, &outLen) <= 0) {
-//    EVP_PKEY_CTX_free(pctx);
-//    NDN_THROW(std::runtime_error("HKDF: Cannot derive result when calling EVP_PKEY_derive()"));
-//  }
+  // HKDF-SHA256 (RFC 5869) on the HMAC context of the thread, so that a derivation does not
+  // create and configure a KDF context
+  if (outputLen > 255 * 32) {
+    NDN_THROW(std::runtime_error("Error when calling HKDF: the output is too long"));
+  }
+  static const uint8_t zeroSalt[32] = {};
+  if (saltLen == 0) {
+    salt = zeroSalt;
+    saltLen = sizeof(zeroSalt);
+  }
+  auto ctx = getThreadContexts().getHmac();
+  uint8_t prk[32];
+  hmacInit(ctx, salt, saltLen);
+  hmacUpdate(ctx, secret, secretLen);
+  hmacFinal(ctx, prk);
+
+  uint8_t block[32];
+  for (size_t offset = 0, i = 1; offset < outputLen; offset += sizeof(block), ++i) {
+    uint8_t counter = static_cast<uint8_t>(i);
+    hmacInit(ctx, prk, sizeof(prk));
+    if (i > 1) {
+      hmacUpdate(ctx, block, sizeof(block));
+    }
+    hmacUpdate(ctx, info, infoLen);
+    hmacUpdate(ctx, &counter, 1);
+    hmacFinal(ctx, block);
+    std::memcpy(output + offset, block, std::min(sizeof(block), outputLen - offset));
+  }
+  OPENSSL_cleanse(prk, sizeof(prk));
+  OPENSSL_cleanse(block, sizeof(block));
+  return outputLen;
 }
 
 size_t
 aesGcm128Encrypt(const uint8_t* plaintext, size_t plaintextLen, const uint8_t* associated, size_t associatedLen,
                  const uint8_t* key, const uint8_t* iv, uint8_t* ciphertext, uint8_t* tag)
 {
-  int len = 0;
-  size_t ciphertextLen = 0;
-  EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
-  EVP_EncryptInit_ex(ctx, EVP_aes_128_gcm(), nullptr, nullptr, nullptr);
-  EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_IVLEN, 12, nullptr);
-  EVP_EncryptInit_ex(ctx, nullptr, nullptr, key, iv);
-  EVP_EncryptUpdate(ctx, nullptr, &len, associated, associatedLen);
-  EVP_EncryptUpdate(ctx, ciphertext, &len, plaintext, plaintextLen);
-  ciphertextLen = len;
-  EVP_EncryptFinal_ex(ctx, ciphertext + len, &len);
-  auto resultCode = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, 16, tag);
-  EVP_CIPHER_CTX_free(ctx);
-  if (resultCode == 0) {
-    NDN_THROW(std::runtime_error("Error in encryption plaintext with AES GCM"));
-  }
-  return ciphertextLen;
-
-//  if (!(ctx = EVP_CIPHER_CTX_new())) {
-//    NDN_THROW(std::runtime_error("Cannot create and initialise the context when calling EVP_CIPHER_CTX_new()"));
-//  }
-//  if (1 != EVP_EncryptInit_ex(ctx, EVP_aes_128_gcm(), nullptr, nullptr, nullptr)) {
-//    EVP_CIPHER_CTX_free(ctx);
-//    NDN_THROW(std::runtime_error("Cannot initialize the encryption operation when calling EVP_EncryptInit_ex()"));
-//  }
-//  if (1 != EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_IVLEN, 12, nullptr)) {
-//    EVP_CIPHER_CTX_free(ctx);
-//    NDN_THROW(std::runtime_error("Cannot set IV length when calling EVP_CIPHER_CTX_ctrl()"));
-//  }
-//  if (1 != EVP_EncryptInit_ex(ctx, nullptr, nullptr, key, iv)) {
-//    EVP_CIPHER_CTX_free(ctx);
-//    NDN_THROW(std::runtime_error("Cannot initialize key and IV when calling EVP_EncryptInit_ex()"));
-//  }
-//  if (1 != EVP_EncryptUpdate(ctx, nullptr, &len, associated, associatedLen)) {
-//    EVP_CIPHER_CTX_free(ctx);
-//    NDN_THROW(std::runtime_error("Cannot set associated authentication data when calling EVP_EncryptUpdate()"));
-//  }
-//  if (1 != EVP_EncryptUpdate(ctx, ciphertext, &len, plaintext, plaintextLen)) {
-//    EVP_CIPHER_CTX_free(ctx);
-//    NDN_THROW(std::runtime_error("Cannot encrypt when calling EVP_EncryptUpdate()"));
-//  }
-//  ciphertextLen = len;
-//  if (1 != EVP_EncryptFinal_ex(ctx, ciphertext + len, &len)) {
-//    EVP_CIPHER_CTX_free(ctx);
-//    NDN_THROW(std::runtime_error("Cannot finalise the encryption when calling EVP_EncryptFinal_ex()"));
-//  }
-//  ciphertextLen += len;
-//  if (1 != EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, 16, tag)) {
-//    EVP_CIPHER_CTX_free(ctx);
-//    NDN_THROW(std::runtime_error("Cannot get tag when calling EVP_CIPHER_CTX_ctrl()"));
-//  }
+  return aeadEncrypt(AeadAlgorithm::AES_128_GCM, plaintext, plaintextLen, associated, associatedLen,
+                     key, iv, ciphertext, tag);
 }
 
 size_t
 aesGcm128Decrypt(const uint8_t* ciphertext, size_t ciphertextLen, const uint8_t* associated, size_t associatedLen,
                  const uint8_t* tag, const uint8_t* key, const uint8_t* iv, uint8_t* plaintext)
 {
-  int len = 0;
-  size_t plaintextLen = 0;
-  EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
-  EVP_DecryptInit_ex(ctx, EVP_aes_128_gcm(), nullptr, nullptr, nullptr);
-  EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_IVLEN, 12, nullptr);
-  EVP_DecryptInit_ex(ctx, nullptr, nullptr, key, iv);
-  EVP_DecryptUpdate(ctx, nullptr, &len, associated, associatedLen);
-  EVP_DecryptUpdate(ctx, plaintext, &len, ciphertext, ciphertextLen);
-  plaintextLen = len;
-  EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, 16, const_cast<void*>(reinterpret_cast<const void*>(tag)));
-  auto resultCode = EVP_DecryptFinal_ex(ctx, plaintext + len, &len);
-  plaintextLen += len;
-  EVP_CIPHER_CTX_free(ctx);
-  if (resultCode == 0) {
-    NDN_THROW(std::runtime_error("Error in decrypting ciphertext with AES GCM"));
-  }
-  return plaintextLen;
-
-//  if (!(ctx = EVP_CIPHER_CTX_new())) {
-//    NDN_THROW(std::runtime_error("Cannot create and initialise the context when calling EVP_CIPHER_CTX_new()"));
-//  }
-//  if (!EVP_DecryptInit_ex(ctx, EVP_aes_128_gcm(), nullptr, nullptr, nullptr)) {
-//    EVP_CIPHER_CTX_free(ctx);
-//    NDN_THROW(std::runtime_error("Cannot initialise the decryption operation when calling EVP_DecryptInit_ex()"));
-//  }
-//  if (!EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_IVLEN, 12, nullptr)) {
-//    EVP_CIPHER_CTX_free(ctx);
-//    NDN_THROW(std::runtime_error("Cannot set IV length when calling EVP_CIPHER_CTX_ctrl"));
-//  }
-//  if (!EVP_DecryptInit_ex(ctx, nullptr, nullptr, key, iv)) {
-//    EVP_CIPHER_CTX_free(ctx);
-//    NDN_THROW(std::runtime_error("Cannot initialise key and IV when calling EVP_DecryptInit_ex()"));
-//  }
-//  if (!EVP_DecryptUpdate(ctx, nullptr, &len, associated, associatedLen)) {
-//    EVP_CIPHER_CTX_free(ctx);
-//    NDN_THROW(std::runtime_error("Cannot set associated authentication data when calling EVP_EncryptUpdate()"));
-//  }
-//  if (!EVP_DecryptUpdate(ctx, plaintext, &len, ciphertext, ciphertextLen)) {
-//    EVP_CIPHER_CTX_free(ctx);
-//    NDN_THROW(std::runtime_error("Cannot decrypt when calling EVP_DecryptUpdate()"));
-//  }
-//  plaintextLen = len;
-//  if (!EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, 16, const_cast<void*>(reinterpret_cast<const void*>(tag)))) {
-//    EVP_CIPHER_CTX_free(ctx);
-//    NDN_THROW(std::runtime_error("Cannot set tag value when calling EVP_CIPHER_CTX_ctrl()"));
-//  }
+  return aeadDecrypt(AeadAlgorithm::AES_128_GCM, ciphertext, ciphertextLen, associated, associatedLen,
+                     tag, key, iv, plaintext);
+}
+
+size_t
+chacha20Poly1305Encrypt(const uint8_t* plaintext, size_t plaintextLen, const uint8_t* associated,
+                        size_t associatedLen, const uint8_t* key, const uint8_t* iv,
+                        uint8_t* ciphertext, uint8_t* tag)
+{
+  return aeadEncrypt(AeadAlgorithm::CHACHA20_POLY1305, plaintext, plaintextLen, associated, associatedLen,
+                     key, iv, ciphertext, tag);
+}
+
+size_t
+chacha20Poly1305Decrypt(const uint8_t* ciphertext, size_t ciphertextLen, const uint8_t* associated,
+                        size_t associatedLen, const uint8_t* tag, const uint8_t* key, const uint8_t* iv,
+                        uint8_t* plaintext)
+{
+  return aeadDecrypt(AeadAlgorithm::CHACHA20_POLY1305, ciphertext, ciphertextLen, associated, associatedLen,
+                     tag, key, iv, plaintext);
 }
 
 static uint32_t
@@ -389,6 +564,25 @@ encodeBlockWithAesGcm128(uint32_t tlvType, const uint8_t* key,
                          const uint8_t* payload, size_t payloadSize,
                          const uint8_t* associatedData, size_t associatedDataSize,
                          std::vector<uint8_t>& encryptionIv)
+{
+  return encodeBlockWithAead(AeadAlgorithm::AES_128_GCM, tlvType, key, payload, payloadSize,
+                             associatedData, associatedDataSize, encryptionIv);
+}
+
+ndn::Buffer
+decodeBlockWithAesGcm128(const Block& block, const uint8_t* key,
+                         const uint8_t* associatedData, size_t associatedDataSize,
+                         std::vector<uint8_t>& decryptionIv, const std::vector<uint8_t>& encryptionIv)
+{
+  return decodeBlockWithAead(AeadAlgorithm::AES_128_GCM, block, key, associatedData, associatedDataSize,
+                             decryptionIv, encryptionIv);
+}
+
+Block
+encodeBlockWithAead(AeadAlgorithm algorithm, uint32_t tlvType, const uint8_t* key,
+                    const uint8_t* payload, size_t payloadSize,
+                    const uint8_t* associatedData, size_t associatedDataSize,
+                    std::vector<uint8_t>& encryptionIv)
 {
   // The spec of AES encrypted payload TLV used in NDNCERT:
   //   https://github.com/named-data/ndncert/wiki/NDNCERT-Protocol-0.3#242-aes-gcm-encryption
@@ -399,8 +593,19 @@ encodeBlockWithAesGcm128(uint32_t tlvType, const uint8_t* key,
   }
 
   uint8_t tag[16];
-  size_t encryptedPayloadLen = aesGcm128Encrypt(payload, payloadSize, associatedData, associatedDataSize,
-                                                key, encryptionIv.data(), encryptedPayload.data(), tag);
+  size_t encryptedPayloadLen = 0;
+  switch (algorithm) {
+    case AeadAlgorithm::AES_128_GCM:
+      encryptedPayloadLen = aesGcm128Encrypt(payload, payloadSize, associatedData, associatedDataSize,
+                                             key, encryptionIv.data(), encryptedPayload.data(), tag);
+      break;
+    case AeadAlgorithm::CHACHA20_POLY1305:
+      encryptedPayloadLen = chacha20Poly1305Encrypt(payload, payloadSize, associatedData, associatedDataSize,
+                                                    key, encryptionIv.data(), encryptedPayload.data(), tag);
+      break;
+    default:
+      NDN_THROW(std::runtime_error("Unknown AEAD algorithm " + std::to_string(static_cast<uint64_t>(algorithm))));
+  }
 
   Block content(tlvType);
   content.push_back(ndn::makeBinaryBlock(tlv::InitializationVector, encryptionIv));
@@ -413,46 +618,219 @@ encodeBlockWithAesGcm128(uint32_t tlvType, const uint8_t* key,
   return content;
 }
 
-ndn::Buffer
-decodeBlockWithAesGcm128(const Block& block, const uint8_t* key,
-                         const uint8_t* associatedData, size_t associatedDataSize,
-                         std::vector<uint8_t>& decryptionIv, const std::vector<uint8_t>& encryptionIv)
+/**
+ * @brief Check the IV and the tag of an AEAD encrypted block, and advance @p decryptionIv to
+ *        its IV.
+ * @return The EncryptedPayload element of @p block.
+ */
+static const Block&
+checkAeadBlock(AeadAlgorithm algorithm, const Block& block,
+               std::vector<uint8_t>& decryptionIv, const std::vector<uint8_t>& encryptionIv)
 {
+  if (algorithm != AeadAlgorithm::AES_128_GCM && algorithm != AeadAlgorithm::CHACHA20_POLY1305) {
+    NDN_THROW(std::runtime_error("Unknown AEAD algorithm " + std::to_string(static_cast<uint64_t>(algorithm))));
+  }
   // The spec of AES encrypted payload TLV used in NDNCERT:
   //   https://github.com/named-data/ndncert/wiki/NDNCERT-Protocol-0.3#242-aes-gcm-encryption
   block.parse();
-  const auto& encryptedPayloadBlock = block.get(tlv::EncryptedPayload);
-  ndn::Buffer result(encryptedPayloadBlock.value_size());
-  if (block.get(tlv::InitializationVector).value_size() != 12 ||
+  const auto& ivBlock = block.get(tlv::InitializationVector);
+  if (ivBlock.value_size() != 12 ||
       block.get(tlv::AuthenticationTag).value_size() != 16) {
     NDN_THROW(std::runtime_error("Error when decrypting the AES Encrypted Block: "
                                  "The observed IV or Authentication Tag is of an unexpected size."));
   }
-  std::vector<uint8_t> observedDecryptionIv(block.get(tlv::InitializationVector).value(),
-                                            block.get(tlv::InitializationVector).value() + 12);
+  const uint8_t* observedDecryptionIv = ivBlock.value();
   if (!encryptionIv.empty()) {
-    if (std::equal(observedDecryptionIv.begin(), observedDecryptionIv.begin() + 8, encryptionIv.begin())) {
+    if (std::equal(observedDecryptionIv, observedDecryptionIv + 8, encryptionIv.begin())) {
       NDN_THROW(std::runtime_error("Error when decrypting the AES Encrypted Block: "
                                    "The observed IV's the random component should be different from ours."));
     }
   }
   if (!decryptionIv.empty()) {
     if (loadBigU32(&observedDecryptionIv[8]) < loadBigU32(&decryptionIv[8]) ||
-        !std::equal(observedDecryptionIv.begin(), observedDecryptionIv.begin() + 8, decryptionIv.begin())) {
+        !std::equal(observedDecryptionIv, observedDecryptionIv + 8, decryptionIv.begin())) {
       NDN_THROW(std::runtime_error("Error when decrypting the AES Encrypted Block: "
                                    "The observed IV's counter should be monotonically increasing "
                                    "and the random component must be the same from the requester."));
     }
   }
-  decryptionIv = observedDecryptionIv;
-  auto resultLen = aesGcm128Decrypt(encryptedPayloadBlock.value(), encryptedPayloadBlock.value_size(),
-                                    associatedData, associatedDataSize, block.get(tlv::AuthenticationTag).value(),
-                                    key, decryptionIv.data(), result.data());
+  decryptionIv.assign(observedDecryptionIv, observedDecryptionIv + 12);
+  return block.get(tlv::EncryptedPayload);
+}
+
+/**
+ * @brief Decrypt the payload of a block checked by checkAeadBlock() into @p plaintext, which
+ *        must be as large as the encrypted payload.
+ */
+static void
+decryptAeadPayload(AeadAlgorithm algorithm, const Block& block, const uint8_t* key,
+                   const uint8_t* associatedData, size_t associatedDataSize,
+                   std::vector<uint8_t>& decryptionIv, uint8_t* plaintext)
+{
+  const auto& encryptedPayloadBlock = block.get(tlv::EncryptedPayload);
+  size_t resultLen = 0;
+  if (algorithm == AeadAlgorithm::CHACHA20_POLY1305) {
+    resultLen = chacha20Poly1305Decrypt(encryptedPayloadBlock.value(), encryptedPayloadBlock.value_size(),
+                                        associatedData, associatedDataSize,
+                                        block.get(tlv::AuthenticationTag).value(),
+                                        key, decryptionIv.data(), plaintext);
+  }
+  else {
+    resultLen = aesGcm128Decrypt(encryptedPayloadBlock.value(), encryptedPayloadBlock.value_size(),
+                                 associatedData, associatedDataSize, block.get(tlv::AuthenticationTag).value(),
+                                 key, decryptionIv.data(), plaintext);
+  }
   if (resultLen != encryptedPayloadBlock.value_size()) {
     NDN_THROW(std::runtime_error("Error when decrypting the AES Encrypted Block: "
                                  "Decrypted payload is of an unexpected size."));
   }
   updateIv(decryptionIv, resultLen);
+}
+
+ndn::Buffer
+decodeBlockWithAead(AeadAlgorithm algorithm, const Block& block, const uint8_t* key,
+                    const uint8_t* associatedData, size_t associatedDataSize,
+                    std::vector<uint8_t>& decryptionIv, const std::vector<uint8_t>& encryptionIv)
+{
+  const auto& encryptedPayloadBlock = checkAeadBlock(algorithm, block, decryptionIv, encryptionIv);
+  ndn::Buffer result(encryptedPayloadBlock.value_size());
+  decryptAeadPayload(algorithm, block, key, associatedData, associatedDataSize, decryptionIv, result.data());
+  return result;
+}
+
+/**
+ * @brief Write @p number as a TLV VAR-NUMBER at @p pos.
+ * @return The position following the VAR-NUMBER.
+ */
+static uint8_t*
+writeVarNumber(uint8_t* pos, uint64_t number)
+{
+  using boost::endian::order;
+  if (number < 253) {
+    *pos = static_cast<uint8_t>(number);
+    return pos + 1;
+  }
+  if (number <= std::numeric_limits<uint16_t>::max()) {
+    *pos = 253;
+    boost::endian::endian_store<uint16_t, 2, order::big>(pos + 1, static_cast<uint16_t>(number));
+    return pos + 3;
+  }
+  if (number <= std::numeric_limits<uint32_t>::max()) {
+    *pos = 254;
+    boost::endian::endian_store<uint32_t, 4, order::big>(pos + 1, static_cast<uint32_t>(number));
+    return pos + 5;
+  }
+  *pos = 255;
+  boost::endian::endian_store<uint64_t, 8, order::big>(pos + 1, number);
+  return pos + 9;
+}
+
+Block
+decryptBlockWithAead(AeadAlgorithm algorithm, const Block& block, uint32_t tlvType, const uint8_t* key,
+                     const uint8_t* associatedData, size_t associatedDataSize,
+                     std::vector<uint8_t>& decryptionIv, const std::vector<uint8_t>& encryptionIv)
+{
+  const auto& encryptedPayloadBlock = checkAeadBlock(algorithm, block, decryptionIv, encryptionIv);
+  // AEAD ciphertexts are as long as their plaintexts, so the TLV header can be written first
+  auto payloadSize = encryptedPayloadBlock.value_size();
+  auto buffer = std::make_shared<ndn::Buffer>(ndn::tlv::sizeOfVarNumber(tlvType) +
+                                              ndn::tlv::sizeOfVarNumber(payloadSize) + payloadSize);
+  auto value = writeVarNumber(writeVarNumber(buffer->data(), tlvType), payloadSize);
+  decryptAeadPayload(algorithm, block, key, associatedData, associatedDataSize, decryptionIv, value);
+  return Block(std::move(buffer));
+}
+
+std::array<uint8_t, 32>
+deriveAeadKey(AeadAlgorithm algorithm, const uint8_t* sessionKey, const uint8_t* salt, size_t saltLen)
+{
+  std::array<uint8_t, 32> key{};
+  switch (algorithm) {
+    case AeadAlgorithm::AES_128_GCM:
+      std::copy_n(sessionKey, 16, key.begin());
+      break;
+    case AeadAlgorithm::CHACHA20_POLY1305: {
+      static const std::string info = "NDNCERT ChaCha20-Poly1305";
+      hkdf(sessionKey, 16, salt, saltLen, key.data(), key.size(),
+           reinterpret_cast<const uint8_t*>(info.data()), info.size());
+      break;
+    }
+    default:
+      NDN_THROW(std::runtime_error("Unknown AEAD algorithm " + std::to_string(static_cast<uint64_t>(algorithm))));
+  }
+  return key;
+}
+
+std::array<uint8_t, 32>
+deriveSessionHmacKey(const uint8_t* aesKey, size_t aesKeyLen,
+                     const uint8_t* requestId, size_t requestIdLen)
+{
+  static const std::string info = "NDNCERT session HMAC";
+  std::array<uint8_t, 32> hmacKey;
+  hkdf(aesKey, aesKeyLen, requestId, requestIdLen, hmacKey.data(), hmacKey.size(),
+       reinterpret_cast<const uint8_t*>(info.data()), info.size());
+  return hmacKey;
+}
+
+std::array<uint8_t, 16>
+deriveEarlyChallengeKey(const uint8_t* sharedSecret, size_t sharedSecretLen,
+                        const uint8_t* requesterPub, size_t requesterPubLen)
+{
+  static const std::string info = "NDNCERT early challenge";
+  std::array<uint8_t, 16> aesKey;
+  hkdf(sharedSecret, sharedSecretLen, requesterPub, requesterPubLen, aesKey.data(), aesKey.size(),
+       reinterpret_cast<const uint8_t*>(info.data()), info.size());
+  return aesKey;
+}
+
+std::array<uint8_t, 32>
+deriveResumptionSecret(const uint8_t* aesKey, size_t aesKeyLen,
+                       const uint8_t* requestId, size_t requestIdLen)
+{
+  static const std::string info = "NDNCERT resumption";
+  std::array<uint8_t, 32> secret;
+  hkdf(aesKey, aesKeyLen, requestId, requestIdLen, secret.data(), secret.size(),
+       reinterpret_cast<const uint8_t*>(info.data()), info.size());
+  return secret;
+}
+
+void
+signDataWithHmacSha256(Data& data, const uint8_t* key, size_t keyLen, const Name& keyName)
+{
+  namespace tr = ndn::security::transform;
+
+  data.setSignatureInfo(SignatureInfo(ndn::tlv::SignatureHmacWithSha256, ndn::KeyLocator(keyName)));
+  // placeholder, so that the signed portion can be encoded
+  data.setSignatureValue(std::make_shared<ndn::Buffer>(32));
+  data.wireEncode();
+
+  tr::PrivateKey hmacKey;
+  hmacKey.loadRaw(ndn::KeyType::HMAC, {key, keyLen});
+  ndn::OBufferStream os;
+  tr::bufferSource(data.extractSignedRanges()) >>
+    tr::signerFilter(ndn::DigestAlgorithm::SHA256, hmacKey) >>
+    tr::streamSink(os);
+  data.setSignatureValue(os.buf());
+}
+
+bool
+verifyDataWithHmacSha256(const Data& data, const uint8_t* key, size_t keyLen)
+{
+  namespace tr = ndn::security::transform;
+
+  if (data.getSignatureType() != ndn::tlv::SignatureHmacWithSha256) {
+    return false;
+  }
+  bool result = false;
+  try {
+    tr::PrivateKey hmacKey;
+    hmacKey.loadRaw(ndn::KeyType::HMAC, {key, keyLen});
+    tr::bufferSource(data.extractSignedRanges()) >>
+      tr::verifierFilter(ndn::DigestAlgorithm::SHA256, hmacKey, data.getSignatureValue().value_bytes()) >>
+      tr::boolSink(result);
+  }
+  catch (const std::exception&) {
+    return false;
+  }
   return result;
 }
 
@@ -25,41 +25,64 @@
 
 #include <openssl/evp.h>
 
+#include <array>
+
 namespace ndncert {
 
 /**
  * @brief State for ECDH.
  *
- * The ECDH is based on prime256v1.
+ * The ECDH is based on prime256v1 by default, or on X25519, which is several times faster and
+ * has 32-byte public keys.
  */
 class ECDHState : boost::noncopyable
 {
 public:
   ECDHState();
 
+  explicit
+  ECDHState(KeyAgreement algorithm);
+
   ~ECDHState();
 
   /**
    * @brief Derive ECDH secret from peer's EC public key and self's private key.
    *
-   * @param peerkey Peer's EC public key in the uncompressed octet string format.
+   * @param peerkey Peer's EC public key in the uncompressed octet string format, or the raw
+   *                32-byte public key for X25519.
    *                See details in https://www.openssl.org/docs/man1.1.1/man3/EC_POINT_point2oct.html.
    * @return const std::vector<uint8_t>& the derived secret.
+   * @throw runtime_error @p peerkey is not a valid public key of the same algorithm.
    */
   const std::vector<uint8_t>&
-  deriveSecret(const std::vector<uint8_t>& peerkey);
+  deriveSecret(ndn::span<const uint8_t> peerkey);
 
   /**
    * @brief Get the Self Pub Key object
    *
-   * @return const std::vector<uint8_t>& the Self public key in the uncompressed oct string format.
+   * @return const std::vector<uint8_t>& the Self public key in the uncompressed oct string format,
+   *         or the raw 32-byte public key for X25519.
    *         See details in https://www.openssl.org/docs/man1.1.1/man3/EC_POINT_point2oct.html.
    */
   const std::vector<uint8_t>&
-  getSelfPubKey();
+  getSelfPubKey() const
+  {
+    return m_pubKey;
+  }
+
+  KeyAgreement
+  getAlgorithm() const
+  {
+    return m_algorithm;
+  }
 
 private:
+  KeyAgreement m_algorithm;
   EVP_PKEY* m_privkey = nullptr;
+  /**
+   * Context deriving secrets with m_privkey, created on first use
+   */
+  EVP_PKEY_CTX* m_deriveCtx = nullptr;
   std::vector<uint8_t> m_pubKey;
   std::vector<uint8_t> m_secret;
 };
@@ -98,6 +121,39 @@ hmacSha256(const uint8_t* data, size_t dataLen,
            const uint8_t* key, size_t keyLen,
            uint8_t* result);
 
+/**
+ * @brief HMAC based on SHA-256 with a fixed key.
+ *
+ * The key is set up once, so that each computation only hashes the data. An instance must
+ * not be used by several threads at the same time.
+ */
+class KeyedHmacSha256 : boost::noncopyable
+{
+public:
+  /**
+   * @throw runtime_error when the HMAC context cannot be created.
+   */
+  KeyedHmacSha256(const uint8_t* key, size_t keyLen);
+
+  ~KeyedHmacSha256();
+
+  /**
+   * @brief Compute the HMAC of @p data.
+   *
+   * @param result The result of the HMAC. Enough memory (32 Bytes) must be allocated beforehands.
+   * @throw runtime_error when an error occurred in the underlying HMAC.
+   */
+  void
+  compute(const uint8_t* data, size_t dataLen, uint8_t* result);
+
+private:
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  EVP_MAC_CTX* m_ctx = nullptr;
+#else
+  HMAC_CTX* m_ctx = nullptr;
+#endif
+};
+
 /**
  * @brief Authenticated GCM 128 Encryption with associated data.
  *
@@ -134,6 +190,44 @@ size_t
 aesGcm128Decrypt(const uint8_t* ciphertext, size_t ciphertextLen, const uint8_t* associated, size_t associatedLen,
                  const uint8_t* tag, const uint8_t* key, const uint8_t* iv, uint8_t* plaintext);
 
+/**
+ * @brief Authenticated ChaCha20-Poly1305 Encryption with associated data.
+ *
+ * @param plaintext The plaintext.
+ * @param plaintextLen The size of plaintext.
+ * @param associated The associated authentication data.
+ * @param associatedLen The size of associated authentication data.
+ * @param key 32 bytes ChaCha20 key.
+ * @param iv 12 bytes nonce.
+ * @param ciphertext The output and enough memory must be allocated beforehands.
+ * @param tag 16 bytes tag.
+ * @return size_t The size of ciphertext.
+ * @throw runtime_error When there is an error in the process of encryption.
+ */
+size_t
+chacha20Poly1305Encrypt(const uint8_t* plaintext, size_t plaintextLen, const uint8_t* associated,
+                        size_t associatedLen, const uint8_t* key, const uint8_t* iv,
+                        uint8_t* ciphertext, uint8_t* tag);
+
+/**
+ * @brief Authenticated ChaCha20-Poly1305 Decryption with associated data.
+ *
+ * @param ciphertext The ciphertext.
+ * @param ciphertextLen The size of ciphertext.
+ * @param associated The associated authentication data.
+ * @param associatedLen The size of associated authentication data.
+ * @param tag 16 bytes tag.
+ * @param key 32 bytes ChaCha20 key.
+ * @param iv 12 bytes nonce.
+ * @param plaintext The output and enough memory must be allocated beforehands.
+ * @return size_t The size of plaintext.
+ * @throw runtime_error When there is an error in the process of decryption.
+ */
+size_t
+chacha20Poly1305Decrypt(const uint8_t* ciphertext, size_t ciphertextLen, const uint8_t* associated,
+                        size_t associatedLen, const uint8_t* tag, const uint8_t* key, const uint8_t* iv,
+                        uint8_t* plaintext);
+
 /**
  * @brief Encode the payload into TLV block with Authenticated GCM 128 Encryption.
  *
@@ -173,6 +267,130 @@ decodeBlockWithAesGcm128(const Block& block, const uint8_t* key,
                          const uint8_t* associatedData, size_t associatedDataSize,
                          std::vector<uint8_t>& decryptionIv, const std::vector<uint8_t>& encryptionIv);
 
+/**
+ * @brief Derive the key of the AEAD algorithm of a request session from its session key.
+ *
+ * AES-128-GCM uses the session key itself, in the first 16 bytes of the result.
+ * ChaCha20-Poly1305 uses a 32-byte key expanded from the session key with HKDF, salted with
+ * @p salt. The key is derived once, when the session key is established.
+ *
+ * @param algorithm The AEAD algorithm.
+ * @param sessionKey The 16-byte session key.
+ * @param salt The salt, i.e., the request ID, or the certificate name for an early challenge.
+ * @param saltLen The length of the salt.
+ * @throw runtime_error @p algorithm is unknown.
+ */
+std::array<uint8_t, 32>
+deriveAeadKey(AeadAlgorithm algorithm, const uint8_t* sessionKey, const uint8_t* salt, size_t saltLen);
+
+/**
+ * @brief Encode the payload into TLV block with the AEAD algorithm of a request session.
+ *
+ * The block has the same format and IV discipline as encodeBlockWithAesGcm128(), whatever the
+ * algorithm.
+ *
+ * @param algorithm The AEAD algorithm.
+ * @param key The key of @p algorithm, as derived by deriveAeadKey().
+ * @throw runtime_error @p algorithm is unknown or the encryption fails.
+ */
+Block
+encodeBlockWithAead(AeadAlgorithm algorithm, uint32_t tlvType, const uint8_t* key,
+                    const uint8_t* payload, size_t payloadSize,
+                    const uint8_t* associatedData, size_t associatedDataSize,
+                    std::vector<uint8_t>& encryptionIv);
+
+/**
+ * @brief Decode the payload from TLV block with the AEAD algorithm of a request session.
+ *
+ * @param algorithm The AEAD algorithm.
+ * @param key The key of @p algorithm, as derived by deriveAeadKey().
+ * @throw runtime_error @p algorithm is unknown or the decryption fails.
+ * @sa decodeBlockWithAesGcm128
+ */
+ndn::Buffer
+decodeBlockWithAead(AeadAlgorithm algorithm, const Block& block, const uint8_t* key,
+                    const uint8_t* associatedData, size_t associatedDataSize,
+                    std::vector<uint8_t>& decryptionIv, const std::vector<uint8_t>& encryptionIv);
+
+/**
+ * @brief Decode the payload from TLV block with the AEAD algorithm of a request session, as
+ *        the value of a TLV element of type @p tlvType.
+ *
+ * The payload is decrypted directly into the buffer of the returned element, which is the only
+ * buffer allocated, so that its sub-elements can be parsed without copying it again.
+ *
+ * @throw runtime_error @p algorithm is unknown or the decryption fails.
+ * @sa decodeBlockWithAead
+ */
+Block
+decryptBlockWithAead(AeadAlgorithm algorithm, const Block& block, uint32_t tlvType, const uint8_t* key,
+                     const uint8_t* associatedData, size_t associatedDataSize,
+                     std::vector<uint8_t>& decryptionIv, const std::vector<uint8_t>& encryptionIv);
+
+/**
+ * @brief Derive the HMAC-SHA256 key used to sign Data packets within a request session.
+ *
+ * The key is derived from the session's AES key with HKDF, so that the AES key itself is
+ * never used by a second algorithm.
+ *
+ * @param aesKey The AES key of the request session.
+ * @param aesKeyLen The length of the AES key.
+ * @param requestId The request ID of the session.
+ * @param requestIdLen The length of the request ID.
+ */
+std::array<uint8_t, 32>
+deriveSessionHmacKey(const uint8_t* aesKey, size_t aesKeyLen,
+                     const uint8_t* requestId, size_t requestIdLen);
+
+/**
+ * @brief Derive the AES key protecting the challenge parameters carried by a NEW request.
+ *
+ * The key is derived with HKDF from the secret shared by the requester's ECDH key and the
+ * long-lived ECDH key published in the CA profile, salted with the requester's public key.
+ *
+ * @param sharedSecret The ECDH shared secret.
+ * @param sharedSecretLen The length of the shared secret.
+ * @param requesterPub The requester's ECDH public key, as carried by the NEW request.
+ * @param requesterPubLen The length of the requester's public key.
+ */
+std::array<uint8_t, 16>
+deriveEarlyChallengeKey(const uint8_t* sharedSecret, size_t sharedSecretLen,
+                        const uint8_t* requesterPub, size_t requesterPubLen);
+
+/**
+ * @brief Derive the secret behind a resumption ticket issued at the end of a request session.
+ *
+ * Both sides derive it from the session's AES key, so the secret itself is never sent. A later
+ * request presenting the ticket uses this secret in place of a fresh ECDH shared secret.
+ *
+ * @param aesKey The AES key of the request session.
+ * @param aesKeyLen The length of the AES key.
+ * @param requestId The request ID of the session.
+ * @param requestIdLen The length of the request ID.
+ */
+std::array<uint8_t, 32>
+deriveResumptionSecret(const uint8_t* aesKey, size_t aesKeyLen,
+                       const uint8_t* requestId, size_t requestIdLen);
+
+/**
+ * @brief Sign a Data packet with HMAC-SHA256.
+ *
+ * @param data The Data packet to sign.
+ * @param key The HMAC key.
+ * @param keyLen The length of the HMAC key.
+ * @param keyName The name put into the KeyLocator of the signature.
+ */
+void
+signDataWithHmacSha256(Data& data, const uint8_t* key, size_t keyLen, const Name& keyName);
+
+/**
+ * @brief Verify the HMAC-SHA256 signature of a Data packet.
+ *
+ * @return false if @p data is not signed with HMAC-SHA256 or the signature does not match.
+ */
+bool
+verifyDataWithHmacSha256(const Data& data, const uint8_t* key, size_t keyLen);
+
 } // namespace ndncert
 
 #endif // NDNCERT_DETAIL_CRYPTO_HELPERS_HPP
@@ -27,16 +27,21 @@ namespace ndncert::errortlv {
 NDN_LOG_INIT(ndncert.encode.error);
 
 Block
-encodeDataContent(ErrorCode errorCode, const std::string& description)
+encodeDataContent(ErrorCode errorCode, const std::string& description,
+                  std::optional<time::milliseconds> retryAfter)
 {
   Block response(ndn::tlv::Content);
   response.push_back(ndn::makeNonNegativeIntegerBlock(tlv::ErrorCode, static_cast<size_t>(errorCode)));
   response.push_back(ndn::makeStringBlock(tlv::ErrorInfo, description));
+  if (retryAfter) {
+    response.push_back(ndn::makeNonNegativeIntegerBlock(tlv::RetryAfter,
+                                                        static_cast<uint64_t>(retryAfter->count())));
+  }
   response.encode();
   return response;
 }
 
-std::tuple<ErrorCode, std::string>
+std::tuple<ErrorCode, std::string, std::optional<time::milliseconds>>
 decodefromDataContent(const Block& block)
 {
   try {
@@ -47,6 +52,7 @@ decodefromDataContent(const Block& block)
     int otherCriticalCount = 0;
     ErrorCode error = ErrorCode::NO_ERROR;
     std::string errorInfo;
+    std::optional<time::milliseconds> retryAfter;
     for (const auto& item : block.elements()) {
       if (item.type() == tlv::ErrorCode) {
         error = ndn::readNonNegativeIntegerAs<ErrorCode>(block.get(tlv::ErrorCode));
@@ -56,6 +62,9 @@ decodefromDataContent(const Block& block)
         errorInfo = readString(block.get(tlv::ErrorInfo));
         infoCount++;
       }
+      else if (item.type() == tlv::RetryAfter) {
+        retryAfter = time::milliseconds(ndn::readNonNegativeInteger(item));
+      }
       else if (ndn::tlv::isCriticalType(item.type())) {
         otherCriticalCount++;
       }
@@ -65,7 +74,7 @@ decodefromDataContent(const Block& block)
     }
 
     if (codeCount == 0 && infoCount == 0) {
-      return {ErrorCode::NO_ERROR, ""};
+      return {ErrorCode::NO_ERROR, "", std::nullopt};
     }
     if (codeCount != 1 || infoCount != 1) {
       NDN_THROW(std::runtime_error("Error TLV contains " + std::to_string(codeCount) + " error code(s) and " +
@@ -74,11 +83,11 @@ decodefromDataContent(const Block& block)
     if (otherCriticalCount > 0) {
       NDN_THROW(std::runtime_error("Unknown critical TLV type in error packet"));
     }
-    return {error, errorInfo};
+    return {error, errorInfo, retryAfter};
   }
   catch (const std::exception& e) {
     NDN_LOG_ERROR("Exception in error message decoding: " << e.what());
-    return {ErrorCode::NO_ERROR, ""};
+    return {ErrorCode::NO_ERROR, "", std::nullopt};
   }
 }
 
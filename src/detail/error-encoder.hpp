@@ -23,20 +23,26 @@
 
 #include "detail/ndncert-common.hpp"
 
+#include <optional>
 #include <tuple>
 
 namespace ndncert::errortlv {
 
 /**
  * Encode error information into a Data content TLV
+ *
+ * @param retryAfter if set, how long the requester should wait before retrying the request
  */
 Block
-encodeDataContent(ErrorCode errorCode, const std::string& description);
+encodeDataContent(ErrorCode errorCode, const std::string& description,
+                  std::optional<time::milliseconds> retryAfter = std::nullopt);
 
 /**
  * Decode error information from Data content TLV
+ *
+ * @return error code, error info, and the optional retry-after hint
  */
-std::tuple<ErrorCode, std::string>
+std::tuple<ErrorCode, std::string, std::optional<time::milliseconds>>
 decodefromDataContent(const Block& block);
 
 } // namespace ndncert::errortlv
@@ -43,6 +43,22 @@ encodeDataContent(const CaProfile& caConfig, const Certificate& certificate)
     content.push_back(ndn::makeStringBlock(tlv::ParameterKey, key));
   }
   content.push_back(ndn::makeNonNegativeIntegerBlock(tlv::MaxValidityPeriod, caConfig.maxValidityPeriod.count()));
+  if (!caConfig.ecdhPub.empty()) {
+    content.push_back(ndn::makeBinaryBlock(tlv::CaEcdhPub, caConfig.ecdhPub));
+  }
+  for (auto algorithm : caConfig.keyAgreements) {
+    content.push_back(ndn::makeNonNegativeIntegerBlock(tlv::KeyAgreement, static_cast<uint64_t>(algorithm)));
+  }
+  for (auto algorithm : caConfig.aeadAlgorithms) {
+    content.push_back(ndn::makeNonNegativeIntegerBlock(tlv::Aead, static_cast<uint64_t>(algorithm)));
+  }
+  if (caConfig.acceptsCompactCertRequest) {
+    // an empty element announces the support
+    content.push_back(ndn::makeEmptyBlock(tlv::CompactCertRequest));
+  }
+  if (caConfig.signsErrorsWithDigest) {
+    content.push_back(ndn::makeEmptyBlock(tlv::DigestSignedErrors));
+  }
   content.push_back(makeNestedBlock(tlv::CaCertificate, certificate));
   content.encode();
   NDN_LOG_TRACE("Encoding INFO packet with certificate " << certificate.getFullName());
@@ -69,6 +85,21 @@ decodeDataContent(const Block& block)
       case tlv::MaxValidityPeriod:
         result.maxValidityPeriod = time::seconds(readNonNegativeInteger(item));
         break;
+      case tlv::CaEcdhPub:
+        result.ecdhPub.assign(item.value_begin(), item.value_end());
+        break;
+      case tlv::KeyAgreement:
+        result.keyAgreements.push_back(static_cast<KeyAgreement>(readNonNegativeInteger(item)));
+        break;
+      case tlv::Aead:
+        result.aeadAlgorithms.push_back(static_cast<AeadAlgorithm>(readNonNegativeInteger(item)));
+        break;
+      case tlv::CompactCertRequest:
+        result.acceptsCompactCertRequest = true;
+        break;
+      case tlv::DigestSignedErrors:
+        result.signsErrorsWithDigest = true;
+        break;
       case tlv::CaCertificate:
         item.parse();
         result.cert = std::make_shared<Certificate>(item.get(ndn::tlv::Data));
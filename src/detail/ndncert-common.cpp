@@ -38,6 +38,7 @@ operator<<(std::ostream& out, ErrorCode code)
     case ErrorCode::OUT_OF_TRIES: return out << "OUT_OF_TRIES";
     case ErrorCode::OUT_OF_TIME: return out << "OUT_OF_TIME";
     case ErrorCode::NO_AVAILABLE_NAMES: return out << "NO_AVAILABLE_NAMES";
+    case ErrorCode::SERVICE_UNAVAILABLE: return out << "SERVICE_UNAVAILABLE";
   }
   return out << "<Unknown Error " << ndn::to_underlying(code) << ">";
 }
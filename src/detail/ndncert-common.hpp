@@ -97,6 +97,18 @@ enum : uint32_t {
   AuthenticationTag = 175,
   CertToRevoke = 177,
   ProbeRedirect = 179,
+  // non-critical extensions, ignored by peers that do not recognize them
+  RetryAfter = 180,
+  CaEcdhPub = 182,
+  EarlyChallenge = 184,
+  CertToRenew = 186,
+  IssuedCertificate = 188,
+  ResumptionTicket = 190,
+  SessionSigning = 192,
+  CompactCertRequest = 194,
+  KeyAgreement = 196,
+  Aead = 198,
+  DigestSignedErrors = 200,
 };
 
 } // namespace tlv
@@ -115,12 +127,25 @@ enum class ErrorCode : uint64_t {
   OUT_OF_TRIES = 7,
   OUT_OF_TIME = 8,
   NO_AVAILABLE_NAMES = 9,
+  SERVICE_UNAVAILABLE = 10,
 };
 
 // Convert error code to string
 std::ostream&
 operator<<(std::ostream& os, ErrorCode code);
 
+// Key agreement algorithm of a request session
+enum class KeyAgreement : uint64_t {
+  P256 = 0,
+  X25519 = 1,
+};
+
+// AEAD algorithm protecting the encrypted payloads of a request session
+enum class AeadAlgorithm : uint64_t {
+  AES_128_GCM = 0,
+  CHACHA20_POLY1305 = 1,
+};
+
 // NDNCERT request type
 enum class RequestType : uint64_t {
   NOTINITIALIZED = 0,
@@ -0,0 +1,89 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2024, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+
+#include "detail/renew-encoder.hpp"
+
+namespace ndncert::renewtlv {
+
+Block
+encodeApplicationParameters(const Certificate& certRequest, const Certificate& certToRenew)
+{
+  Block request(ndn::tlv::ApplicationParameters);
+  request.push_back(makeNestedBlock(tlv::CertRequest, certRequest));
+  request.push_back(makeNestedBlock(tlv::CertToRenew, certToRenew));
+  request.encode();
+  return request;
+}
+
+void
+decodeApplicationParameters(const Block& block, std::optional<Certificate>& certRequest,
+                            std::optional<Certificate>& certToRenew)
+{
+  block.parse();
+  certRequest.reset();
+  certToRenew.reset();
+  for (const auto& item : block.elements()) {
+    switch (item.type()) {
+      case tlv::CertRequest:
+        if (certRequest) {
+          NDN_THROW(std::runtime_error("Duplicate CertRequest"));
+        }
+        item.parse();
+        certRequest.emplace(item.get(ndn::tlv::Data));
+        break;
+      case tlv::CertToRenew:
+        if (certToRenew) {
+          NDN_THROW(std::runtime_error("Duplicate CertToRenew"));
+        }
+        item.parse();
+        certToRenew.emplace(item.get(ndn::tlv::Data));
+        break;
+      default:
+        if (ndn::tlv::isCriticalType(item.type())) {
+          NDN_THROW(std::runtime_error("Unrecognized TLV Type: " + std::to_string(item.type())));
+        }
+        break;
+    }
+  }
+  if (!certRequest || !certToRenew) {
+    NDN_THROW(std::runtime_error("RENEW parameters must contain a CertRequest and a CertToRenew"));
+  }
+}
+
+Block
+encodeDataContent(const Certificate& issuedCert)
+{
+  Block content(ndn::tlv::Content);
+  content.push_back(makeNestedBlock(tlv::IssuedCertificate, issuedCert));
+  content.encode();
+  return content;
+}
+
+Certificate
+decodeDataContent(const Block& content)
+{
+  content.parse();
+  const auto& item = content.get(tlv::IssuedCertificate);
+  item.parse();
+  return Certificate(item.get(ndn::tlv::Data));
+}
+
+} // namespace ndncert::renewtlv
@@ -0,0 +1,60 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2024, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+
+#ifndef NDNCERT_DETAIL_RENEW_ENCODER_HPP
+#define NDNCERT_DETAIL_RENEW_ENCODER_HPP
+
+#include "detail/ndncert-common.hpp"
+
+#include <optional>
+
+namespace ndncert::renewtlv {
+
+/**
+ * Encode the certificate request and the certificate to renew into the ApplicationParameters
+ * of a RENEW Interest.
+ */
+Block
+encodeApplicationParameters(const Certificate& certRequest, const Certificate& certToRenew);
+
+/**
+ * Decode the certificate request and the certificate to renew from the ApplicationParameters
+ * of a RENEW Interest.
+ */
+void
+decodeApplicationParameters(const Block& block, std::optional<Certificate>& certRequest,
+                            std::optional<Certificate>& certToRenew);
+
+/**
+ * Encode the renewed certificate into a TLV block as RENEW Data packet content.
+ */
+Block
+encodeDataContent(const Certificate& issuedCert);
+
+/**
+ * Decode the renewed certificate from the TLV block of RENEW Data packet content.
+ */
+Certificate
+decodeDataContent(const Block& content);
+
+} // namespace ndncert::renewtlv
+
+#endif // NDNCERT_DETAIL_RENEW_ENCODER_HPP
@@ -26,45 +26,99 @@
 
 namespace ndncert {
 
+Block
+requesttlv::encodeCompactCertRequest(const Certificate& certRequest)
+{
+  Block compact(tlv::CompactCertRequest);
+  compact.push_back(certRequest.getName().wireEncode());
+  compact.push_back(ndn::makeBinaryBlock(ndn::tlv::Content, certRequest.getPublicKey()));
+  compact.push_back(certRequest.getValidityPeriod().wireEncode());
+  compact.encode();
+  return compact;
+}
+
+Certificate
+requesttlv::decodeCompactCertRequest(const Block& block)
+{
+  block.parse();
+  auto name = block.find(ndn::tlv::Name);
+  auto publicKey = block.find(ndn::tlv::Content);
+  auto validityPeriod = block.find(ndn::tlv::ValidityPeriod);
+  if (name == block.elements_end() || publicKey == block.elements_end() ||
+      validityPeriod == block.elements_end()) {
+    NDN_THROW(std::runtime_error("Compact certificate request lacks a name, a public key, or a validity period"));
+  }
+
+  Certificate certRequest;
+  certRequest.setName(Name(*name));
+  certRequest.setContentType(ndn::tlv::ContentType_Key);
+  certRequest.setContent(publicKey->value_bytes());
+  SignatureInfo signatureInfo;
+  signatureInfo.setValidityPeriod(ndn::security::ValidityPeriod(*validityPeriod));
+  certRequest.setSignatureInfo(signatureInfo);
+  return certRequest;
+}
+
 Block
 requesttlv::encodeApplicationParameters(RequestType requestType,
                                         const std::vector<uint8_t>& ecdhPub,
-                                        const Certificate& certRequest)
+                                        const Certificate& certRequest,
+                                        const Block& earlyChallenge,
+                                        const Block& resumptionTicket,
+                                        bool isCompact,
+                                        KeyAgreement keyAgreement,
+                                        AeadAlgorithm aead)
 {
   Block request(ndn::tlv::ApplicationParameters);
   request.push_back(ndn::makeBinaryBlock(tlv::EcdhPub, ecdhPub));
-  if (requestType == RequestType::NEW || requestType == RequestType::RENEW) {
+  if (keyAgreement != KeyAgreement::P256) {
+    request.push_back(ndn::makeNonNegativeIntegerBlock(tlv::KeyAgreement, static_cast<uint64_t>(keyAgreement)));
+  }
+  if (aead != AeadAlgorithm::AES_128_GCM) {
+    request.push_back(ndn::makeNonNegativeIntegerBlock(tlv::Aead, static_cast<uint64_t>(aead)));
+  }
+  if (requestType == RequestType::NEW && isCompact) {
+    request.push_back(encodeCompactCertRequest(certRequest));
+  }
+  else if (requestType == RequestType::NEW || requestType == RequestType::RENEW) {
     request.push_back(makeNestedBlock(tlv::CertRequest, certRequest));
   }
   else if (requestType == RequestType::REVOKE) {
     request.push_back(makeNestedBlock(tlv::CertToRevoke, certRequest));
   }
+  if (earlyChallenge.isValid()) {
+    request.push_back(earlyChallenge);
+  }
+  if (resumptionTicket.isValid()) {
+    request.push_back(resumptionTicket);
+  }
   request.encode();
   return request;
 }
 
 void
 requesttlv::decodeApplicationParameters(const Block& payload, RequestType requestType,
-                                        std::vector<uint8_t>& ecdhPub,
-                                        std::shared_ptr<Certificate>& clientCert)
+                                        ndn::span<const uint8_t>& ecdhPub,
+                                        std::optional<Certificate>& clientCert)
 {
   payload.parse();
 
   int ecdhPubCount = 0;
-  Block requestPayload;
   int requestPayloadCount = 0;
   for (const auto &item : payload.elements()) {
     if (item.type() == tlv::EcdhPub) {
-      ecdhPub.resize(item.value_size());
-      std::memcpy(ecdhPub.data(), item.value(), item.value_size());
+      ecdhPub = item.value_bytes();
       ecdhPubCount++;
     }
     else if ((requestType == RequestType::NEW && item.type() == tlv::CertRequest) ||
                (requestType == RequestType::REVOKE && item.type() == tlv::CertToRevoke)) {
-      requestPayload = item;
       requestPayloadCount++;
-      requestPayload.parse();
-      clientCert = std::make_shared<Certificate>(requestPayload.get(ndn::tlv::Data));
+      item.parse();
+      clientCert.emplace(item.get(ndn::tlv::Data));
+    }
+    else if (requestType == RequestType::NEW && item.type() == tlv::CompactCertRequest) {
+      requestPayloadCount++;
+      clientCert = decodeCompactCertRequest(item);
     }
     else if (ndn::tlv::isCriticalType(item.type())) {
       NDN_THROW(std::runtime_error("Unrecognized TLV Type: " + std::to_string(item.type())));
@@ -88,7 +142,9 @@ requesttlv::encodeDataContent(const std::vector<uint8_t>& ecdhKey,
                               const std::vector<std::string>& challenges)
 {
   Block response(ndn::tlv::Content);
-  response.push_back(ndn::makeBinaryBlock(tlv::EcdhPub, ecdhKey));
+  if (!ecdhKey.empty()) {
+    response.push_back(ndn::makeBinaryBlock(tlv::EcdhPub, ecdhKey));
+  }
   response.push_back(ndn::makeBinaryBlock(tlv::Salt, salt));
   response.push_back(ndn::makeBinaryBlock(tlv::RequestId, requestId));
   for (const auto& entry: challenges) {
@@ -128,10 +184,11 @@ requesttlv::decodeDataContent(const Block& content, std::vector <uint8_t>& ecdhK
       //ignore
     }
   }
-  if (ecdhPubCount != 1 || saltCount != 1 || requestIdCount != 1) {
+  // the ECDH public key is omitted when the session key is derived from a resumption ticket
+  if (ecdhPubCount > 1 || saltCount != 1 || requestIdCount != 1) {
     NDN_THROW(std::runtime_error("Error TLV contains " + std::to_string(ecdhPubCount) + " ecdh public param(s), " +
                                  std::to_string(saltCount) + " salt(s) and " + std::to_string(requestIdCount) +
-                                 "request id(s), instead of expected 1 times each."));
+                                 "request id(s), instead of expected at most 1 of the first and 1 of the others."));
   }
   return challenges;
 }
@@ -25,18 +25,64 @@
 
 namespace ndncert::requesttlv {
 
+/**
+ * @brief Encode @p certRequest in the compact format, as a CompactCertRequest element.
+ *
+ * Only the name, public key, and validity period of the request are kept. The CA rebuilds the
+ * certificate request from them, and the possession of the key is proven by the signature of
+ * the NEW Interest instead of the self-signature of the request.
+ */
+Block
+encodeCompactCertRequest(const Certificate& certRequest);
+
+/**
+ * @brief Rebuild a certificate request from a CompactCertRequest element.
+ *
+ * The returned certificate is not signed yet.
+ * @throw std::runtime_error the element is malformed.
+ */
+Certificate
+decodeCompactCertRequest(const Block& block);
+
+/**
+ * @param earlyChallenge The encrypted first step of a challenge, as an EarlyChallenge element,
+ *                       or an invalid Block if the request does not carry one.
+ * @param resumptionTicket A ResumptionTicket element issued by the CA, or an invalid Block if
+ *                         the request does not carry one.
+ * @param isCompact Whether a NEW request carries @p certRequest in the compact format.
+ * @param keyAgreement The algorithm of @p ecdhPub. P-256 is not announced, for compatibility
+ *                     with CAs that only support it.
+ * @param aead The AEAD algorithm of the session. AES-128-GCM is not announced either.
+ */
 Block
 encodeApplicationParameters(RequestType requestType, const std::vector<uint8_t>& ecdhPub,
-                            const Certificate& certRequest);
+                            const Certificate& certRequest, const Block& earlyChallenge = Block(),
+                            const Block& resumptionTicket = Block(), bool isCompact = false,
+                            KeyAgreement keyAgreement = KeyAgreement::P256,
+                            AeadAlgorithm aead = AeadAlgorithm::AES_128_GCM);
 
+/**
+ * @param ecdhPub Set to the ECDH public key, as a view of the wire encoding of @p block.
+ * @param certRequest Set to the certificate request or the certificate to revoke, which shares
+ *                    the wire encoding of @p block. A request in the compact format is rebuilt
+ *                    but not signed.
+ */
 void
-decodeApplicationParameters(const Block& block, RequestType requestType, std::vector<uint8_t>& ecdhPub,
-                            std::shared_ptr<Certificate>& certRequest);
+decodeApplicationParameters(const Block& block, RequestType requestType, ndn::span<const uint8_t>& ecdhPub,
+                            std::optional<Certificate>& certRequest);
 
+/**
+ * @param ecdhKey The CA's ECDH public key, or empty if the session key is derived from a
+ *                resumption ticket.
+ */
 Block
 encodeDataContent(const std::vector<uint8_t>& ecdhKey, const std::array<uint8_t, 32>& salt,
                   const RequestId& requestId, const std::vector<std::string>& challenges);
 
+/**
+ * @param ecdhKey Left empty if the content does not carry an ECDH public key, i.e., if the
+ *                CA has accepted the resumption ticket of the request.
+ */
 std::list<std::string>
 decodeDataContent(const Block& content, std::vector<uint8_t>& ecdhKey,
                   std::array<uint8_t, 32>& salt, RequestId& requestId);
@@ -0,0 +1,150 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2024, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/request-scheduler.hpp"
+
+#include <ndn-cxx/util/logger.hpp>
+
+namespace ndncert::ca {
+
+NDN_LOG_INIT(ndncert.ca.scheduler);
+
+std::ostream&
+operator<<(std::ostream& os, RequestClass requestClass)
+{
+  switch (requestClass) {
+    case RequestClass::CHALLENGE: return os << "CHALLENGE";
+    case RequestClass::NEW: return os << "NEW";
+    case RequestClass::PROBE: return os << "PROBE";
+    case RequestClass::INFO: return os << "INFO";
+  }
+  return os << "<Unknown Request Class " << static_cast<size_t>(requestClass) << ">";
+}
+
+RequestScheduler::RequestScheduler(boost::asio::io_context& io)
+  : RequestScheduler(io, Options{})
+{
+}
+
+RequestScheduler::RequestScheduler(boost::asio::io_context& io, const Options& options)
+  : m_scheduler(io)
+{
+  setOptions(options);
+}
+
+void
+RequestScheduler::setOptions(const Options& options)
+{
+  if (options.capacity == 0) {
+    NDN_THROW(std::invalid_argument("Request queue capacity must be positive"));
+  }
+  for (auto weight : options.weights) {
+    if (weight == 0) {
+      NDN_THROW(std::invalid_argument("Request class weights must be positive"));
+    }
+  }
+  m_options = options;
+}
+
+bool
+RequestScheduler::enqueue(RequestClass requestClass, const Interest& interest, Handler handler)
+{
+  auto classIndex = static_cast<size_t>(requestClass);
+  BOOST_ASSERT(classIndex < REQUEST_CLASS_COUNT);
+
+  if (m_size >= m_options.capacity) {
+    // make room by shedding the oldest Interest of the lowest class below the incoming one
+    size_t victim = REQUEST_CLASS_COUNT;
+    for (size_t i = REQUEST_CLASS_COUNT - 1; i > classIndex; --i) {
+      if (!m_queues[i].empty()) {
+        victim = i;
+        break;
+      }
+    }
+    if (victim == REQUEST_CLASS_COUNT) {
+      shed(classIndex, interest);
+      return false;
+    }
+    auto entry = std::move(m_queues[victim].front());
+    m_queues[victim].pop_front();
+    --m_size;
+    shed(victim, entry.interest);
+  }
+
+  m_queues[classIndex].push_back({interest, std::move(handler),
+                                  time::steady_clock::now() + interest.getInterestLifetime()});
+  ++m_size;
+  ++m_counters[classIndex].nEnqueued;
+  scheduleDrain();
+  return true;
+}
+
+void
+RequestScheduler::scheduleDrain()
+{
+  if (!m_isDrainScheduled) {
+    m_isDrainScheduled = true;
+    m_drainEvent = m_scheduler.schedule(0_ns, [this] { drain(); });
+  }
+}
+
+void
+RequestScheduler::drain()
+{
+  m_isDrainScheduled = false;
+
+  // one weighted round; Interests arriving while it runs are queued and considered next round
+  for (size_t i = 0; i < REQUEST_CLASS_COUNT; ++i) {
+    auto& queue = m_queues[i];
+    for (size_t n = 0; n < m_options.weights[i] && !queue.empty(); ++n) {
+      auto entry = std::move(queue.front());
+      queue.pop_front();
+      --m_size;
+
+      if (entry.expiry < time::steady_clock::now()) {
+        NDN_LOG_DEBUG("Dropping expired " << static_cast<RequestClass>(i) << " request "
+                      << entry.interest.getName());
+        ++m_counters[i].nExpired;
+        continue;
+      }
+      ++m_counters[i].nDispatched;
+      auto start = time::steady_clock::now();
+      entry.handler(entry.interest);
+      m_serviceTime = (m_serviceTime * 7 + (time::steady_clock::now() - start)) / 8;
+    }
+  }
+
+  if (m_size > 0) {
+    scheduleDrain();
+  }
+}
+
+void
+RequestScheduler::shed(size_t classIndex, const Interest& interest)
+{
+  NDN_LOG_DEBUG("Queue full (" << m_size << "), shedding " << static_cast<RequestClass>(classIndex)
+                << " request " << interest.getName());
+  ++m_counters[classIndex].nShed;
+  if (m_shedCallback) {
+    m_shedCallback(interest, static_cast<RequestClass>(classIndex));
+  }
+}
+
+} // namespace ndncert::ca
@@ -0,0 +1,187 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2024, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#ifndef NDNCERT_DETAIL_REQUEST_SCHEDULER_HPP
+#define NDNCERT_DETAIL_REQUEST_SCHEDULER_HPP
+
+#include "detail/ndncert-common.hpp"
+
+#include <ndn-cxx/util/scheduler.hpp>
+
+#include <array>
+#include <deque>
+#include <functional>
+
+namespace ndncert::ca {
+
+/**
+ * @brief Class of an incoming CA request, in decreasing order of priority.
+ *
+ * CHALLENGE requests belong to sessions the CA has already invested in, so they are served
+ * first; NEW covers NEW, RENEW, and REVOKE; INFO is the cheapest to retry and is served last.
+ */
+enum class RequestClass : size_t {
+  CHALLENGE = 0,
+  NEW = 1,
+  PROBE = 2,
+  INFO = 3,
+};
+
+constexpr size_t REQUEST_CLASS_COUNT = 4;
+
+std::ostream&
+operator<<(std::ostream& os, RequestClass requestClass);
+
+/**
+ * @brief Weighted priority queue placed in front of the CA request handlers.
+ *
+ * Every incoming Interest is queued by its RequestClass. Queued Interests are dispatched from
+ * the event loop in weighted rounds: during each round, up to `weights[c]` Interests of class
+ * `c` are dispatched, highest priority first, so that a flood of low-priority requests slows
+ * down but never blocks in-progress sessions.
+ *
+ * When the total number of queued Interests reaches the capacity, the oldest Interest of the
+ * lowest class that is below the incoming one is shed. If no such Interest exists, the
+ * incoming Interest itself is shed. Interests whose lifetime has run out while they were
+ * waiting are dropped without being dispatched, since nobody is waiting for the answer.
+ */
+class RequestScheduler : boost::noncopyable
+{
+public:
+  using Handler = std::function<void(const Interest&)>;
+  using ShedCallback = std::function<void(const Interest&, RequestClass)>;
+
+  struct Options
+  {
+    /**
+     * @brief Maximum number of queued Interests across all classes.
+     */
+    size_t capacity = 512;
+    /**
+     * @brief Number of Interests of each class dispatched per round, indexed by RequestClass.
+     */
+    std::array<size_t, REQUEST_CLASS_COUNT> weights = {8, 4, 2, 1};
+  };
+
+  struct Counters
+  {
+    uint64_t nEnqueued = 0;
+    uint64_t nDispatched = 0;
+    uint64_t nShed = 0;
+    uint64_t nExpired = 0;
+  };
+
+public:
+  explicit
+  RequestScheduler(boost::asio::io_context& io);
+
+  RequestScheduler(boost::asio::io_context& io, const Options& options);
+
+  /**
+   * @brief Change the scheduling options.
+   *
+   * Interests already queued are kept, even if they exceed the new capacity.
+   * @throw std::invalid_argument the capacity or any of the weights is zero.
+   */
+  void
+  setOptions(const Options& options);
+
+  const Options&
+  getOptions() const
+  {
+    return m_options;
+  }
+
+  /**
+   * @brief Set the callback invoked for each Interest shed because of a full queue.
+   */
+  void
+  setShedCallback(ShedCallback callback)
+  {
+    m_shedCallback = std::move(callback);
+  }
+
+  /**
+   * @brief Queue @p interest to be handled by @p handler.
+   * @return false if @p interest has been shed instead of queued.
+   */
+  bool
+  enqueue(RequestClass requestClass, const Interest& interest, Handler handler);
+
+  /**
+   * @return number of currently queued Interests of all classes.
+   */
+  size_t
+  size() const
+  {
+    return m_size;
+  }
+
+  /**
+   * @brief Estimate how long a newly queued Interest would wait before being dispatched.
+   *
+   * The estimate is the number of queued Interests times the moving average of the time
+   * spent in a handler.
+   */
+  time::nanoseconds
+  estimateQueueingDelay() const
+  {
+    return m_serviceTime * m_size;
+  }
+
+  const Counters&
+  getCounters(RequestClass requestClass) const
+  {
+    return m_counters[static_cast<size_t>(requestClass)];
+  }
+
+NDNCERT_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
+  void
+  scheduleDrain();
+
+  void
+  drain();
+
+private:
+  struct Entry
+  {
+    Interest interest;
+    Handler handler;
+    time::steady_clock::time_point expiry;
+  };
+
+  void
+  shed(size_t classIndex, const Interest& interest);
+
+private:
+  ndn::Scheduler m_scheduler;
+  ndn::scheduler::ScopedEventId m_drainEvent;
+  Options m_options;
+  std::array<std::deque<Entry>, REQUEST_CLASS_COUNT> m_queues;
+  std::array<Counters, REQUEST_CLASS_COUNT> m_counters;
+  ShedCallback m_shedCallback;
+  size_t m_size = 0;
+  time::nanoseconds m_serviceTime = 0_ns;
+  bool m_isDrainScheduled = false;
+};
+
+} // namespace ndncert::ca
+
+#endif // NDNCERT_DETAIL_REQUEST_SCHEDULER_HPP
@@ -0,0 +1,118 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2024, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+
+#include "detail/resumption-ticket.hpp"
+#include "detail/crypto-helpers.hpp"
+
+#include <ndn-cxx/util/logger.hpp>
+#include <ndn-cxx/util/random.hpp>
+
+#include <boost/endian/conversion.hpp>
+
+namespace ndncert::ca {
+
+NDN_LOG_INIT(ndncert.ca.ticket);
+
+// the sealed payload: the resumption secret followed by the expiry in milliseconds, big endian
+constexpr size_t TICKET_PAYLOAD_SIZE = 32 + 8;
+
+ResumptionTicketKeys::ResumptionTicketKeys(time::seconds lifetime)
+  : m_lifetime(lifetime)
+{
+  if (m_lifetime <= 0_s) {
+    NDN_THROW(std::invalid_argument("Resumption ticket lifetime must be positive"));
+  }
+  ndn::random::generateSecureBytes(m_currentKey);
+  m_nextRotation = time::system_clock::now() + m_lifetime;
+}
+
+void
+ResumptionTicketKeys::rotateIfNeeded()
+{
+  auto now = time::system_clock::now();
+  if (now < m_nextRotation) {
+    return;
+  }
+  if (now < m_nextRotation + m_lifetime) {
+    m_previousKey = m_currentKey;
+  }
+  else {
+    // the current key has been idle for a whole lifetime, all of its tickets have expired
+    m_previousKey.reset();
+  }
+  ndn::random::generateSecureBytes(m_currentKey);
+  m_nextRotation = now + m_lifetime;
+  NDN_LOG_DEBUG("Resumption ticket key rotated");
+}
+
+Block
+ResumptionTicketKeys::seal(const Name& keyName, const std::array<uint8_t, 32>& secret)
+{
+  rotateIfNeeded();
+
+  std::array<uint8_t, TICKET_PAYLOAD_SIZE> payload;
+  std::copy(secret.begin(), secret.end(), payload.begin());
+  auto expiry = time::toUnixTimestamp(time::system_clock::now() + m_lifetime).count();
+  boost::endian::endian_store<uint64_t, 8, boost::endian::order::big>(&payload[32], expiry);
+
+  const auto& keyNameWire = keyName.wireEncode();
+  std::vector<uint8_t> encryptionIv;
+  return encodeBlockWithAesGcm128(tlv::ResumptionTicket, m_currentKey.data(), payload.data(), payload.size(),
+                                  keyNameWire.data(), keyNameWire.size(), encryptionIv);
+}
+
+std::optional<std::array<uint8_t, 32>>
+ResumptionTicketKeys::open(const Block& ticket, const Name& keyName)
+{
+  rotateIfNeeded();
+
+  const auto& keyNameWire = keyName.wireEncode();
+  std::optional<ndn::Buffer> payload;
+  for (const auto* key : {&m_currentKey, m_previousKey ? &*m_previousKey : nullptr}) {
+    if (key == nullptr) {
+      continue;
+    }
+    try {
+      std::vector<uint8_t> decryptionIv;
+      payload = decodeBlockWithAesGcm128(ticket, key->data(), keyNameWire.data(), keyNameWire.size(),
+                                         decryptionIv, {});
+      break;
+    }
+    catch (const std::exception&) {
+      // not sealed with this key, or not for this key name
+    }
+  }
+  if (!payload || payload->size() != TICKET_PAYLOAD_SIZE) {
+    NDN_LOG_DEBUG("Cannot open the resumption ticket presented for " << keyName);
+    return std::nullopt;
+  }
+
+  auto expiry = boost::endian::endian_load<uint64_t, 8, boost::endian::order::big>(payload->data() + 32);
+  if (time::fromUnixTimestamp(time::milliseconds(expiry)) < time::system_clock::now()) {
+    NDN_LOG_DEBUG("Expired resumption ticket presented for " << keyName);
+    return std::nullopt;
+  }
+  std::array<uint8_t, 32> secret;
+  std::copy_n(payload->begin(), secret.size(), secret.begin());
+  return secret;
+}
+
+} // namespace ndncert::ca
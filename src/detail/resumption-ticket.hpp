@@ -0,0 +1,78 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2024, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+
+#ifndef NDNCERT_DETAIL_RESUMPTION_TICKET_HPP
+#define NDNCERT_DETAIL_RESUMPTION_TICKET_HPP
+
+#include "detail/ndncert-common.hpp"
+
+#include <optional>
+
+namespace ndncert::ca {
+
+/**
+ * @brief Rotating keys sealing the resumption tickets issued by a CA.
+ *
+ * A ticket carries a resumption secret, encrypted and bound to the requester's key name with
+ * AES-GCM, so that the CA does not keep any state for it. Tickets are valid for the configured
+ * lifetime. The sealing key is replaced once per lifetime, and the previous key is kept for
+ * one more lifetime, so that every ticket can be opened until it expires.
+ */
+class ResumptionTicketKeys : boost::noncopyable
+{
+public:
+  explicit
+  ResumptionTicketKeys(time::seconds lifetime);
+
+  time::seconds
+  getLifetime() const
+  {
+    return m_lifetime;
+  }
+
+  /**
+   * @brief Seal @p secret into a ResumptionTicket element for @p keyName.
+   */
+  Block
+  seal(const Name& keyName, const std::array<uint8_t, 32>& secret);
+
+  /**
+   * @brief Open a ticket presented with a request for @p keyName.
+   * @return the resumption secret, or std::nullopt if @p ticket has expired, has not been issued
+   *         for @p keyName, or has been sealed with a key that has already been discarded.
+   */
+  std::optional<std::array<uint8_t, 32>>
+  open(const Block& ticket, const Name& keyName);
+
+NDNCERT_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
+  void
+  rotateIfNeeded();
+
+private:
+  time::seconds m_lifetime;
+  std::array<uint8_t, 16> m_currentKey;
+  std::optional<std::array<uint8_t, 16>> m_previousKey;
+  time::system_clock::time_point m_nextRotation;
+};
+
+} // namespace ndncert::ca
+
+#endif // NDNCERT_DETAIL_RESUMPTION_TICKET_HPP
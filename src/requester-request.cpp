@@ -27,6 +27,7 @@
 #include "detail/info-encoder.hpp"
 #include "detail/request-encoder.hpp"
 #include "detail/probe-encoder.hpp"
+#include "detail/renew-encoder.hpp"
 
 #include <ndn-cxx/metadata-object.hpp>
 #include <ndn-cxx/security/signing-helpers.hpp>
@@ -63,13 +64,62 @@ Request::genCaProfileInterestFromDiscoveryResponse(const Data& reply)
   return std::make_shared<Interest>(interestName);
 }
 
+std::shared_ptr<Interest>
+Request::genCaProfileSegmentInterest(const Data& reply)
+{
+  const auto& name = reply.getName();
+  auto finalBlock = reply.getFinalBlock();
+  if (name.empty() || !name[-1].isSegment() || !finalBlock || *finalBlock == name[-1]) {
+    return nullptr;
+  }
+  auto interestName = name.getPrefix(-1);
+  interestName.appendSegment(name[-1].toSegment() + 1);
+  return std::make_shared<Interest>(interestName);
+}
+
 std::optional<CaProfile>
 Request::onCaProfileResponse(const Data& reply)
 {
-  auto caItem = infotlv::decodeDataContent(reply.getContent());
-  if (!ndn::security::verifySignature(reply, *caItem.cert)) {
-    NDN_LOG_ERROR("Cannot verify replied Data packet signature.");
-    NDN_THROW(std::runtime_error("Cannot verify replied Data packet signature."));
+  return onCaProfileResponse(std::vector<Data>{reply});
+}
+
+std::optional<CaProfile>
+Request::onCaProfileResponse(const std::vector<Data>& segments)
+{
+  if (segments.empty()) {
+    NDN_THROW(std::runtime_error("No CA profile segment has been received."));
+  }
+
+  Block content;
+  if (segments.size() == 1) {
+    content = segments.front().getContent();
+  }
+  else {
+    // the segments carry consecutive slices of the value of a single Content element
+    auto finalBlock = segments.back().getFinalBlock();
+    if (!finalBlock || *finalBlock != segments.back().getName().at(-1)) {
+      NDN_LOG_ERROR("The CA profile segments are incomplete.");
+      NDN_THROW(std::runtime_error("The CA profile segments are incomplete."));
+    }
+    ndn::Buffer buffer;
+    for (size_t i = 0; i < segments.size(); ++i) {
+      const auto& name = segments[i].getName();
+      if (name.empty() || !name[-1].isSegment() || name[-1].toSegment() != i) {
+        NDN_LOG_ERROR("The CA profile segments are out of order.");
+        NDN_THROW(std::runtime_error("The CA profile segments are out of order."));
+      }
+      auto value = segments[i].getContent().value_bytes();
+      buffer.insert(buffer.end(), value.begin(), value.end());
+    }
+    content = ndn::makeBinaryBlock(ndn::tlv::Content, buffer);
+  }
+
+  auto caItem = infotlv::decodeDataContent(content);
+  for (const auto& segment : segments) {
+    if (!ndn::security::verifySignature(segment, *caItem.cert)) {
+      NDN_LOG_ERROR("Cannot verify replied Data packet signature.");
+      NDN_THROW(std::runtime_error("Cannot verify replied Data packet signature."));
+    }
   }
   return caItem;
 }
@@ -77,14 +127,20 @@ Request::onCaProfileResponse(const Data& reply)
 std::optional<CaProfile>
 Request::onCaProfileResponseAfterRedirection(const Data& reply, const Name& caCertFullName)
 {
-  auto caItem = infotlv::decodeDataContent(reply.getContent());
-  auto certBlock = caItem.cert->wireEncode();
-  caItem.cert = std::make_shared<Certificate>(certBlock);
-  if (caItem.cert->getFullName() != caCertFullName) {
+  return onCaProfileResponseAfterRedirection(std::vector<Data>{reply}, caCertFullName);
+}
+
+std::optional<CaProfile>
+Request::onCaProfileResponseAfterRedirection(const std::vector<Data>& segments, const Name& caCertFullName)
+{
+  auto caItem = onCaProfileResponse(segments);
+  auto certBlock = caItem->cert->wireEncode();
+  caItem->cert = std::make_shared<Certificate>(certBlock);
+  if (caItem->cert->getFullName() != caCertFullName) {
     NDN_LOG_ERROR("Ca profile does not match the certificate information offered by the original CA.");
     NDN_THROW(std::runtime_error("Cannot verify replied Data packet signature."));
   }
-  return onCaProfileResponse(reply);
+  return caItem;
 }
 
 std::shared_ptr<Interest>
@@ -102,17 +158,37 @@ void
 Request::onProbeResponse(const Data& reply, const CaProfile& ca,
                          std::vector<std::pair<Name, int>>& identityNames, std::vector<Name>& otherCas)
 {
-  if (!ndn::security::verifySignature(reply, *ca.cert)) {
-    NDN_LOG_ERROR("Cannot verify replied Data packet signature.");
-    NDN_THROW(std::runtime_error("Cannot verify replied Data packet signature."));
-  }
+  verifyResponse(reply, ca, nullptr);
   processIfError(reply);
   probetlv::decodeDataContent(reply.getContent(), identityNames, otherCas);
 }
 
-Request::Request(ndn::KeyChain& keyChain, const CaProfile& profile, RequestType requestType)
+static KeyAgreement
+selectKeyAgreement(const CaProfile& profile)
+{
+  const auto& algorithms = profile.keyAgreements;
+  if (std::find(algorithms.begin(), algorithms.end(), KeyAgreement::X25519) != algorithms.end()) {
+    return KeyAgreement::X25519;
+  }
+  return KeyAgreement::P256;
+}
+
+static AeadAlgorithm
+selectAead(const CaProfile& profile, AeadAlgorithm preferred)
+{
+  const auto& algorithms = profile.aeadAlgorithms;
+  if (std::find(algorithms.begin(), algorithms.end(), preferred) != algorithms.end()) {
+    return preferred;
+  }
+  return AeadAlgorithm::AES_128_GCM;
+}
+
+Request::Request(ndn::KeyChain& keyChain, const CaProfile& profile, RequestType requestType,
+                 AeadAlgorithm preferredAead)
   : m_caProfile(profile)
   , m_type(requestType)
+  , m_ecdh(selectKeyAgreement(profile))
+  , m_aead(selectAead(profile, preferredAead))
   , m_keyChain(keyChain)
 {
 }
@@ -121,6 +197,16 @@ std::shared_ptr<Interest>
 Request::genNewInterest(const Name& keyName,
                         const time::system_clock::time_point& notBefore,
                         const time::system_clock::time_point& notAfter)
+{
+  return genNewInterest(keyName, notBefore, notAfter, "", {});
+}
+
+std::shared_ptr<Interest>
+Request::genNewInterest(const Name& keyName,
+                        const time::system_clock::time_point& notBefore,
+                        const time::system_clock::time_point& notAfter,
+                        const std::string& challengeSelected,
+                        std::multimap<std::string, std::string>&& parameters)
 {
   if (!m_caProfile.caPrefix.isPrefixOf(keyName)) {
     return nullptr;
@@ -128,36 +214,88 @@ Request::genNewInterest(const Name& keyName,
   if (keyName.empty()) {
     return nullptr;
   }
-  else {
-    const auto& pib = m_keyChain.getPib();
-    ndn::security::pib::Identity identity;
-    m_identityName = ndn::security::extractIdentityFromKeyName(keyName);
-    identity = pib.getIdentity(m_identityName);
-    m_keyPair = identity.getKey(keyName);
+  auto certRequest = genCertRequest(keyName, notBefore, notAfter);
+
+  // encrypt the first challenge step to the CA's long-lived ECDH key
+  Block earlyChallenge;
+  if (!challengeSelected.empty()) {
+    if (m_caProfile.ecdhPub.empty()) {
+      NDN_THROW(std::runtime_error("The CA does not accept challenge parameters in NEW requests."));
+    }
+    auto challenge = ChallengeModule::createChallengeModule(challengeSelected);
+    if (challenge == nullptr) {
+      NDN_THROW(std::runtime_error("The challenge selected is not supported by your current version of NDNCERT."));
+    }
+    m_challengeType = challengeSelected;
+    auto challengeParams = challenge->genChallengeRequestTLV(Status::BEFORE_CHALLENGE, "", parameters);
+    auto sharedSecret = m_ecdh.deriveSecret(m_caProfile.ecdhPub);
+    const auto& selfPub = m_ecdh.getSelfPubKey();
+    auto aesKey = deriveEarlyChallengeKey(sharedSecret.data(), sharedSecret.size(),
+                                          selfPub.data(), selfPub.size());
+    const auto& certName = certRequest.getName().wireEncode();
+    auto aeadKey = deriveAeadKey(m_aead, aesKey.data(), certName.data(), certName.size());
+    std::vector<uint8_t> encryptionIv;
+    earlyChallenge = encodeBlockWithAead(m_aead, tlv::EarlyChallenge, aeadKey.data(),
+                                         challengeParams.value(), challengeParams.value_size(),
+                                         certName.data(), certName.size(), encryptionIv);
   }
 
-  // generate certificate request
-  Certificate certRequest;
-  certRequest.setName(Name(keyName).append("cert-request").appendVersion());
-  certRequest.setContentType(ndn::tlv::ContentType_Key);
-  certRequest.setContent(m_keyPair.getPublicKey());
-  SignatureInfo signatureInfo;
-  signatureInfo.setValidityPeriod(ndn::security::ValidityPeriod(notBefore, notAfter));
-  m_keyChain.sign(certRequest, signingByKey(keyName).setSignatureInfo(signatureInfo));
-
   // generate Interest packet
   Name interestName = m_caProfile.caPrefix;
   interestName.append("CA").append("NEW");
   auto interest = std::make_shared<Interest>(interestName);
   interest->setMustBeFresh(true);
   interest->setApplicationParameters(
-    requesttlv::encodeApplicationParameters(RequestType::NEW, m_ecdh.getSelfPubKey(), certRequest));
+    requesttlv::encodeApplicationParameters(RequestType::NEW, m_ecdh.getSelfPubKey(), certRequest,
+                                            earlyChallenge,
+                                            m_presentedTicket ? m_presentedTicket->ticket : Block(),
+                                            m_caProfile.acceptsCompactCertRequest, m_ecdh.getAlgorithm(),
+                                            m_aead));
 
   // sign the Interest packet
   m_keyChain.sign(*interest, signingByKey(keyName));
   return interest;
 }
 
+std::shared_ptr<Interest>
+Request::genRenewInterest(const Certificate& certToRenew, const Name& keyName,
+                          const time::system_clock::time_point& notBefore,
+                          const time::system_clock::time_point& notAfter)
+{
+  if (!m_caProfile.caPrefix.isPrefixOf(certToRenew.getName()) ||
+      certToRenew.getIdentity() != ndn::security::extractIdentityFromKeyName(keyName)) {
+    return nullptr;
+  }
+  auto certRequest = genCertRequest(keyName, notBefore, notAfter);
+
+  // generate Interest packet
+  Name interestName = m_caProfile.caPrefix;
+  interestName.append("CA").append("RENEW");
+  auto interest = std::make_shared<Interest>(interestName);
+  interest->setMustBeFresh(true);
+  interest->setApplicationParameters(renewtlv::encodeApplicationParameters(certRequest, certToRenew));
+
+  // prove the possession of the certificate to renew
+  m_keyChain.sign(*interest, signingByKey(certToRenew.getKeyName()));
+  return interest;
+}
+
+std::shared_ptr<Certificate>
+Request::onRenewResponse(const Data& reply)
+{
+  verifyResponse(reply, m_caProfile, nullptr);
+  processIfError(reply);
+
+  auto issuedCert = std::make_shared<Certificate>(renewtlv::decodeDataContent(reply.getContent()));
+  if (!ndn::security::verifySignature(*issuedCert, *m_caProfile.cert)) {
+    NDN_LOG_ERROR("Cannot verify the renewed certificate.");
+    NDN_THROW(std::runtime_error("Cannot verify the renewed certificate."));
+  }
+  m_status = Status::SUCCESS;
+  m_issuedCertName = issuedCert->getName();
+  return issuedCert;
+}
+
 std::shared_ptr<Interest>
 Request::genRevokeInterest(const Certificate& certificate)
 {
@@ -171,17 +309,16 @@ Request::genRevokeInterest(const Certificate& certificate)
   auto interest = std::make_shared<Interest>(interestName);
   interest->setMustBeFresh(true);
   interest->setApplicationParameters(
-    requesttlv::encodeApplicationParameters(RequestType::REVOKE, m_ecdh.getSelfPubKey(), certificate));
+    requesttlv::encodeApplicationParameters(RequestType::REVOKE, m_ecdh.getSelfPubKey(), certificate, Block(),
+                                            m_presentedTicket ? m_presentedTicket->ticket : Block(), false,
+                                            m_ecdh.getAlgorithm(), m_aead));
   return interest;
 }
 
 std::list<std::string>
 Request::onNewRenewRevokeResponse(const Data& reply)
 {
-  if (!ndn::security::verifySignature(reply, *m_caProfile.cert)) {
-    NDN_LOG_ERROR("Cannot verify replied Data packet signature.");
-    NDN_THROW(std::runtime_error("Cannot verify replied Data packet signature."));
-  }
+  verifyResponse(reply, m_caProfile, nullptr);
   processIfError(reply);
 
   const auto& contentTLV = reply.getContent();
@@ -189,16 +326,44 @@ Request::onNewRenewRevokeResponse(const Data& reply)
   std::array<uint8_t, 32> salt;
   auto challenges = requesttlv::decodeDataContent(contentTLV, ecdhKey, salt, m_requestId);
 
-  // ECDH and HKDF
-  auto sharedSecret = m_ecdh.deriveSecret(ecdhKey);
-  hkdf(sharedSecret.data(), sharedSecret.size(),
-       salt.data(), salt.size(), m_aesKey.data(), m_aesKey.size(),
-       m_requestId.data(), m_requestId.size());
+  // ECDH and HKDF, or HKDF only if the CA has accepted the resumption ticket
+  if (ecdhKey.empty()) {
+    if (!m_presentedTicket) {
+      NDN_THROW(std::runtime_error("The CA reply carries no ECDH public key."));
+    }
+    const auto& secret = m_presentedTicket->secret;
+    hkdf(secret.data(), secret.size(),
+         salt.data(), salt.size(), m_aesKey.data(), m_aesKey.size(),
+         m_requestId.data(), m_requestId.size());
+  }
+  else {
+    auto sharedSecret = m_ecdh.deriveSecret(ecdhKey);
+    hkdf(sharedSecret.data(), sharedSecret.size(),
+         salt.data(), salt.size(), m_aesKey.data(), m_aesKey.size(),
+         m_requestId.data(), m_requestId.size());
+  }
+  m_aeadKey = deriveAeadKey(m_aead, m_aesKey.data(), m_requestId.data(), m_requestId.size());
 
   // update state
+  auto earlyChallenge = contentTLV.find(tlv::EarlyChallenge);
+  if (earlyChallenge != contentTLV.elements_end()) {
+    challengetlv::decodeDataContent(*earlyChallenge, *this);
+    checkIssuedCertificate();
+  }
   return challenges;
 }
 
+std::optional<ResumptionTicket>
+Request::getResumptionTicket() const
+{
+  if (m_status != Status::SUCCESS || !m_resumptionTicket.isValid()) {
+    return std::nullopt;
+  }
+  return ResumptionTicket{m_resumptionTicket,
+                          deriveResumptionSecret(m_aesKey.data(), m_aesKey.size(),
+                                                 m_requestId.data(), m_requestId.size())};
+}
+
 std::multimap<std::string, std::string>
 Request::selectOrContinueChallenge(const std::string& challengeSelected)
 {
@@ -228,10 +393,13 @@ Request::genChallengeInterest(std::multimap<std::string, std::string>&& paramete
   interest->setMustBeFresh(true);
 
   // encrypt the Interest parameters
-  auto paramBlock = encodeBlockWithAesGcm128(ndn::tlv::ApplicationParameters, m_aesKey.data(),
-                                             challengeParams.value(), challengeParams.value_size(),
-                                             m_requestId.data(), m_requestId.size(),
-                                             m_encryptionIv);
+  auto paramBlock = encodeBlockWithAead(m_aead, ndn::tlv::ApplicationParameters, m_aeadKey.data(),
+                                        challengeParams.value(), challengeParams.value_size(),
+                                        m_requestId.data(), m_requestId.size(),
+                                        m_encryptionIv);
+  // accept intermediate responses signed with the session key
+  paramBlock.push_back(ndn::makeEmptyBlock(tlv::SessionSigning));
+  paramBlock.encode();
   interest->setApplicationParameters(paramBlock);
   m_keyChain.sign(*interest, signingByKey(m_keyPair.getName()));
   return interest;
@@ -240,12 +408,17 @@ Request::genChallengeInterest(std::multimap<std::string, std::string>&& paramete
 void
 Request::onChallengeResponse(const Data& reply)
 {
-  if (!ndn::security::verifySignature(reply, *m_caProfile.cert)) {
-    NDN_LOG_ERROR("Cannot verify replied Data packet signature.");
-    NDN_THROW(std::runtime_error("Cannot verify replied Data packet signature."));
-  }
+  verifyResponse(reply, m_caProfile, this);
   processIfError(reply);
   challengetlv::decodeDataContent(reply.getContent(), *this);
+  // the session key only vouches for intermediate steps, the issuance must come from the CA key
+  if (m_status == Status::SUCCESS && reply.getSignatureType() == ndn::tlv::SignatureHmacWithSha256) {
+    m_status = Status::FAILURE;
+    m_issuedCert = nullptr;
+    NDN_LOG_ERROR("The CA did not sign the issuance with its key.");
+    NDN_THROW(std::runtime_error("The CA did not sign the issuance with its key."));
+  }
+  checkIssuedCertificate();
 }
 
 std::shared_ptr<Interest>
@@ -270,18 +443,104 @@ Request::onCertFetchResponse(const Data& reply)
   }
 }
 
+void
+Request::checkIssuedCertificate()
+{
+  if (m_issuedCert != nullptr &&
+      (m_issuedCert->getName() != m_issuedCertName ||
+       !ndn::security::verifySignature(*m_issuedCert, *m_caProfile.cert))) {
+    m_issuedCert = nullptr;
+    NDN_LOG_ERROR("Cannot verify the issued certificate.");
+    NDN_THROW(std::runtime_error("Cannot verify the issued certificate."));
+  }
+}
+
+Certificate
+Request::genCertRequest(const Name& keyName,
+                        const time::system_clock::time_point& notBefore,
+                        const time::system_clock::time_point& notAfter)
+{
+  const auto& pib = m_keyChain.getPib();
+  m_identityName = ndn::security::extractIdentityFromKeyName(keyName);
+  m_keyPair = pib.getIdentity(m_identityName).getKey(keyName);
+
+  Certificate certRequest;
+  certRequest.setName(Name(keyName).append("cert-request").appendVersion());
+  certRequest.setContentType(ndn::tlv::ContentType_Key);
+  certRequest.setContent(m_keyPair.getPublicKey());
+  SignatureInfo signatureInfo;
+  signatureInfo.setValidityPeriod(ndn::security::ValidityPeriod(notBefore, notAfter));
+  m_keyChain.sign(certRequest, signingByKey(keyName).setSignatureInfo(signatureInfo));
+  return certRequest;
+}
+
+time::milliseconds
+Request::getRetryDelay(size_t attempt, time::milliseconds retryAfter)
+{
+  const time::milliseconds baseDelay = 500_ms;
+  const time::milliseconds maxBackoff = 60_s;
+  // the CA's hint may come from an unauthenticated overload reply
+  const time::milliseconds maxRetryAfter = 60_s;
+
+  auto backoff = maxBackoff;
+  if (attempt < 7) {
+    backoff = std::min(baseDelay * (1 << attempt), maxBackoff);
+  }
+  std::uniform_int_distribution<time::milliseconds::rep> dist(0, backoff.count());
+  return std::clamp(retryAfter, 0_ms, maxRetryAfter) +
+         time::milliseconds(dist(ndn::random::getRandomNumberEngine()));
+}
+
 void
 Request::processIfError(const Data& data)
 {
-  auto errorInfo = errortlv::decodefromDataContent(data.getContent());
-  if (std::get<0>(errorInfo) == ErrorCode::NO_ERROR) {
+  auto [errorCode, errorInfo, retryAfter] = errortlv::decodefromDataContent(data.getContent());
+  if (errorCode == ErrorCode::NO_ERROR) {
     return;
   }
-  NDN_LOG_ERROR("Error info replied from the CA with Error code: " << std::get<0>(errorInfo) <<
-                " and Error Info: " << std::get<1>(errorInfo));
-  NDN_THROW(std::runtime_error("Error info replied from the CA with Error code: " +
-                               boost::lexical_cast<std::string>(std::get<0>(errorInfo)) +
-                               " and Error Info: " + std::get<1>(errorInfo)));
+  NDN_LOG_ERROR("Error info replied from the CA with Error code: " << errorCode <<
+                " and Error Info: " << errorInfo);
+  auto what = "Error info replied from the CA with Error code: " +
+              boost::lexical_cast<std::string>(errorCode) + " and Error Info: " + errorInfo;
+  if (retryAfter || errorCode == ErrorCode::SERVICE_UNAVAILABLE) {
+    NDN_THROW(RetryAfterError(what, retryAfter.value_or(0_ms)));
+  }
+  NDN_THROW(std::runtime_error(what));
+}
+
+void
+Request::verifyResponse(const Data& reply, const CaProfile& ca, const Request* session)
+{
+  switch (reply.getSignatureType()) {
+    case ndn::tlv::DigestSha256:
+      // only errors may be signed without a key, and only by a CA that announced it, except
+      // overload replies, which are always signed this way and only delay the request
+      if (ndn::security::verifyDigest(reply, ndn::DigestAlgorithm::SHA256)) {
+        auto errorCode = std::get<0>(errortlv::decodefromDataContent(reply.getContent()));
+        if (ca.signsErrorsWithDigest || errorCode == ErrorCode::SERVICE_UNAVAILABLE) {
+          processIfError(reply);
+        }
+      }
+      break;
+    case ndn::tlv::SignatureHmacWithSha256:
+      // within a session, the CA may sign errors and intermediate CHALLENGE responses this way;
+      // onChallengeResponse() rejects a SUCCESS status signed this way once decrypted
+      if (session != nullptr) {
+        auto hmacKey = deriveSessionHmacKey(session->m_aesKey.data(), session->m_aesKey.size(),
+                                            session->m_requestId.data(), session->m_requestId.size());
+        if (verifyDataWithHmacSha256(reply, hmacKey.data(), hmacKey.size())) {
+          return;
+        }
+      }
+      break;
+    default:
+      if (ndn::security::verifySignature(reply, *ca.cert)) {
+        return;
+      }
+      break;
+  }
+  NDN_LOG_ERROR("Cannot verify replied Data packet signature.");
+  NDN_THROW(std::runtime_error("Cannot verify replied Data packet signature."));
 }
 
 } // namespace ndncert::requester
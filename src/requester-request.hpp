@@ -27,8 +27,46 @@
 
 #include <ndn-cxx/security/key-chain.hpp>
 
+#include <optional>
+
 namespace ndncert::requester {
 
+/**
+ * @brief Thrown when the CA rejects a request only temporarily, e.g., because it is overloaded.
+ *
+ * The same request can be sent again after waiting for at least getRetryAfter().
+ */
+class RetryAfterError : public std::runtime_error
+{
+public:
+  RetryAfterError(const std::string& what, time::milliseconds retryAfter)
+    : std::runtime_error(what)
+    , m_retryAfter(retryAfter)
+  {
+  }
+
+  time::milliseconds
+  getRetryAfter() const
+  {
+    return m_retryAfter;
+  }
+
+private:
+  time::milliseconds m_retryAfter;
+};
+
+/**
+ * @brief A resumption ticket issued by a CA, with the secret the requester derived for it.
+ */
+struct ResumptionTicket
+{
+  /**
+   * @brief The ResumptionTicket element, opaque to the requester.
+   */
+  Block ticket;
+  std::array<uint8_t, 32> secret;
+};
+
 class Request : boost::noncopyable
 {
 public:
@@ -50,6 +88,16 @@ public:
   static std::shared_ptr<Interest>
   genCaProfileInterestFromDiscoveryResponse(const Data& reply);
 
+  /**
+   * @brief Generates the Interest fetching the CA profile segment that follows @p reply.
+   *
+   * @param reply A CA profile segment.
+   * @return A shared pointer to an Interest ready to be sent, or nullptr if @p reply is the
+   *         last segment.
+   */
+  static std::shared_ptr<Interest>
+  genCaProfileSegmentInterest(const Data& reply);
+
   /**
    * @brief Decodes the CA profile from the replied CA profile Data packet.
    *
@@ -63,6 +111,18 @@ public:
   static std::optional<CaProfile>
   onCaProfileResponse(const Data& reply);
 
+  /**
+   * @brief Decodes the CA profile from all the segments of a segmented CA profile.
+   *
+   * Will first verify the signature of every segment using the key provided inside the profile.
+   *
+   * @param segments The CA profile segments, in order.
+   * @return the CaProfile if decoding is successful
+   * @throw std::runtime_error if the segments are incomplete or the decoding fails.
+   */
+  static std::optional<CaProfile>
+  onCaProfileResponse(const std::vector<Data>& segments);
+
   /**
    * @brief Decodes the CA profile from the replied CA profile Data packet after the redirection.
    *
@@ -78,6 +138,18 @@ public:
   static std::optional<CaProfile>
   onCaProfileResponseAfterRedirection(const Data& reply, const Name& caCertFullName);
 
+  /**
+   * @brief Decodes the CA profile from all the segments of a segmented CA profile after the
+   *        redirection.
+   *
+   * @param segments The CA profile segments, in order.
+   * @param caCertFullName The full name obtained from original CA's probe response.
+   * @return the CaProfile if decoding is successful
+   * @throw std::runtime_error if the segments are incomplete or the decoding fails.
+   */
+  static std::optional<CaProfile>
+  onCaProfileResponseAfterRedirection(const std::vector<Data>& segments, const Name& caCertFullName);
+
   /**
    * @brief Generates a PROBE interest to the CA (for suggested name assignments).
    *
@@ -97,19 +169,28 @@ public:
    * @param ca the profile of the CA that replies the packet
    * @param identityNames The vector to load the decoded identity names from the data.
    * @param otherCas The vector to load the decoded redirection CA prefixes from the data.
+   * @throw RetryAfterError if the CA asks to retry the request later.
    * @throw std::runtime_error if the decoding fails or receiving an error packet.
    */
   static void
   onProbeResponse(const Data& reply, const CaProfile& ca,
                   std::vector<std::pair<Name, int>>& identityNames, std::vector<Name>& otherCas);
 
+  /**
+   * @param preferredAead The AEAD algorithm to use for the session if the CA profile announces
+   *                      it, e.g., ChaCha20-Poly1305 on devices without AES hardware.
+   *                      AES-128-GCM is used otherwise.
+   */
   explicit
-  Request(ndn::KeyChain& keyChain, const CaProfile& profile, RequestType requestType);
+  Request(ndn::KeyChain& keyChain, const CaProfile& profile, RequestType requestType,
+          AeadAlgorithm preferredAead = AeadAlgorithm::AES_128_GCM);
 
   // NEW/REVOKE/RENEW related helpers
   /**
    * @brief Generates a NEW interest to the CA.
    *
+   * If the CA profile announces it, the certificate request is sent in the compact format.
+   *
    * @param state The current requester state for this request. Will be modified in the function.
    * @param keyName The key name to be requested.
    * @param notBefore The expected notBefore field for the certificate (starting time)
@@ -121,6 +202,58 @@ public:
                  const time::system_clock::time_point& notBefore,
                  const time::system_clock::time_point& notAfter);
 
+  /**
+   * @brief Generates a NEW interest to the CA, carrying the first step of a challenge.
+   *
+   * The challenge parameters are encrypted to the ECDH key in the CA profile, so that the CA
+   * can handle the NEW request and the first CHALLENGE step in one exchange. After
+   * onNewRenewRevokeResponse(), m_status tells whether the CA did; if it is still
+   * BEFORE_CHALLENGE, the same step must be sent with genChallengeInterest().
+   *
+   * @param keyName The key name to be requested.
+   * @param notBefore The expected notBefore field for the certificate (starting time)
+   * @param notAfter The expected notAfter field for the certificate (expiration time)
+   * @param challengeSelected The selected challenge for the request.
+   * @param parameters The parameters of the first step of the challenge, in name, value mapping.
+   * @return The shared pointer to the encoded interest.
+   * @throw std::runtime_error if the CA does not publish an ECDH key or the challenge is not supported.
+   */
+  std::shared_ptr<Interest>
+  genNewInterest(const Name& keyName,
+                 const time::system_clock::time_point& notBefore,
+                 const time::system_clock::time_point& notAfter,
+                 const std::string& challengeSelected,
+                 std::multimap<std::string, std::string>&& parameters);
+
+  /**
+   * @brief Generates a RENEW interest to the CA.
+   *
+   * The Interest is signed with @p certToRenew, which must be a currently valid certificate
+   * issued by the CA. The CA then issues the renewed certificate without any challenge.
+   *
+   * @param certToRenew The certificate to renew.
+   * @param keyName The key of the renewed certificate, of the same identity as @p certToRenew.
+   *                It may be the key of @p certToRenew.
+   * @param notBefore The expected notBefore field for the certificate (starting time)
+   * @param notAfter The expected notAfter field for the certificate (expiration time)
+   * @return The shared pointer to the encoded interest.
+   */
+  std::shared_ptr<Interest>
+  genRenewInterest(const Certificate& certToRenew, const Name& keyName,
+                   const time::system_clock::time_point& notBefore,
+                   const time::system_clock::time_point& notAfter);
+
+  /**
+   * @brief Decodes the replied data of RENEW interest from the CA.
+   *
+   * @param reply The replied data from the network
+   * @return The renewed certificate.
+   * @throw RetryAfterError if the CA asks to retry the request later.
+   * @throw std::runtime_error if the decoding fails or receiving an error packet.
+   */
+  std::shared_ptr<Certificate>
+  onRenewResponse(const Data& reply);
+
   /**
    * @brief Generates a REVOKE interest to the CA.
    *
@@ -130,11 +263,36 @@ public:
   std::shared_ptr<Interest>
   genRevokeInterest(const Certificate& certificate);
 
+  /**
+   * @brief Present a resumption ticket with the NEW or REVOKE interest.
+   *
+   * The ticket must have been issued for the key of the request. If the CA accepts it, the
+   * session key is derived from the ticket secret instead of an ECDH exchange; otherwise, the
+   * request proceeds with ECDH as usual.
+   */
+  void
+  setResumptionTicket(const ResumptionTicket& ticket)
+  {
+    m_presentedTicket = ticket;
+  }
+
+  /**
+   * @brief Get the resumption ticket issued with the certificate, if any.
+   *
+   * Only available once the challenge has succeeded.
+   */
+  std::optional<ResumptionTicket>
+  getResumptionTicket() const;
+
   /**
    * @brief Decodes the replied data of NEW, RENEW, or REVOKE interest from the CA.
    *
+   * If the reply carries the result of a challenge step sent with the NEW interest, the state
+   * of the request is updated as by onChallengeResponse().
+   *
    * @param reply The replied data from the network
    * @return the list of challenge accepted by the CA, for CHALLENGE step.
+   * @throw RetryAfterError if the CA asks to retry the request later.
    * @throw std::runtime_error if the decoding fails or receiving an error packet.
    */
   std::list<std::string>
@@ -166,6 +324,7 @@ public:
    * @brief Decodes the responded data from the CHALLENGE interest.
    *
    * @param reply The response data.
+   * @throw RetryAfterError if the CA asks to retry the request later.
    * @throw std::runtime_error if the decoding fails or receiving an error packet.
    */
   void
@@ -188,10 +347,52 @@ public:
   static std::shared_ptr<Certificate>
   onCertFetchResponse(const Data& reply);
 
+  /**
+   * @brief Computes how long to wait before re-sending a request, using jittered exponential backoff.
+   *
+   * The delay is @p retryAfter plus a random duration of up to 2^attempt times the base delay,
+   * capped at one minute, so that requesters turned away together do not retry together.
+   *
+   * @param attempt The number of times the request has already been retried.
+   * @param retryAfter The minimum delay requested by the CA, if any, of which at most one minute
+   *                   is honored.
+   */
+  static time::milliseconds
+  getRetryDelay(size_t attempt, time::milliseconds retryAfter = 0_ms);
+
 private:
+  /**
+   * @brief Generates a self-signed certificate request for @p keyName, which becomes the key
+   *        of this request.
+   */
+  Certificate
+  genCertRequest(const Name& keyName,
+                 const time::system_clock::time_point& notBefore,
+                 const time::system_clock::time_point& notAfter);
+
+  /**
+   * @brief Check that the certificate delivered with the challenge result, if any, is the one
+   *        named in the result and is signed by the CA.
+   * @throw std::runtime_error the check fails.
+   */
+  void
+  checkIssuedCertificate();
+
   static void
   processIfError(const Data& data);
 
+  /**
+   * @brief Verify the signature of a reply from the CA.
+   *
+   * Besides the CA key, error replies may be signed with a plain SHA-256 digest if @p ca
+   * announces it, and SERVICE_UNAVAILABLE replies always may; errors carried by such replies are
+   * thrown as by processIfError(). If @p session is not nullptr, replies may also be signed with
+   * its HMAC key.
+   * @throw std::runtime_error the signature cannot be verified.
+   */
+  static void
+  verifyResponse(const Data& reply, const CaProfile& ca, const Request* session);
+
 public:
   /**
    * @brief The CA profile for this request.
@@ -233,18 +434,32 @@ public:
    * @brief the name of the certificate being issued.
    */
   Name m_issuedCertName;
+  /**
+   * @brief The issued certificate, if the CA has delivered it with the challenge result.
+   *
+   * Otherwise, it must be fetched with genCertFetchInterest().
+   */
+  std::shared_ptr<Certificate> m_issuedCert;
   /**
    * @brief The optional forwarding hint.
    */
   Name m_forwardingHint;
   /**
-   * @brief ecdh state.
+   * @brief ecdh state, using X25519 if the CA profile announces it, P-256 otherwise.
    */
   ECDHState m_ecdh;
   /**
    * @brief AES key derived from the ecdh shared secret.
    */
   std::array<uint8_t, 16> m_aesKey = {};
+  /**
+   * @brief AEAD algorithm of the session, keyed by m_aeadKey.
+   */
+  AeadAlgorithm m_aead;
+  /**
+   * @brief Key of m_aead, derived from m_aesKey once the request ID is known.
+   */
+  std::array<uint8_t, 32> m_aeadKey = {};
   /**
    * @brief The last Initialization Vector used by the AES encryption.
    */
@@ -257,6 +472,10 @@ public:
    * @brief Store Nonce for signature
    */
   std::array<uint8_t, 16> m_nonce = {};
+  /**
+   * @brief The resumption ticket issued with the certificate, if any.
+   */
+  Block m_resumptionTicket;
 
 private:
   /**
@@ -267,6 +486,10 @@ private:
    * @brief The keypair for the request.
    */
   ndn::security::Key m_keyPair;
+  /**
+   * @brief The resumption ticket presented with the NEW or REVOKE interest.
+   */
+  std::optional<ResumptionTicket> m_presentedTicket;
 };
 
 } // namespace ndncert::requester
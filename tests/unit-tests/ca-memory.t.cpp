@@ -48,6 +48,9 @@ BOOST_AUTO_TEST_CASE(RequestOperations)
 
   // get operation
   auto result = storage.getRequest(requestId);
+  BOOST_CHECK(storage.findRequest(requestId).has_value());
+  BOOST_CHECK(!storage.findRequest({{100}}).has_value());
+  BOOST_CHECK_THROW(storage.getRequest({{100}}), std::runtime_error);
   BOOST_CHECK_EQUAL(request1.cert, result.cert);
   BOOST_CHECK(request1.status == result.status);
   BOOST_CHECK_EQUAL(request1.caPrefix, result.caPrefix);
@@ -92,6 +95,21 @@ BOOST_AUTO_TEST_CASE(RequestOperations)
   BOOST_CHECK_EQUAL(allRequests.size(), 1);
 }
 
+BOOST_AUTO_TEST_CASE(UsedTokens)
+{
+  CaMemory storage;
+  storage.m_pruneThreshold = 2;
+  auto now = time::system_clock::now();
+  BOOST_CHECK(storage.addUsedToken(1, now - 1_s));
+  BOOST_CHECK(storage.addUsedToken(2, now + 10_min));
+  BOOST_CHECK(!storage.addUsedToken(2, now + 10_min));
+  // the expired token is forgotten once the threshold is reached
+  BOOST_CHECK(storage.addUsedToken(3, now + 10_min));
+  BOOST_CHECK_EQUAL(storage.m_usedTokens.size(), 2);
+  BOOST_CHECK_EQUAL(storage.m_usedTokens.count(1), 0);
+  BOOST_CHECK_EQUAL(storage.m_pruneThreshold, 1024);
+}
+
 BOOST_AUTO_TEST_SUITE_END() // TestCaMemory
 
 } // namespace ndncert::tests
@@ -19,7 +19,11 @@
  */
 
 #include "ca-module.hpp"
+#include "challenge/challenge-email.hpp"
+#include "challenge/challenge-external.hpp"
 #include "challenge/challenge-pin.hpp"
+#include "detail/crypto-helpers.hpp"
+#include "detail/error-encoder.hpp"
 #include "detail/info-encoder.hpp"
 #include "requester-request.hpp"
 
@@ -31,11 +35,34 @@
 #include <ndn-cxx/security/verification-helpers.hpp>
 #include <ndn-cxx/util/dummy-client-face.hpp>
 
+#include <condition_variable>
+#include <mutex>
+
 namespace ndncert::tests {
 
 using namespace ca;
 using ndn::security::verifySignature;
 
+/**
+ * @brief PIN challenge whose requests complete only when the test says so.
+ */
+class DeferredPinChallenge : public ChallengePin
+{
+public:
+  void
+  handleChallengeRequestAsync(const Block& params, std::shared_ptr<RequestState> request,
+                              boost::asio::io_context&, CompletionCallback onComplete) final
+  {
+    pending.push_back([this, params, request, onComplete] {
+      auto [errorCode, errorInfo] = handleChallengeRequest(params, *request);
+      onComplete(errorCode, errorInfo);
+    });
+  }
+
+public:
+  std::vector<std::function<void()>> pending;
+};
+
 BOOST_FIXTURE_TEST_SUITE(TestCaModule, IoKeyChainFixture)
 
 BOOST_AUTO_TEST_CASE(Initialization)
@@ -49,6 +76,26 @@ BOOST_AUTO_TEST_CASE(Initialization)
   BOOST_CHECK_EQUAL(ca.m_interestFilterHandles.size(), 5);  // infoMeta, onProbe, onNew, onChallenge, onRevoke
 }
 
+BOOST_AUTO_TEST_CASE(ChallengeModulesFromConfig)
+{
+  ndn::DummyClientFace face(m_io, m_keyChain, {true, true});
+  CaModule ca(face, m_keyChain, "tests/unit-tests/config-files/config-ca-7", "ca-storage-memory");
+  BOOST_REQUIRE_EQUAL(ca.m_challengeModules.size(), 2);
+  BOOST_CHECK_EQUAL(ca.m_challengeModules.count("pin"), 1);
+  BOOST_CHECK_EQUAL(ca.m_challengeModules.count("email"), 1);
+
+  // modules are created once and configured from the challenge-config section
+  const auto* pin = ca.m_challengeModules.at("pin").get();
+  RequestState request;
+  request.caPrefix = Name("/ndn");
+  request.requestId = {{101}};
+  request.requestType = RequestType::NEW;
+  ca.m_challengeModules.at("pin")->handleChallengeRequest(ndn::makeEmptyBlock(tlv::EncryptedPayload), request);
+  BOOST_CHECK_EQUAL(request.challengeState->remainingTries, 5);
+  BOOST_CHECK_EQUAL(request.challengeState->remainingTime, time::seconds(60));
+  BOOST_CHECK_EQUAL(ca.m_challengeModules.at("pin").get(), pin);
+}
+
 BOOST_AUTO_TEST_CASE(HandleProfileFetching)
 {
   auto identity = m_keyChain.createIdentity(Name("/ndn"));
@@ -102,6 +149,75 @@ BOOST_AUTO_TEST_CASE(HandleProfileFetching)
   BOOST_CHECK_EQUAL(count, 2);
 }
 
+BOOST_AUTO_TEST_CASE(HandleProfileDiscoveryFromCache)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn"));
+  auto cert = identity.getDefaultKey().getDefaultCertificate();
+
+  ndn::DummyClientFace face(m_io, m_keyChain, {true, true});
+  CaModule ca(face, m_keyChain, "tests/unit-tests/config-files/config-ca-1", "ca-storage-memory");
+  advanceClocks(time::milliseconds(20), 60);
+
+  std::vector<Block> responses;
+  face.onSendData.connect([&](const Data& response) {
+    BOOST_CHECK(verifySignature(response, cert));
+    responses.push_back(response.wireEncode());
+  });
+
+  Interest interest = ndn::MetadataObject::makeDiscoveryInterest(Name("/ndn/CA/INFO"));
+  face.receive(interest);
+  advanceClocks(time::milliseconds(20), 5);
+  face.receive(interest);
+  advanceClocks(time::milliseconds(20), 5);
+  BOOST_REQUIRE_EQUAL(responses.size(), 2);
+  // served from memory, without signing again
+  BOOST_CHECK_EQUAL(responses[0], responses[1]);
+
+  // signed again once the freshness period has passed
+  advanceClocks(time::milliseconds(20), 60);
+  face.receive(interest);
+  advanceClocks(time::milliseconds(20), 5);
+  BOOST_REQUIRE_EQUAL(responses.size(), 3);
+  BOOST_CHECK_NE(responses[0], responses[2]);
+  BOOST_CHECK_EQUAL(ndn::MetadataObject(Data(responses[0])).getVersionedName(),
+                    ndn::MetadataObject(Data(responses[2])).getVersionedName());
+}
+
+BOOST_AUTO_TEST_CASE(HandleSegmentedProfile)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn"));
+  auto cert = identity.getDefaultKey().getDefaultCertificate();
+
+  ndn::DummyClientFace face(m_io, m_keyChain, {true, true});
+  CaModule ca(face, m_keyChain, "tests/unit-tests/config-files/config-ca-1", "ca-storage-memory");
+  ca.m_config.profileSegmentSize = 100;
+  const auto& segments = ca.getCaProfileSegments();
+  BOOST_REQUIRE_GT(segments.size(), 1);
+  BOOST_CHECK_EQUAL(ca.getCaProfileData().wireEncode(), segments.front().wireEncode());
+
+  // follow the segments as a requester would
+  std::vector<Data> received{segments.front()};
+  for (auto interest = requester::Request::genCaProfileSegmentInterest(received.back()); interest != nullptr;
+       interest = requester::Request::genCaProfileSegmentInterest(received.back())) {
+    auto it = std::find_if(segments.begin(), segments.end(),
+                           [&] (const Data& segment) { return interest->matchesData(segment); });
+    BOOST_REQUIRE(it != segments.end());
+    received.push_back(*it);
+  }
+  BOOST_CHECK_EQUAL(received.size(), segments.size());
+
+  auto profile = requester::Request::onCaProfileResponse(received);
+  BOOST_CHECK_EQUAL(profile->caPrefix, "/ndn");
+  BOOST_CHECK_EQUAL(profile->caInfo, "ndn testbed ca");
+  BOOST_CHECK_EQUAL(profile->cert->wireEncode(), cert.wireEncode());
+
+  // incomplete or reordered segments are rejected
+  received.pop_back();
+  BOOST_CHECK_THROW(requester::Request::onCaProfileResponse(received), std::runtime_error);
+  std::vector<Data> reordered(segments.rbegin(), segments.rend());
+  BOOST_CHECK_THROW(requester::Request::onCaProfileResponse(reordered), std::runtime_error);
+}
+
 BOOST_AUTO_TEST_CASE(HandleProbe)
 {
   auto identity = m_keyChain.createIdentity(Name("/ndn"));
@@ -137,6 +253,106 @@ BOOST_AUTO_TEST_CASE(HandleProbe)
   BOOST_CHECK_EQUAL(count, 1);
 }
 
+BOOST_AUTO_TEST_CASE(HandleProbeFromCache)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn"));
+  auto key = identity.getDefaultKey();
+  auto cert = key.getDefaultCertificate();
+
+  ndn::DummyClientFace face(m_io, m_keyChain, {true, true});
+  CaModule ca(face, m_keyChain, "tests/unit-tests/config-files/config-ca-1", "ca-storage-memory");
+  advanceClocks(time::milliseconds(20), 60);
+
+  Interest interest("/ndn/CA/PROBE");
+  Block paramTLV = ndn::makeEmptyBlock(ndn::tlv::ApplicationParameters);
+  paramTLV.push_back(ndn::makeStringBlock(tlv::ParameterKey, "name"));
+  paramTLV.push_back(ndn::makeStringBlock(tlv::ParameterValue, "zhiyi"));
+  paramTLV.encode();
+  interest.setApplicationParameters(paramTLV);
+  interest.setMustBeFresh(true);
+
+  std::vector<Block> responses;
+  face.onSendData.connect([&](const Data& response) {
+    BOOST_CHECK(verifySignature(response, cert));
+    responses.push_back(response.wireEncode());
+  });
+
+  // the second PROBE is answered from the cache
+  face.receive(interest);
+  face.receive(interest);
+  advanceClocks(time::milliseconds(20), 5);
+  BOOST_REQUIRE_EQUAL(responses.size(), 2);
+  BOOST_CHECK_EQUAL(responses[0], responses[1]);
+  BOOST_CHECK_EQUAL(ca.getProbeCacheStats().nHits, 1);
+  BOOST_CHECK_EQUAL(ca.getProbeCacheStats().nMisses, 1);
+
+  // reloading the configuration empties the cache
+  ca.reload();
+  BOOST_CHECK_EQUAL(ca.m_probeCache.size(), 0);
+  face.receive(interest);
+  advanceClocks(time::milliseconds(20), 5);
+  BOOST_CHECK_EQUAL(responses.size(), 3);
+  BOOST_CHECK_EQUAL(ca.getProbeCacheStats().nMisses, 2);
+
+  // responses are not kept beyond their freshness period
+  advanceClocks(time::milliseconds(20), 60);
+  face.receive(interest);
+  advanceClocks(time::milliseconds(20), 5);
+  BOOST_CHECK_EQUAL(responses.size(), 4);
+  BOOST_CHECK_EQUAL(ca.getProbeCacheStats().nHits, 1);
+  BOOST_CHECK_EQUAL(ca.getProbeCacheStats().nMisses, 3);
+}
+
+BOOST_AUTO_TEST_CASE(HandleOverload)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn"));
+  auto key = identity.getDefaultKey();
+  auto cert = key.getDefaultCertificate();
+
+  ndn::DummyClientFace face(m_io, m_keyChain, {true, true});
+  CaModule ca(face, m_keyChain, "tests/unit-tests/config-files/config-ca-1", "ca-storage-memory");
+  ca.m_scheduler.setOptions({1, {1, 1, 1, 1}});
+  advanceClocks(time::milliseconds(20), 60);
+
+  auto makeProbeInterest = [] (const std::string& value) {
+    Interest interest("/ndn/CA/PROBE");
+    Block paramTLV = ndn::makeEmptyBlock(ndn::tlv::ApplicationParameters);
+    paramTLV.push_back(ndn::makeStringBlock(tlv::ParameterKey, "name"));
+    paramTLV.push_back(ndn::makeStringBlock(tlv::ParameterValue, value));
+    paramTLV.encode();
+    interest.setApplicationParameters(paramTLV);
+    return interest;
+  };
+
+  auto profile = *requester::Request::onCaProfileResponse(ca.getCaProfileData());
+  int nAnswered = 0;
+  int nRejected = 0;
+  face.onSendData.connect([&](const Data& response) {
+    auto [errorCode, errorInfo, retryAfter] = errortlv::decodefromDataContent(response.getContent());
+    if (errorCode == ErrorCode::SERVICE_UNAVAILABLE) {
+      nRejected++;
+      BOOST_CHECK(retryAfter.has_value());
+      // shed replies cost no signature with the CA key, but requesters still accept them
+      BOOST_CHECK_EQUAL(response.getSignatureType(), ndn::tlv::DigestSha256);
+      std::vector<std::pair<Name, int>> ids;
+      std::vector<Name> cas;
+      BOOST_CHECK_THROW(requester::Request::onProbeResponse(response, profile, ids, cas),
+                        requester::RetryAfterError);
+    }
+    else {
+      nAnswered++;
+      BOOST_CHECK(verifySignature(response, cert));
+    }
+  });
+  // the queue holds a single Interest, so the second PROBE is shed
+  face.receive(makeProbeInterest("zhiyi"));
+  face.receive(makeProbeInterest("alice"));
+
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_CHECK_EQUAL(nAnswered, 1);
+  BOOST_CHECK_EQUAL(nRejected, 1);
+}
+
 BOOST_AUTO_TEST_CASE(HandleProbeUsingDefaultHandler)
 {
   auto identity = m_keyChain.createIdentity(Name("/ndn"));
@@ -263,6 +479,121 @@ BOOST_AUTO_TEST_CASE(HandleNew)
   BOOST_CHECK_EQUAL(count, 1);
 }
 
+BOOST_AUTO_TEST_CASE(HandleCompactNew)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn"));
+  auto cert = identity.getDefaultKey().getDefaultCertificate();
+
+  ndn::DummyClientFace face(m_io, m_keyChain, {true, true});
+  CaModule ca(face, m_keyChain, "tests/unit-tests/config-files/config-ca-1", "ca-storage-memory");
+  advanceClocks(time::milliseconds(20), 60);
+
+  // the support is announced in the profile
+  auto profile = *requester::Request::onCaProfileResponse(ca.getCaProfileData());
+  BOOST_CHECK(profile.acceptsCompactCertRequest);
+
+  std::vector<Data> responses;
+  face.onSendData.connect([&](const Data& response) { responses.push_back(response); });
+
+  requester::Request state(m_keyChain, profile, RequestType::NEW);
+  auto keyName = m_keyChain.createIdentity(Name("/ndn/zhiyi")).getDefaultKey().getName();
+  auto interest = state.genNewInterest(keyName, time::system_clock::now(), time::system_clock::now() + time::days(1));
+  auto params = interest->getApplicationParameters();
+  params.parse();
+  BOOST_CHECK(params.find(tlv::CompactCertRequest) != params.elements_end());
+  BOOST_CHECK(params.find(tlv::CertRequest) == params.elements_end());
+
+  face.receive(*interest);
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 1);
+  state.onNewRenewRevokeResponse(responses.back());
+  auto request = ca.getCaStorage()->getRequest(state.m_requestId);
+  BOOST_CHECK_EQUAL(request.cert.getKeyName(), keyName);
+  BOOST_CHECK_EQUAL_COLLECTIONS(state.m_aesKey.begin(), state.m_aesKey.end(),
+                                request.encryptionKey.begin(), request.encryptionKey.end());
+
+  // the Interest signature proves the possession of the key
+  auto otherKey = m_keyChain.createIdentity(Name("/ndn/other")).getDefaultKey();
+  auto forged = *interest;
+  m_keyChain.sign(forged, signingByKey(otherKey.getName()));
+  face.receive(forged);
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 2);
+  auto content = responses.back().getContent();
+  content.parse();
+  BOOST_CHECK_EQUAL(static_cast<ErrorCode>(readNonNegativeInteger(content.get(tlv::ErrorCode))),
+                    ErrorCode::BAD_SIGNATURE);
+}
+
+BOOST_AUTO_TEST_CASE(HandleNewWithX25519)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn"));
+  auto cert = identity.getDefaultKey().getDefaultCertificate();
+
+  ndn::DummyClientFace face(m_io, m_keyChain, {true, true});
+  CaModule ca(face, m_keyChain, "tests/unit-tests/config-files/config-ca-1", "ca-storage-memory");
+  advanceClocks(time::milliseconds(20), 60);
+
+  auto profile = *requester::Request::onCaProfileResponse(ca.getCaProfileData());
+  BOOST_REQUIRE_EQUAL(profile.keyAgreements.size(), 2);
+  BOOST_CHECK(profile.keyAgreements.front() == KeyAgreement::X25519);
+
+  std::vector<Data> responses;
+  face.onSendData.connect([&](const Data& response) { responses.push_back(response); });
+
+  requester::Request state(m_keyChain, profile, RequestType::NEW);
+  BOOST_CHECK(state.m_ecdh.getAlgorithm() == KeyAgreement::X25519);
+  auto keyName = m_keyChain.createIdentity(Name("/ndn/zhiyi")).getDefaultKey().getName();
+  face.receive(*state.genNewInterest(keyName, time::system_clock::now(), time::system_clock::now() + time::days(1)));
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 1);
+  auto content = responses.back().getContent();
+  content.parse();
+  BOOST_CHECK_EQUAL(content.get(tlv::EcdhPub).value_size(), 32);
+
+  state.onNewRenewRevokeResponse(responses.back());
+  auto caEncryptionKey = ca.getCaStorage()->getRequest(state.m_requestId).encryptionKey;
+  BOOST_CHECK_EQUAL_COLLECTIONS(state.m_aesKey.begin(), state.m_aesKey.end(),
+                                caEncryptionKey.begin(), caEncryptionKey.end());
+}
+
+BOOST_AUTO_TEST_CASE(HandleNewWithMalformedAlgorithm)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn"));
+  ndn::DummyClientFace face(m_io, m_keyChain, {true, true});
+  CaModule ca(face, m_keyChain, "tests/unit-tests/config-files/config-ca-1", "ca-storage-memory");
+  advanceClocks(time::milliseconds(20), 60);
+
+  auto profile = *requester::Request::onCaProfileResponse(ca.getCaProfileData());
+  std::vector<Data> responses;
+  face.onSendData.connect([&](const Data& response) { responses.push_back(response); });
+
+  auto keyName = m_keyChain.createIdentity(Name("/ndn/zhiyi")).getDefaultKey().getName();
+  for (auto type : {tlv::KeyAgreement, tlv::Aead}) {
+    requester::Request state(m_keyChain, profile, RequestType::NEW);
+    auto interest = state.genNewInterest(keyName, time::system_clock::now(),
+                                         time::system_clock::now() + time::days(1));
+    // a NonNegativeInteger cannot be 3 bytes long
+    auto params = interest->getApplicationParameters();
+    params.parse();
+    params.remove(type);
+    const uint8_t malformed[] = {0x01, 0x02, 0x03};
+    params.push_back(ndn::makeBinaryBlock(type, malformed));
+    params.encode();
+    interest->setApplicationParameters(params);
+    m_keyChain.sign(*interest, signingByKey(keyName));
+
+    responses.clear();
+    face.receive(*interest);
+    advanceClocks(time::milliseconds(20), 60);
+    BOOST_REQUIRE_EQUAL(responses.size(), 1);
+    auto content = responses.back().getContent();
+    content.parse();
+    BOOST_CHECK(static_cast<ErrorCode>(readNonNegativeInteger(content.get(tlv::ErrorCode))) ==
+                ErrorCode::INVALID_PARAMETER);
+  }
+}
+
 BOOST_AUTO_TEST_CASE(HandleNewWithInvalidValidityPeriod1)
 {
   auto identity = m_keyChain.createIdentity(Name("/ndn"));
@@ -296,6 +627,49 @@ BOOST_AUTO_TEST_CASE(HandleNewWithInvalidValidityPeriod1)
   advanceClocks(time::milliseconds(20), 60);
 }
 
+BOOST_AUTO_TEST_CASE(HandleNewWithDigestSignedError)
+{
+  m_keyChain.createIdentity(Name("/ndn"));
+
+  ndn::DummyClientFace face(m_io, m_keyChain, {true, true});
+  CaModule ca(face, m_keyChain, "tests/unit-tests/config-files/config-ca-1");
+  ca.m_config.errorSigning = ErrorSigning::DIGEST_SHA256;
+  advanceClocks(time::milliseconds(20), 60);
+
+  auto item = *requester::Request::onCaProfileResponse(ca.getCaProfileData());
+  BOOST_CHECK(item.signsErrorsWithDigest);
+  requester::Request state(m_keyChain, item, RequestType::NEW);
+  auto client = m_keyChain.createIdentity(Name("/ndn/zhiyi"));
+  auto current_tp = time::system_clock::now();
+  auto interest = state.genNewInterest(client.getDefaultKey().getName(), current_tp, current_tp - time::hours(1));
+
+  // a requester that was not told about digest-signed errors does not trust them
+  item.signsErrorsWithDigest = false;
+  requester::Request strictState(m_keyChain, item, RequestType::NEW);
+
+  int count = 0;
+  face.onSendData.connect([&](const Data& response) {
+    count++;
+    BOOST_CHECK_EQUAL(response.getSignatureType(), ndn::tlv::DigestSha256);
+    BOOST_CHECK(ndn::security::verifyDigest(response, ndn::DigestAlgorithm::SHA256));
+    // the error is reported as such, not as a signature failure
+    BOOST_CHECK_EXCEPTION(state.onNewRenewRevokeResponse(response), std::runtime_error,
+                          [] (const auto& e) {
+                            return std::string(e.what()).find("Error Info") != std::string::npos;
+                          });
+    BOOST_CHECK_EXCEPTION(strictState.onNewRenewRevokeResponse(response), std::runtime_error,
+                          [] (const auto& e) {
+                            return std::string(e.what()).find("signature") != std::string::npos;
+                          });
+  });
+  face.receive(*interest);
+  face.receive(*interest);
+
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_CHECK_EQUAL(count, 2);
+  BOOST_CHECK_EQUAL(ca.m_errorContents.size(), 1);
+}
+
 BOOST_AUTO_TEST_CASE(HandleNewWithServerBadValidity)
 {
   auto identity = m_keyChain.createIdentity(Name("/ndn"));
@@ -472,6 +846,10 @@ BOOST_AUTO_TEST_CASE(HandleChallenge)
       BOOST_CHECK(verifySignature(response, cert));
       state.onChallengeResponse(response);
       BOOST_CHECK(state.m_status == Status::SUCCESS);
+      // the certificate is delivered with the result
+      BOOST_REQUIRE(state.m_issuedCert != nullptr);
+      BOOST_CHECK_EQUAL(state.m_issuedCert->getName(), state.m_issuedCertName);
+      BOOST_CHECK(verifySignature(*state.m_issuedCert, cert));
     }
   });
   ca.setStatusUpdateCallback([](const RequestState& request) {
@@ -492,6 +870,590 @@ BOOST_AUTO_TEST_CASE(HandleChallenge)
   BOOST_CHECK_EQUAL(count, 3);
 }
 
+BOOST_AUTO_TEST_CASE(HandleChallengeWithSessionSigning)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn"));
+  auto cert = identity.getDefaultKey().getDefaultCertificate();
+
+  ndn::DummyClientFace face(m_io, m_keyChain, {true, true});
+  CaModule ca(face, m_keyChain, "tests/unit-tests/config-files/config-ca-1", "ca-storage-memory");
+  ca.m_config.sessionSigning = true;
+  advanceClocks(time::milliseconds(20), 60);
+
+  std::vector<Data> responses;
+  face.onSendData.connect([&](const Data& response) { responses.push_back(response); });
+
+  CaProfile item;
+  item.caPrefix = Name("/ndn");
+  item.cert = std::make_shared<Certificate>(cert);
+  requester::Request state(m_keyChain, item, RequestType::NEW);
+  auto keyName = m_keyChain.createIdentity(Name("/ndn/zhiyi")).getDefaultKey().getName();
+  face.receive(*state.genNewInterest(keyName, time::system_clock::now(), time::system_clock::now() + time::days(1)));
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 1);
+  BOOST_CHECK(verifySignature(responses.back(), cert));
+  state.onNewRenewRevokeResponse(responses.back());
+
+  // intermediate responses are signed with the session key
+  face.receive(*state.genChallengeInterest(state.selectOrContinueChallenge("pin")));
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 2);
+  BOOST_CHECK_EQUAL(responses.back().getSignatureType(), ndn::tlv::SignatureHmacWithSha256);
+  state.onChallengeResponse(responses.back());
+  BOOST_CHECK(state.m_status == Status::CHALLENGE);
+  BOOST_CHECK_EQUAL(state.m_challengeStatus, ChallengePin::NEED_CODE);
+
+  // a forged session signature is rejected
+  auto forged = responses.back();
+  forged.setContent(ndn::makeEmptyBlock(ndn::tlv::Content));
+  BOOST_CHECK_THROW(state.onChallengeResponse(forged), std::runtime_error);
+
+  // the issuance is signed with the CA key
+  auto paramList = state.selectOrContinueChallenge("pin");
+  auto request = ca.getCaStorage()->getRequest(state.m_requestId);
+  paramList.begin()->second = request.challengeState->secrets.get(ChallengePin::PARAMETER_KEY_CODE, "");
+  face.receive(*state.genChallengeInterest(std::move(paramList)));
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 3);
+  BOOST_CHECK(verifySignature(responses.back(), cert));
+
+  // an issuance signed with the session key is rejected
+  auto hmacKey = deriveSessionHmacKey(state.m_aesKey.data(), state.m_aesKey.size(),
+                                      state.m_requestId.data(), state.m_requestId.size());
+  auto forgedSuccess = responses.back();
+  signDataWithHmacSha256(forgedSuccess, hmacKey.data(), hmacKey.size(),
+                         Name("/ndn/CA").append(Name::Component(state.m_requestId)));
+  auto decryptionIv = state.m_decryptionIv;
+  BOOST_CHECK_THROW(state.onChallengeResponse(forgedSuccess), std::runtime_error);
+  BOOST_CHECK(state.m_status == Status::FAILURE);
+
+  // as if the forged response had not been received
+  state.m_decryptionIv = decryptionIv;
+  state.onChallengeResponse(responses.back());
+  BOOST_CHECK(state.m_status == Status::SUCCESS);
+}
+
+BOOST_AUTO_TEST_CASE(HandleChallengeWithFullEmailQueue)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn"));
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool isStarted = false;
+  bool isReleased = false;
+
+  ndn::DummyClientFace face(m_io, m_keyChain, {true, true});
+  CaModule ca(face, m_keyChain, "tests/unit-tests/config-files/config-ca-7", "ca-storage-memory");
+  advanceClocks(time::milliseconds(20), 60);
+
+  std::vector<Data> responses;
+  face.onSendData.connect([&](const Data& response) { responses.push_back(response); });
+
+  auto profile = *requester::Request::onCaProfileResponse(ca.getCaProfileData());
+  requester::Request state(m_keyChain, profile, RequestType::NEW);
+  auto keyName = m_keyChain.createIdentity(Name("/ndn/zhiyi")).getDefaultKey().getName();
+  face.receive(*state.genNewInterest(keyName, time::system_clock::now(), time::system_clock::now() + time::days(1)));
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 1);
+  state.onNewRenewRevokeResponse(responses.back());
+
+  // the only worker is held by a first email, and a second one fills the queue
+  auto& email = static_cast<ChallengeEmail&>(*ca.m_challengeModules.at("email"));
+  EmailDispatcher::Options options;
+  options.nWorkers = 1;
+  options.queueCapacity = 1;
+  email.m_dispatcher = std::make_unique<EmailDispatcher>([&] (const EmailDispatcher::Message&) {
+    std::unique_lock<std::mutex> lock(mutex);
+    isStarted = true;
+    cv.notify_all();
+    cv.wait(lock, [&] { return isReleased; });
+    return true;
+  }, options);
+  BOOST_CHECK(email.m_dispatcher->enqueue({"a@example.com", "000000", "/ndn", "/ndn/a/KEY/1"}));
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&] { return isStarted; });
+  }
+  BOOST_CHECK(email.m_dispatcher->enqueue({"b@example.com", "111111", "/ndn", "/ndn/b/KEY/1"}));
+
+  auto paramList = state.selectOrContinueChallenge("email");
+  paramList.begin()->second = "zhiyi@example.com";
+  auto challengeInterest = state.genChallengeInterest(std::move(paramList));
+  face.receive(*challengeInterest);
+  advanceClocks(time::milliseconds(20), 60);
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    isReleased = true;
+  }
+  cv.notify_all();
+  email.m_dispatcher->waitUntilIdle();
+
+  BOOST_REQUIRE_EQUAL(responses.size(), 2);
+  BOOST_CHECK_THROW(state.onChallengeResponse(responses.back()), requester::RetryAfterError);
+  // the request is kept as it was, and the error is not replayed
+  auto stored = ca.getCaStorage()->findRequest(state.m_requestId);
+  BOOST_REQUIRE(stored.has_value());
+  BOOST_CHECK(stored->status == Status::BEFORE_CHALLENGE);
+  BOOST_CHECK(ca.m_replayCache.find(challengeInterest->getName()) == nullptr);
+
+  // the same Interest succeeds once the queue has room
+  challengeInterest->refreshNonce();
+  face.receive(*challengeInterest);
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 3);
+  state.onChallengeResponse(responses.back());
+  BOOST_CHECK(state.m_status == Status::CHALLENGE);
+  BOOST_CHECK_EQUAL(state.m_challengeStatus, ChallengeEmail::NEED_CODE);
+}
+
+BOOST_AUTO_TEST_CASE(HandleChallengeWithVerifierUnavailable)
+{
+  m_keyChain.createIdentity(Name("/ndn"));
+  ndn::DummyClientFace face(m_io, m_keyChain, {true, true});
+  CaModule ca(face, m_keyChain, "tests/unit-tests/config-files/config-ca-1", "ca-storage-memory");
+  auto external = std::make_unique<ChallengeExternal>();
+  JsonSection config;
+  config.put(ChallengeExternal::CONFIG_SOCKET_PATH, "ndncert-test-no-verifier.sock");
+  external->loadConfig(config);
+  ca.m_challengeModules.emplace("external", std::move(external));
+  advanceClocks(time::milliseconds(20), 60);
+
+  std::vector<Data> responses;
+  face.onSendData.connect([&](const Data& response) { responses.push_back(response); });
+
+  auto profile = *requester::Request::onCaProfileResponse(ca.getCaProfileData());
+  requester::Request state(m_keyChain, profile, RequestType::NEW);
+  auto keyName = m_keyChain.createIdentity(Name("/ndn/zhiyi")).getDefaultKey().getName();
+  face.receive(*state.genNewInterest(keyName, time::system_clock::now(), time::system_clock::now() + time::days(1)));
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 1);
+  state.onNewRenewRevokeResponse(responses.back());
+
+  auto paramList = state.selectOrContinueChallenge("external");
+  paramList.begin()->second = "credential";
+  auto challengeInterest = state.genChallengeInterest(std::move(paramList));
+  for (int i = 0; i < 2; ++i) {
+    challengeInterest->refreshNonce();
+    face.receive(*challengeInterest);
+    advanceClocks(time::milliseconds(20), 60);
+    BOOST_REQUIRE_EQUAL(responses.size(), 2 + i);
+    BOOST_CHECK_THROW(state.onChallengeResponse(responses.back()), requester::RetryAfterError);
+    // the request waits for the verifier to come back, instead of failing for good
+    auto stored = ca.getCaStorage()->findRequest(state.m_requestId);
+    BOOST_REQUIRE(stored.has_value());
+    BOOST_CHECK(stored->status == Status::BEFORE_CHALLENGE);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(HandleChallengeWithChaCha20Poly1305)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn"));
+  auto cert = identity.getDefaultKey().getDefaultCertificate();
+
+  ndn::DummyClientFace face(m_io, m_keyChain, {true, true});
+  CaModule ca(face, m_keyChain, "tests/unit-tests/config-files/config-ca-1", "ca-storage-memory");
+  advanceClocks(time::milliseconds(20), 60);
+
+  auto profile = *requester::Request::onCaProfileResponse(ca.getCaProfileData());
+  BOOST_CHECK(std::find(profile.aeadAlgorithms.begin(), profile.aeadAlgorithms.end(),
+                        AeadAlgorithm::CHACHA20_POLY1305) != profile.aeadAlgorithms.end());
+
+  std::vector<Data> responses;
+  face.onSendData.connect([&](const Data& response) { responses.push_back(response); });
+
+  requester::Request state(m_keyChain, profile, RequestType::NEW, AeadAlgorithm::CHACHA20_POLY1305);
+  BOOST_CHECK(state.m_aead == AeadAlgorithm::CHACHA20_POLY1305);
+  auto keyName = m_keyChain.createIdentity(Name("/ndn/zhiyi")).getDefaultKey().getName();
+  face.receive(*state.genNewInterest(keyName, time::system_clock::now(), time::system_clock::now() + time::days(1)));
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 1);
+  state.onNewRenewRevokeResponse(responses.back());
+  BOOST_CHECK(ca.getCaStorage()->getRequest(state.m_requestId).aead == AeadAlgorithm::CHACHA20_POLY1305);
+
+  auto challengeInterest = state.genChallengeInterest(state.selectOrContinueChallenge("pin"));
+  // the parameters cannot be decrypted as AES-GCM
+  std::vector<uint8_t> decryptionIv;
+  BOOST_CHECK_THROW(decodeBlockWithAesGcm128(challengeInterest->getApplicationParameters(), state.m_aesKey.data(),
+                                             state.m_requestId.data(), state.m_requestId.size(),
+                                             decryptionIv, {}),
+                    std::runtime_error);
+
+  face.receive(*challengeInterest);
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 2);
+  state.onChallengeResponse(responses.back());
+  BOOST_CHECK(state.m_status == Status::CHALLENGE);
+  BOOST_CHECK_EQUAL(state.m_challengeStatus, ChallengePin::NEED_CODE);
+
+  // a requester preferring an algorithm the CA does not announce falls back to AES-GCM
+  CaProfile item;
+  item.caPrefix = Name("/ndn");
+  item.cert = std::make_shared<Certificate>(cert);
+  requester::Request state2(m_keyChain, item, RequestType::NEW, AeadAlgorithm::CHACHA20_POLY1305);
+  BOOST_CHECK(state2.m_aead == AeadAlgorithm::AES_128_GCM);
+}
+
+BOOST_AUTO_TEST_CASE(HandleNewWithEarlyChallenge)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn"));
+  auto cert = identity.getDefaultKey().getDefaultCertificate();
+
+  ndn::DummyClientFace face(m_io, m_keyChain, {true, true});
+  CaModule ca(face, m_keyChain, "tests/unit-tests/config-files/config-ca-1", "ca-storage-memory");
+  ca.m_config.earlyChallenge = true;
+  advanceClocks(time::milliseconds(20), 60);
+
+  // the ECDH key is published in the profile
+  auto profile = *requester::Request::onCaProfileResponse(ca.getCaProfileData());
+  BOOST_CHECK_EQUAL(profile.ecdhPub.size(), 32);
+
+  std::vector<Data> responses;
+  face.onSendData.connect([&](const Data& response) { responses.push_back(response); });
+
+  requester::Request state(m_keyChain, profile, RequestType::NEW);
+  auto keyName = m_keyChain.createIdentity(Name("/ndn/zhiyi")).getDefaultKey().getName();
+  auto newInterest = state.genNewInterest(keyName, time::system_clock::now(),
+                                          time::system_clock::now() + time::days(1), "pin", {});
+  face.receive(*newInterest);
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 1);
+  BOOST_CHECK(verifySignature(responses[0], cert));
+  auto challengeList = state.onNewRenewRevokeResponse(responses[0]);
+  BOOST_CHECK_EQUAL(challengeList.size(), 1);
+  BOOST_CHECK(state.m_status == Status::CHALLENGE);
+  BOOST_CHECK_EQUAL(state.m_challengeStatus, ChallengePin::NEED_CODE);
+
+  // the challenge continues in the same session
+  auto paramList = state.selectOrContinueChallenge("pin");
+  auto request = ca.getCaStorage()->getRequest(state.m_requestId);
+  paramList.begin()->second = request.challengeState->secrets.get(ChallengePin::PARAMETER_KEY_CODE, "");
+  face.receive(*state.genChallengeInterest(std::move(paramList)));
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 2);
+  state.onChallengeResponse(responses[1]);
+  BOOST_CHECK(state.m_status == Status::SUCCESS);
+
+  // parameters encrypted to another key are ignored, and the requester falls back to CHALLENGE
+  ECDHState otherKey(KeyAgreement::X25519);
+  profile.ecdhPub = otherKey.getSelfPubKey();
+  requester::Request state2(m_keyChain, profile, RequestType::NEW);
+  auto keyName2 = m_keyChain.createIdentity(Name("/ndn/other")).getDefaultKey().getName();
+  face.receive(*state2.genNewInterest(keyName2, time::system_clock::now(),
+                                      time::system_clock::now() + time::days(1), "pin", {}));
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 3);
+  state2.onNewRenewRevokeResponse(responses[2]);
+  BOOST_CHECK(state2.m_status == Status::BEFORE_CHALLENGE);
+  BOOST_CHECK_EQUAL(state2.m_challengeType, "pin");
+}
+
+BOOST_AUTO_TEST_CASE(HandleNewWithResumptionTicket)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn"));
+  auto cert = identity.getDefaultKey().getDefaultCertificate();
+
+  ndn::DummyClientFace face(m_io, m_keyChain, {true, true});
+  CaModule ca(face, m_keyChain, "tests/unit-tests/config-files/config-ca-1", "ca-storage-memory");
+  ca.m_ticketKeys = std::make_unique<ResumptionTicketKeys>(time::hours(1));
+  advanceClocks(time::milliseconds(20), 60);
+
+  std::vector<Data> responses;
+  face.onSendData.connect([&](const Data& response) { responses.push_back(response); });
+
+  CaProfile item;
+  item.caPrefix = Name("/ndn");
+  item.cert = std::make_shared<Certificate>(cert);
+  auto keyName = m_keyChain.createIdentity(Name("/ndn/zhiyi")).getDefaultKey().getName();
+
+  // a full enrollment ends with a ticket
+  requester::Request state(m_keyChain, item, RequestType::NEW);
+  face.receive(*state.genNewInterest(keyName, time::system_clock::now(), time::system_clock::now() + time::days(1)));
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 1);
+  state.onNewRenewRevokeResponse(responses.back());
+  face.receive(*state.genChallengeInterest(state.selectOrContinueChallenge("pin")));
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 2);
+  state.onChallengeResponse(responses.back());
+  BOOST_CHECK(!state.getResumptionTicket());
+  auto paramList = state.selectOrContinueChallenge("pin");
+  auto request = ca.getCaStorage()->getRequest(state.m_requestId);
+  paramList.begin()->second = request.challengeState->secrets.get(ChallengePin::PARAMETER_KEY_CODE, "");
+  face.receive(*state.genChallengeInterest(std::move(paramList)));
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 3);
+  state.onChallengeResponse(responses.back());
+  BOOST_CHECK(state.m_status == Status::SUCCESS);
+  auto ticket = state.getResumptionTicket();
+  BOOST_REQUIRE(ticket);
+
+  // the next request of the same key skips ECDH
+  requester::Request state2(m_keyChain, item, RequestType::NEW);
+  state2.setResumptionTicket(*ticket);
+  face.receive(*state2.genNewInterest(keyName, time::system_clock::now(), time::system_clock::now() + time::days(1)));
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 4);
+  auto content = responses.back().getContent();
+  content.parse();
+  BOOST_CHECK(content.find(tlv::EcdhPub) == content.elements_end());
+  state2.onNewRenewRevokeResponse(responses.back());
+  auto caEncryptionKey = ca.getCaStorage()->getRequest(state2.m_requestId).encryptionKey;
+  BOOST_CHECK_EQUAL_COLLECTIONS(state2.m_aesKey.begin(), state2.m_aesKey.end(),
+                                caEncryptionKey.begin(), caEncryptionKey.end());
+
+  // a ticket presented for another key is ignored, and the CA falls back to ECDH
+  auto otherKeyName = m_keyChain.createIdentity(Name("/ndn/other")).getDefaultKey().getName();
+  requester::Request state3(m_keyChain, item, RequestType::NEW);
+  state3.setResumptionTicket(*ticket);
+  face.receive(*state3.genNewInterest(otherKeyName, time::system_clock::now(),
+                                      time::system_clock::now() + time::days(1)));
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 5);
+  content = responses.back().getContent();
+  content.parse();
+  BOOST_CHECK(content.find(tlv::EcdhPub) != content.elements_end());
+  state3.onNewRenewRevokeResponse(responses.back());
+  caEncryptionKey = ca.getCaStorage()->getRequest(state3.m_requestId).encryptionKey;
+  BOOST_CHECK_EQUAL_COLLECTIONS(state3.m_aesKey.begin(), state3.m_aesKey.end(),
+                                caEncryptionKey.begin(), caEncryptionKey.end());
+}
+
+BOOST_AUTO_TEST_CASE(HandleRetransmission)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn"));
+  auto key = identity.getDefaultKey();
+  auto cert = key.getDefaultCertificate();
+
+  ndn::DummyClientFace face(m_io, m_keyChain, {true, true});
+  CaModule ca(face, m_keyChain, "tests/unit-tests/config-files/config-ca-1", "ca-storage-memory");
+  advanceClocks(time::milliseconds(20), 60);
+
+  CaProfile item;
+  item.caPrefix = Name("/ndn");
+  item.cert = std::make_shared<Certificate>(cert);
+  requester::Request state(m_keyChain, item, RequestType::NEW);
+  auto newInterest = state.genNewInterest(m_keyChain.createIdentity(Name("/ndn/zhiyi")).getDefaultKey().getName(),
+                                          time::system_clock::now(),
+                                          time::system_clock::now() + time::days(1));
+
+  std::vector<Data> responses;
+  face.onSendData.connect([&](const Data& response) { responses.push_back(response); });
+
+  // a retransmitted NEW gets the original response instead of a duplicate request error
+  face.receive(*newInterest);
+  advanceClocks(time::milliseconds(20), 60);
+  face.receive(*newInterest);
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 2);
+  BOOST_CHECK_EQUAL(responses[0].wireEncode(), responses[1].wireEncode());
+  BOOST_CHECK_EQUAL(ca.getCaStorage()->listAllRequests().size(), 1);
+
+  state.onNewRenewRevokeResponse(responses[0]);
+  auto challengeInterest = state.genChallengeInterest(state.selectOrContinueChallenge("pin"));
+
+  // a retransmitted CHALLENGE does not run the challenge again
+  face.receive(*challengeInterest);
+  advanceClocks(time::milliseconds(20), 60);
+  auto request = ca.getCertificateRequest(*challengeInterest);
+  BOOST_REQUIRE(request != nullptr);
+  face.receive(*challengeInterest);
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 4);
+  BOOST_CHECK_EQUAL(responses[2].wireEncode(), responses[3].wireEncode());
+  auto requestAfter = ca.getCertificateRequest(*challengeInterest);
+  BOOST_REQUIRE(requestAfter != nullptr);
+  BOOST_CHECK_EQUAL(requestAfter->challengeState->remainingTries, request->challengeState->remainingTries);
+  state.onChallengeResponse(responses[3]);
+  BOOST_CHECK_EQUAL(state.m_challengeStatus, ChallengePin::NEED_CODE);
+
+  // responses are kept only for a short time
+  advanceClocks(time::milliseconds(100), 100);
+  face.receive(*newInterest);
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 5);
+  auto [errorCode, errorInfo, retryAfter] = errortlv::decodefromDataContent(responses[4].getContent());
+  BOOST_CHECK_EQUAL(errorCode, ErrorCode::INVALID_PARAMETER);
+}
+
+BOOST_AUTO_TEST_CASE(HandleAsyncChallenge)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn"));
+  auto cert = identity.getDefaultKey().getDefaultCertificate();
+
+  ndn::DummyClientFace face(m_io, m_keyChain, {true, true});
+  CaModule ca(face, m_keyChain, "tests/unit-tests/config-files/config-ca-1", "ca-storage-memory");
+  auto deferred = std::make_unique<DeferredPinChallenge>();
+  auto& challenge = *deferred;
+  ca.m_challengeModules["pin"] = std::move(deferred);
+  advanceClocks(time::milliseconds(20), 60);
+
+  CaProfile item;
+  item.caPrefix = Name("/ndn");
+  item.cert = std::make_shared<Certificate>(cert);
+  requester::Request state(m_keyChain, item, RequestType::NEW);
+  auto newInterest = state.genNewInterest(m_keyChain.createIdentity(Name("/ndn/zhiyi")).getDefaultKey().getName(),
+                                          time::system_clock::now(),
+                                          time::system_clock::now() + time::days(1));
+
+  std::vector<Data> responses;
+  face.onSendData.connect([&](const Data& response) { responses.push_back(response); });
+  face.receive(*newInterest);
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_REQUIRE_EQUAL(responses.size(), 1);
+  state.onNewRenewRevokeResponse(responses[0]);
+  auto challengeInterest = state.genChallengeInterest(state.selectOrContinueChallenge("pin"));
+
+  // the CHALLENGE is not answered while the module works on it, but other requests are
+  face.receive(*challengeInterest);
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_CHECK_EQUAL(responses.size(), 1);
+  BOOST_CHECK_EQUAL(challenge.pending.size(), 1);
+  face.receive(ndn::MetadataObject::makeDiscoveryInterest(Name("/ndn/CA/INFO")));
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_CHECK_EQUAL(responses.size(), 2);
+
+  // a retransmission does not start the same step again
+  face.receive(*challengeInterest);
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_CHECK_EQUAL(challenge.pending.size(), 1);
+  BOOST_CHECK_EQUAL(responses.size(), 2);
+
+  challenge.pending.front()();
+  BOOST_REQUIRE_EQUAL(responses.size(), 3);
+  BOOST_CHECK_EQUAL(responses[2].getName(), challengeInterest->getName());
+  state.onChallengeResponse(responses[2]);
+  BOOST_CHECK(state.m_status == Status::CHALLENGE);
+  BOOST_CHECK_EQUAL(state.m_challengeStatus, ChallengePin::NEED_CODE);
+  BOOST_CHECK(ca.m_challengesInProgress.empty());
+}
+
+BOOST_AUTO_TEST_CASE(HandleChallengeWithUnknownRequestId)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn"));
+  auto cert = identity.getDefaultKey().getDefaultCertificate();
+
+  ndn::DummyClientFace face(m_io, m_keyChain, {true, true});
+  CaModule ca(face, m_keyChain, "tests/unit-tests/config-files/config-ca-1", "ca-storage-memory");
+  advanceClocks(time::milliseconds(20), 60);
+
+  RequestId unknownId = {{1, 2, 3, 4, 5, 6, 7, 8}};
+  BOOST_CHECK(!ca.m_requestFilter.mayContain(unknownId));
+  Name challengeName = Name("/ndn/CA/CHALLENGE").append(Name::Component(unknownId));
+  BOOST_CHECK(ca.getCertificateRequest(Interest(challengeName)) == nullptr);
+  // a request ID of the wrong size is rejected as well
+  BOOST_CHECK(ca.getCertificateRequest(Interest("/ndn/CA/CHALLENGE/0123456789abcdef")) == nullptr);
+
+  int count = 0;
+  face.onSendData.connect([&](const Data& response) {
+    count++;
+    auto [errorCode, errorInfo, retryAfter] = errortlv::decodefromDataContent(response.getContent());
+    BOOST_CHECK_EQUAL(errorCode, ErrorCode::INVALID_PARAMETER);
+  });
+  Interest interest(challengeName);
+  interest.setApplicationParameters(ndn::makeStringBlock(ndn::tlv::ApplicationParameters, "bogus"));
+  face.receive(interest);
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_CHECK_EQUAL(count, 1);
+}
+
+BOOST_AUTO_TEST_CASE(HandleRenew)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn"));
+  auto key = identity.getDefaultKey();
+  auto cert = key.getDefaultCertificate();
+
+  ndn::DummyClientFace face(m_io, {true, true});
+  CaModule ca(face, m_keyChain, "tests/unit-tests/config-files/config-ca-1", "ca-storage-memory");
+  advanceClocks(time::milliseconds(20), 60);
+
+  // issue the certificate to renew
+  auto clientIdentity = m_keyChain.createIdentity("/ndn/qwerty");
+  auto clientKey = clientIdentity.getDefaultKey();
+  Certificate clientCert;
+  clientCert.setName(Name(clientKey.getName()).append("cert-request").appendVersion());
+  clientCert.setContentType(ndn::tlv::ContentType_Key);
+  clientCert.setContent(clientKey.getPublicKey());
+  SignatureInfo signatureInfo;
+  signatureInfo.setValidityPeriod(ndn::security::ValidityPeriod(time::system_clock::now(),
+                                                                time::system_clock::now() + time::hours(10)));
+  m_keyChain.sign(clientCert, signingByKey(clientKey.getName()).setSignatureInfo(signatureInfo));
+  RequestState certRequest;
+  certRequest.caPrefix = Name("/ndn");
+  certRequest.requestType = RequestType::NEW;
+  certRequest.status = Status::SUCCESS;
+  certRequest.cert = clientCert;
+  auto issuedCert = ca.issueCertificate(certRequest);
+
+  CaProfile item;
+  item.caPrefix = Name("/ndn");
+  item.cert = std::make_shared<Certificate>(cert);
+  requester::Request state(m_keyChain, item, RequestType::RENEW);
+
+  // renew onto a new key of the same identity
+  auto newKey = m_keyChain.createKey(clientIdentity);
+  auto current_tp = time::system_clock::now();
+  auto interest = state.genRenewInterest(issuedCert, newKey.getName(), current_tp, current_tp + time::hours(1));
+  BOOST_REQUIRE(interest != nullptr);
+  BOOST_CHECK_EQUAL(interest->getName().getSubName(1, 2), Name("/CA/RENEW"));
+
+  int count = 0;
+  face.onSendData.connect([&] (const Data& response) {
+    count++;
+    BOOST_CHECK(verifySignature(response, cert));
+    auto renewedCert = state.onRenewResponse(response);
+    BOOST_REQUIRE(renewedCert != nullptr);
+    BOOST_CHECK_EQUAL(renewedCert->getKeyName(), newKey.getName());
+    BOOST_CHECK(verifySignature(*renewedCert, cert));
+    BOOST_CHECK(state.m_status == Status::SUCCESS);
+  });
+  face.receive(*interest);
+
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_CHECK_EQUAL(count, 1);
+  // nothing is kept by the CA
+  BOOST_CHECK_EQUAL(ca.getCaStorage()->listAllRequests().size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(HandleRenewWithUntrustedCert)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn"));
+  auto key = identity.getDefaultKey();
+  auto cert = key.getDefaultCertificate();
+
+  ndn::DummyClientFace face(m_io, {true, true});
+  CaModule ca(face, m_keyChain, "tests/unit-tests/config-files/config-ca-1", "ca-storage-memory");
+  advanceClocks(time::milliseconds(20), 60);
+
+  // a self-signed certificate is not issued by the CA
+  auto clientIdentity = m_keyChain.createIdentity("/ndn/qwerty");
+  auto clientCert = clientIdentity.getDefaultKey().getDefaultCertificate();
+
+  CaProfile item;
+  item.caPrefix = Name("/ndn");
+  item.cert = std::make_shared<Certificate>(cert);
+  requester::Request state(m_keyChain, item, RequestType::RENEW);
+
+  auto current_tp = time::system_clock::now();
+  auto interest = state.genRenewInterest(clientCert, clientCert.getKeyName(), current_tp, current_tp + time::hours(1));
+  BOOST_REQUIRE(interest != nullptr);
+
+  int count = 0;
+  face.onSendData.connect([&] (const Data& response) {
+    count++;
+    auto contentTlv = response.getContent();
+    contentTlv.parse();
+    BOOST_CHECK_EQUAL(static_cast<ErrorCode>(readNonNegativeInteger(contentTlv.get(tlv::ErrorCode))),
+                      ErrorCode::BAD_SIGNATURE);
+    BOOST_CHECK_THROW(state.onRenewResponse(response), std::exception);
+  });
+  face.receive(*interest);
+
+  advanceClocks(time::milliseconds(20), 60);
+  BOOST_CHECK_EQUAL(count, 1);
+  BOOST_CHECK_EQUAL(ca.getCaStorage()->listAllRequests().size(), 0);
+}
+
 BOOST_AUTO_TEST_CASE(HandleRevoke)
 {
   auto identity = m_keyChain.createIdentity(Name("/ndn"));
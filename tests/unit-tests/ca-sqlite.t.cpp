@@ -19,10 +19,15 @@
  */
 
 #include "detail/ca-sqlite.hpp"
+#include "detail/crypto-helpers.hpp"
 
 #include "tests/boost-test.hpp"
 #include "tests/key-chain-fixture.hpp"
 
+#include <ndn-cxx/util/sqlite3-statement.hpp>
+
+#include <sqlite3.h>
+
 #include <filesystem>
 #include <system_error>
 
@@ -69,10 +74,15 @@ BOOST_AUTO_TEST_CASE(RequestOperations)
   request1.encryptionKey = {{102}};
   request1.decryptionIv.assign({1,2,3,4,5,6,7,8,9,10,11,12});
   request1.decryptionIv.assign({2,3,4,5,6,7,8,9,10,11,12,13});
+  request1.aead = AeadAlgorithm::CHACHA20_POLY1305;
+  request1.aeadKey = {{103}};
   storage.addRequest(request1);
 
   // get operation
   auto result = storage.getRequest(requestId);
+  BOOST_CHECK(storage.findRequest(requestId).has_value());
+  BOOST_CHECK(!storage.findRequest({{100}}).has_value());
+  BOOST_CHECK_THROW(storage.getRequest({{100}}), std::runtime_error);
   BOOST_CHECK_EQUAL(request1.cert, result.cert);
   BOOST_CHECK(request1.status == result.status);
   BOOST_CHECK_EQUAL(request1.caPrefix, result.caPrefix);
@@ -82,6 +92,9 @@ BOOST_AUTO_TEST_CASE(RequestOperations)
                                 result.encryptionIv.begin(), result.encryptionIv.end());
   BOOST_CHECK_EQUAL_COLLECTIONS(request1.decryptionIv.begin(), request1.decryptionIv.end(),
                                 result.decryptionIv.begin(), result.decryptionIv.end());
+  BOOST_CHECK(result.aead == AeadAlgorithm::CHACHA20_POLY1305);
+  BOOST_CHECK_EQUAL_COLLECTIONS(request1.aeadKey.begin(), request1.aeadKey.end(),
+                                result.aeadKey.begin(), result.aeadKey.end());
 
   // update operation
   RequestState request2;
@@ -152,6 +165,65 @@ BOOST_AUTO_TEST_CASE(DuplicateAdd)
   BOOST_CHECK_THROW(storage.addRequest(request1), std::runtime_error);
 }
 
+BOOST_AUTO_TEST_CASE(UpgradeDatabase)
+{
+  auto dbPath = dbDir.string() + "/TestCaSqlite_UpgradeDatabase.db";
+  auto cert = m_keyChain.createIdentity(Name("/ndn/site1")).getDefaultKey().getDefaultCertificate();
+  RequestId requestId = {{101}};
+  std::array<uint8_t, 16> encryptionKey = {{102}};
+  {
+    // a request stored before the AEAD algorithm became negotiable
+    sqlite3* db = nullptr;
+    BOOST_REQUIRE_EQUAL(sqlite3_open(dbPath.data(), &db), SQLITE_OK);
+    BOOST_REQUIRE_EQUAL(sqlite3_exec(db, R"SQL(
+      CREATE TABLE RequestStates(
+        id INTEGER PRIMARY KEY, request_id BLOB NOT NULL, ca_name BLOB NOT NULL,
+        request_type INTEGER NOT NULL, status INTEGER NOT NULL, cert_request BLOB NOT NULL,
+        challenge_type TEXT, challenge_status TEXT, challenge_tp TEXT, remaining_tries INTEGER,
+        remaining_time INTEGER, challenge_secrets TEXT, encryption_key BLOB NOT NULL,
+        encryption_iv BLOB, decryption_iv BLOB);)SQL", nullptr, nullptr, nullptr), SQLITE_OK);
+    {
+      ndn::util::Sqlite3Statement statement(db, R"SQL(INSERT INTO RequestStates
+        (request_id, ca_name, request_type, status, cert_request, challenge_type, encryption_key)
+        VALUES (?, ?, 0, 0, ?, '', ?))SQL");
+      statement.bind(1, requestId.data(), requestId.size(), SQLITE_TRANSIENT);
+      statement.bind(2, Name("/ndn/site1").wireEncode(), SQLITE_TRANSIENT);
+      statement.bind(3, cert.wireEncode(), SQLITE_TRANSIENT);
+      statement.bind(4, encryptionKey.data(), encryptionKey.size(), SQLITE_TRANSIENT);
+      BOOST_CHECK_EQUAL(statement.step(), SQLITE_DONE);
+    }
+    sqlite3_close(db);
+  }
+
+  // the AEAD key of the request is derived when it is loaded
+  CaSqlite storage(Name(), dbPath);
+  auto result = storage.getRequest(requestId);
+  BOOST_CHECK(result.aead == AeadAlgorithm::AES_128_GCM);
+  auto aeadKey = deriveAeadKey(AeadAlgorithm::AES_128_GCM, encryptionKey.data(),
+                               requestId.data(), requestId.size());
+  BOOST_CHECK_EQUAL_COLLECTIONS(aeadKey.begin(), aeadKey.end(), result.aeadKey.begin(), result.aeadKey.end());
+}
+
+BOOST_AUTO_TEST_CASE(UsedTokens)
+{
+  auto dbPath = dbDir.string() + "/TestCaSqlite_UsedTokens.db";
+  auto now = time::system_clock::now();
+  {
+    CaSqlite storage(Name(), dbPath);
+    BOOST_CHECK(storage.addUsedToken(1, now + 10_min));
+    BOOST_CHECK(!storage.addUsedToken(1, now + 10_min));
+    // nonces do not fit in a signed integer
+    BOOST_CHECK(storage.addUsedToken(0xfedcba9876543210, now + 10_min));
+    BOOST_CHECK(storage.addUsedToken(2, now - 1_s));
+  }
+
+  // used tokens are remembered across restarts, until they expire
+  CaSqlite storage(Name(), dbPath);
+  BOOST_CHECK(!storage.addUsedToken(1, now + 10_min));
+  BOOST_CHECK(!storage.addUsedToken(0xfedcba9876543210, now + 10_min));
+  BOOST_CHECK(storage.addUsedToken(2, now + 10_min));
+}
+
 BOOST_AUTO_TEST_SUITE_END() // TestCaSqlite
 
 } // namespace ndncert::tests
@@ -60,6 +60,10 @@ BOOST_AUTO_TEST_CASE(OnChallengeRequestWithEmail)
 
   ChallengeEmail challenge("./tests/unit-tests/test-send-email.sh");
   challenge.handleChallengeRequest(paramTLV, request);
+  // the email is sent in the background
+  BOOST_REQUIRE(challenge.m_dispatcher != nullptr);
+  challenge.m_dispatcher->waitUntilIdle();
+  BOOST_CHECK_EQUAL(challenge.m_dispatcher->getCounters().nSent, 1);
 
   BOOST_CHECK(request.status == Status::CHALLENGE);
   BOOST_CHECK_EQUAL(request.challengeState->challengeStatus, ChallengeEmail::NEED_CODE);
@@ -0,0 +1,398 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2024, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+
+#include "challenge/challenge-external.hpp"
+
+#include "tests/boost-test.hpp"
+#include "tests/io-key-chain-fixture.hpp"
+
+#include <boost/asio/local/stream_protocol.hpp>
+#include <boost/asio/write.hpp>
+
+#include <unistd.h>
+
+namespace ndncert::tests {
+
+using boost::asio::local::stream_protocol;
+
+const std::string VERIFIER_SOCKET = "ndncert-test-verifier.sock";
+
+/**
+ * @brief Verifier accepting the credential "good", asking for a response to the credential
+ *        "two-step" or the response "again", and rejecting everything else.
+ */
+class StubVerifier
+{
+public:
+  explicit
+  StubVerifier(boost::asio::io_context& io)
+    : m_io(io)
+    , m_acceptor(io)
+  {
+    ::unlink(VERIFIER_SOCKET.data());
+    stream_protocol::endpoint endpoint(VERIFIER_SOCKET);
+    m_acceptor.open(endpoint.protocol());
+    m_acceptor.bind(endpoint);
+    m_acceptor.listen();
+    accept();
+  }
+
+  ~StubVerifier()
+  {
+    boost::system::error_code ec;
+    m_acceptor.close(ec);
+    for (auto& connection : m_connections) {
+      connection->socket.close(ec);
+    }
+    ::unlink(VERIFIER_SOCKET.data());
+  }
+
+  /**
+   * @brief Answer the held requests, in reverse order.
+   */
+  void
+  release()
+  {
+    isHolding = false;
+    while (!m_held.empty()) {
+      auto [connection, request] = m_held.back();
+      m_held.pop_back();
+      answer(connection, request);
+    }
+  }
+
+public:
+  bool isHolding = false;
+  bool isSilent = false;
+  uint64_t remainingTries = 1;
+  uint64_t remainingTime = 60;
+  size_t nConnections = 0;
+  std::vector<Block> requests;
+
+private:
+  struct Connection
+  {
+    explicit
+    Connection(boost::asio::io_context& io)
+      : socket(io)
+    {
+    }
+
+    stream_protocol::socket socket;
+    std::array<uint8_t, ndn::MAX_NDN_PACKET_SIZE> buffer;
+    size_t bufferSize = 0;
+  };
+
+  void
+  accept()
+  {
+    auto connection = std::make_shared<Connection>(m_io);
+    m_acceptor.async_accept(connection->socket, [this, connection] (const auto& ec) {
+      if (ec) {
+        return;
+      }
+      ++nConnections;
+      m_connections.push_back(connection);
+      read(connection);
+      accept();
+    });
+  }
+
+  void
+  read(std::shared_ptr<Connection> connection)
+  {
+    auto buffer = boost::asio::buffer(connection->buffer.data() + connection->bufferSize,
+                                      connection->buffer.size() - connection->bufferSize);
+    connection->socket.async_read_some(buffer, [this, connection] (const auto& ec, size_t nBytes) {
+      if (ec) {
+        return;
+      }
+      connection->bufferSize += nBytes;
+      size_t offset = 0;
+      while (true) {
+        auto [isOk, request] = Block::fromBuffer(ndn::make_span(connection->buffer.data() + offset,
+                                                                 connection->bufferSize - offset));
+        if (!isOk) {
+          break;
+        }
+        offset += request.size();
+        requests.push_back(request);
+        if (isHolding) {
+          m_held.emplace_back(connection, request);
+        }
+        else if (!isSilent) {
+          answer(connection, request);
+        }
+      }
+      std::copy(connection->buffer.begin() + offset,
+                connection->buffer.begin() + connection->bufferSize, connection->buffer.begin());
+      connection->bufferSize -= offset;
+      read(connection);
+    });
+  }
+
+  void
+  answer(std::shared_ptr<Connection> connection, Block request)
+  {
+    request.parse();
+    Block response(verifier::tlv::VerifyResponse);
+    response.push_back(request.get(verifier::tlv::CallId));
+
+    auto key = readString(request.get(tlv::ParameterKey));
+    auto value = readString(request.get(tlv::ParameterValue));
+    auto state = request.find(verifier::tlv::VerifierState);
+    auto result = verifier::VerifyResult::FAILURE;
+    if ((key == ChallengeExternal::PARAMETER_KEY_CREDENTIAL && value == "good") ||
+        (key == ChallengeExternal::PARAMETER_KEY_RESPONSE && value == "ok" &&
+         state != request.elements_end() && readString(*state) == "state-1")) {
+      result = verifier::VerifyResult::SUCCESS;
+    }
+    else if ((key == ChallengeExternal::PARAMETER_KEY_CREDENTIAL && value == "two-step") ||
+             (key == ChallengeExternal::PARAMETER_KEY_RESPONSE && value == "again")) {
+      result = verifier::VerifyResult::CONTINUE;
+    }
+
+    response.push_back(ndn::makeNonNegativeIntegerBlock(verifier::tlv::VerifyResult,
+                                                        static_cast<uint64_t>(result)));
+    if (result == verifier::VerifyResult::CONTINUE) {
+      response.push_back(ndn::makeStringBlock(tlv::ChallengeStatus, "need-response"));
+      response.push_back(ndn::makeNonNegativeIntegerBlock(tlv::RemainingTries, remainingTries));
+      response.push_back(ndn::makeNonNegativeIntegerBlock(tlv::RemainingTime, remainingTime));
+      response.push_back(ndn::makeStringBlock(verifier::tlv::VerifierState, "state-1"));
+    }
+    else if (result == verifier::VerifyResult::FAILURE) {
+      response.push_back(ndn::makeStringBlock(tlv::ErrorInfo, "bad " + key));
+    }
+    response.encode();
+    auto wire = std::make_shared<Block>(response);
+    boost::asio::async_write(connection->socket, boost::asio::buffer(wire->data(), wire->size()),
+                             [connection, wire] (const auto&, size_t) {});
+  }
+
+private:
+  boost::asio::io_context& m_io;
+  stream_protocol::acceptor m_acceptor;
+  std::vector<std::shared_ptr<Connection>> m_connections;
+  std::vector<std::pair<std::shared_ptr<Connection>, Block>> m_held;
+};
+
+class ChallengeExternalFixture : public IoKeyChainFixture
+{
+public:
+  ChallengeExternalFixture()
+  {
+    JsonSection config;
+    config.put(ChallengeExternal::CONFIG_SOCKET_PATH, VERIFIER_SOCKET);
+    config.put(ChallengeExternal::CONFIG_CONNECTIONS, 1);
+    config.put(ChallengeExternal::CONFIG_TIMEOUT, 1000);
+    challenge.loadConfig(config);
+  }
+
+  std::shared_ptr<ca::RequestState>
+  makeRequest(uint8_t id)
+  {
+    auto request = std::make_shared<ca::RequestState>();
+    request->caPrefix = Name("/ndn/site1");
+    request->requestId = RequestId{{id}};
+    request->requestType = RequestType::NEW;
+    request->cert = m_keyChain.createIdentity(Name("/ndn/site1/user")).getDefaultKey().getDefaultCertificate();
+    return request;
+  }
+
+  void
+  handle(const std::shared_ptr<ca::RequestState>& request, const std::string& key, const std::string& value)
+  {
+    auto params = challenge.genChallengeRequestTLV(request->status, "", {{key, value}});
+    challenge.handleChallengeRequestAsync(params, request, m_io,
+      [this, request] (ErrorCode errorCode, const std::string& errorInfo) {
+        results[request->requestId[0]] = {errorCode, errorInfo};
+      });
+  }
+
+public:
+  ChallengeExternal challenge;
+  std::map<uint8_t, std::tuple<ErrorCode, std::string>> results;
+};
+
+BOOST_FIXTURE_TEST_SUITE(TestChallengeExternal, ChallengeExternalFixture)
+
+BOOST_AUTO_TEST_CASE(ChallengeType)
+{
+  BOOST_CHECK_EQUAL(challenge.CHALLENGE_TYPE, "external");
+  BOOST_CHECK(ChallengeModule::isChallengeSupported("external"));
+}
+
+BOOST_AUTO_TEST_CASE(Accept)
+{
+  StubVerifier verifier(m_io);
+  auto request = makeRequest(1);
+  handle(request, ChallengeExternal::PARAMETER_KEY_CREDENTIAL, "good");
+  BOOST_CHECK(results.empty());
+  advanceClocks(1_ms, 20);
+
+  BOOST_REQUIRE_EQUAL(results.count(1), 1);
+  BOOST_CHECK_EQUAL(std::get<0>(results[1]), ErrorCode::NO_ERROR);
+  BOOST_CHECK(request->status == Status::PENDING);
+
+  BOOST_REQUIRE_EQUAL(verifier.requests.size(), 1);
+  auto& forwarded = verifier.requests[0];
+  forwarded.parse();
+  BOOST_REQUIRE(!forwarded.elements().empty());
+  BOOST_CHECK_EQUAL(forwarded.elements().front().type(), verifier::tlv::CallId);
+  BOOST_CHECK_EQUAL(Name(forwarded.get(ndn::tlv::Name)), request->cert.getName());
+  BOOST_CHECK(forwarded.find(tlv::ChallengeStatus) == forwarded.elements_end());
+}
+
+BOOST_AUTO_TEST_CASE(TwoSteps)
+{
+  StubVerifier verifier(m_io);
+  auto request = makeRequest(1);
+  handle(request, ChallengeExternal::PARAMETER_KEY_CREDENTIAL, "two-step");
+  advanceClocks(1_ms, 20);
+  BOOST_CHECK_EQUAL(std::get<0>(results.at(1)), ErrorCode::NO_ERROR);
+  BOOST_CHECK(request->status == Status::CHALLENGE);
+  BOOST_REQUIRE(request->challengeState.has_value());
+  BOOST_CHECK_EQUAL(request->challengeState->challengeStatus, "need-response");
+  BOOST_CHECK_EQUAL(request->challengeState->remainingTries, 1);
+
+  auto params = challenge.getRequestedParameterList(request->status, "need-response");
+  BOOST_CHECK_EQUAL(params.count(ChallengeExternal::PARAMETER_KEY_RESPONSE), 1);
+  results.clear();
+  handle(request, ChallengeExternal::PARAMETER_KEY_RESPONSE, "ok");
+  advanceClocks(1_ms, 20);
+  BOOST_CHECK_EQUAL(std::get<0>(results.at(1)), ErrorCode::NO_ERROR);
+  BOOST_CHECK(request->status == Status::PENDING);
+  BOOST_CHECK_EQUAL(verifier.nConnections, 1);
+}
+
+BOOST_AUTO_TEST_CASE(RemainingTries)
+{
+  StubVerifier verifier(m_io);
+  verifier.remainingTries = 100;
+  auto request = makeRequest(1);
+  handle(request, ChallengeExternal::PARAMETER_KEY_CREDENTIAL, "two-step");
+  advanceClocks(1_ms, 20);
+  BOOST_CHECK_EQUAL(std::get<0>(results.at(1)), ErrorCode::NO_ERROR);
+  BOOST_REQUIRE(request->challengeState.has_value());
+  // capped by max-attempts
+  BOOST_CHECK_EQUAL(request->challengeState->remainingTries, 3);
+
+  // every step costs a try
+  for (size_t expected : {2, 1}) {
+    handle(request, ChallengeExternal::PARAMETER_KEY_RESPONSE, "again");
+    advanceClocks(1_ms, 20);
+    BOOST_CHECK_EQUAL(std::get<0>(results.at(1)), ErrorCode::NO_ERROR);
+    BOOST_CHECK(request->status == Status::CHALLENGE);
+    BOOST_CHECK_EQUAL(request->challengeState->remainingTries, expected);
+  }
+  handle(request, ChallengeExternal::PARAMETER_KEY_RESPONSE, "again");
+  advanceClocks(1_ms, 20);
+  BOOST_CHECK_EQUAL(std::get<0>(results.at(1)), ErrorCode::OUT_OF_TRIES);
+  BOOST_CHECK(request->status == Status::FAILURE);
+}
+
+BOOST_AUTO_TEST_CASE(RemainingTime)
+{
+  StubVerifier verifier(m_io);
+  auto request = makeRequest(1);
+  handle(request, ChallengeExternal::PARAMETER_KEY_CREDENTIAL, "two-step");
+  advanceClocks(1_ms, 20);
+  BOOST_REQUIRE(request->challengeState.has_value());
+  BOOST_CHECK_EQUAL(request->challengeState->remainingTime, 60_s);
+
+  // capped by secret-lifetime
+  verifier.remainingTime = 1000000;
+  request = makeRequest(2);
+  handle(request, ChallengeExternal::PARAMETER_KEY_CREDENTIAL, "two-step");
+  advanceClocks(1_ms, 20);
+  BOOST_REQUIRE(request->challengeState.has_value());
+  BOOST_CHECK_EQUAL(request->challengeState->remainingTime, 300_s);
+}
+
+BOOST_AUTO_TEST_CASE(Reject)
+{
+  StubVerifier verifier(m_io);
+  auto request = makeRequest(1);
+  handle(request, ChallengeExternal::PARAMETER_KEY_CREDENTIAL, "forged");
+  advanceClocks(1_ms, 20);
+  BOOST_CHECK_EQUAL(std::get<0>(results.at(1)), ErrorCode::INVALID_PARAMETER);
+  BOOST_CHECK_EQUAL(std::get<1>(results.at(1)), "bad credential");
+  BOOST_CHECK(request->status == Status::FAILURE);
+}
+
+BOOST_AUTO_TEST_CASE(Pipelining)
+{
+  StubVerifier verifier(m_io);
+  verifier.isHolding = true;
+  auto request1 = makeRequest(1);
+  auto request2 = makeRequest(2);
+  auto request3 = makeRequest(3);
+  handle(request1, ChallengeExternal::PARAMETER_KEY_CREDENTIAL, "good");
+  handle(request2, ChallengeExternal::PARAMETER_KEY_CREDENTIAL, "forged");
+  handle(request3, ChallengeExternal::PARAMETER_KEY_CREDENTIAL, "good");
+  advanceClocks(1_ms, 20);
+  // all requests are on the verifier before any response
+  BOOST_CHECK_EQUAL(verifier.requests.size(), 3);
+  BOOST_CHECK_EQUAL(verifier.nConnections, 1);
+  BOOST_CHECK(results.empty());
+
+  verifier.release();
+  advanceClocks(1_ms, 20);
+  BOOST_REQUIRE_EQUAL(results.size(), 3);
+  BOOST_CHECK_EQUAL(std::get<0>(results[1]), ErrorCode::NO_ERROR);
+  BOOST_CHECK_EQUAL(std::get<0>(results[2]), ErrorCode::INVALID_PARAMETER);
+  BOOST_CHECK_EQUAL(std::get<0>(results[3]), ErrorCode::NO_ERROR);
+  BOOST_CHECK_EQUAL(challenge.m_client->getPendingCallCount(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(Timeout)
+{
+  StubVerifier verifier(m_io);
+  verifier.isSilent = true;
+  auto request = makeRequest(1);
+  handle(request, ChallengeExternal::PARAMETER_KEY_CREDENTIAL, "good");
+  advanceClocks(100_ms, 9);
+  BOOST_CHECK(results.empty());
+  advanceClocks(100_ms, 2);
+  BOOST_CHECK_EQUAL(std::get<0>(results.at(1)), ErrorCode::SERVICE_UNAVAILABLE);
+  BOOST_CHECK(request->status == Status::FAILURE);
+}
+
+BOOST_AUTO_TEST_CASE(VerifierUnavailable)
+{
+  ::unlink(VERIFIER_SOCKET.data());
+  auto request = makeRequest(1);
+  handle(request, ChallengeExternal::PARAMETER_KEY_CREDENTIAL, "good");
+  advanceClocks(1_ms, 20);
+  BOOST_CHECK_EQUAL(std::get<0>(results.at(1)), ErrorCode::SERVICE_UNAVAILABLE);
+
+  // a new connection is attempted for the next call
+  StubVerifier verifier(m_io);
+  results.clear();
+  auto request2 = makeRequest(2);
+  handle(request2, ChallengeExternal::PARAMETER_KEY_CREDENTIAL, "good");
+  advanceClocks(1_ms, 20);
+  BOOST_CHECK_EQUAL(std::get<0>(results.at(2)), ErrorCode::NO_ERROR);
+}
+
+BOOST_AUTO_TEST_SUITE_END() // TestChallengeExternal
+
+} // namespace ndncert::tests
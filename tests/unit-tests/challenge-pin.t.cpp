@@ -53,6 +53,31 @@ BOOST_AUTO_TEST_CASE(OnChallengeRequestWithEmptyInfo)
   BOOST_CHECK_EQUAL(request.challengeType, "pin");
 }
 
+BOOST_AUTO_TEST_CASE(LoadConfig)
+{
+  auto identity = m_keyChain.createIdentity(Name("/ndn/site1"));
+  ca::RequestState request;
+  request.caPrefix = Name("/ndn/site1");
+  request.requestId = {{101}};
+  request.requestType = RequestType::NEW;
+  request.cert = identity.getDefaultKey().getDefaultCertificate();
+
+  ChallengePin challenge;
+  JsonSection config;
+  config.put(ChallengeModule::CONFIG_MAX_ATTEMPTS, 5);
+  config.put(ChallengeModule::CONFIG_SECRET_LIFETIME, 60);
+  challenge.loadConfig(config);
+  challenge.handleChallengeRequest(ndn::makeEmptyBlock(tlv::EncryptedPayload), request);
+  BOOST_CHECK_EQUAL(request.challengeState->remainingTries, 5);
+  BOOST_CHECK_EQUAL(request.challengeState->remainingTime, time::seconds(60));
+
+  JsonSection invalidConfig;
+  invalidConfig.put(ChallengeModule::CONFIG_MAX_ATTEMPTS, 0);
+  BOOST_CHECK_THROW(challenge.loadConfig(invalidConfig), std::runtime_error);
+  invalidConfig.put(ChallengeModule::CONFIG_MAX_ATTEMPTS, "many");
+  BOOST_CHECK_THROW(challenge.loadConfig(invalidConfig), std::runtime_error);
+}
+
 BOOST_AUTO_TEST_CASE(OnChallengeRequestWithCode)
 {
   auto identity = m_keyChain.createIdentity(Name("/ndn/site1"));
@@ -36,6 +36,7 @@ public:
     trustAnchor = m_keyChain.createIdentity("/trust").getDefaultKey().getDefaultCertificate();
     challenge.parseConfigFile();
     challenge.m_trustAnchors.front() = trustAnchor;
+    challenge.indexTrustAnchors();
   }
 
   void
@@ -113,6 +114,82 @@ BOOST_AUTO_TEST_CASE(HandleChallengeRequest)
   BOOST_CHECK_EQUAL(statusToString(state.status), statusToString(Status::PENDING));
 }
 
+BOOST_AUTO_TEST_CASE(CredentialCaches)
+{
+  createTrustAnchor();
+  createCertificateRequest();
+  createRequesterCredential();
+  signCertRequest();
+  BOOST_CHECK_EQUAL(challenge.m_verifiedCredentials.count(credential.getFullName()), 1);
+  BOOST_CHECK_EQUAL(challenge.m_pendingCredentials.count(state.requestId), 1);
+
+  // the proof step falls back to the credential saved in the challenge secrets
+  challenge.m_pendingCredentials.clear();
+  auto nonceBuf = ndn::fromHex(state.challengeState->secrets.get("nonce", ""));
+  std::array<uint8_t, 16> nonce{};
+  memcpy(nonce.data(), nonceBuf->data(), 16);
+  replyFromServer(nonce);
+  BOOST_CHECK_EQUAL(statusToString(state.status), statusToString(Status::PENDING));
+
+  // a verified credential is accepted from the cache
+  ca::RequestState state2;
+  state2.caPrefix = "/example";
+  state2.requestId = RequestId{{102}};
+  state2.requestType = RequestType::NEW;
+  state2.cert = state.cert;
+  std::swap(state, state2);
+  signCertRequest();
+  BOOST_CHECK_EQUAL(challenge.m_verifiedCredentials.size(), 1);
+  BOOST_CHECK_EQUAL(challenge.m_pendingCredentials.size(), 1);
+
+  // reloading the anchors forgets verified credentials
+  challenge.indexTrustAnchors();
+  BOOST_CHECK(challenge.m_verifiedCredentials.empty());
+}
+
+BOOST_AUTO_TEST_CASE(UntrustedCredential)
+{
+  createTrustAnchor();
+  createCertificateRequest();
+  trustAnchor = m_keyChain.createIdentity("/untrusted").getDefaultKey().getDefaultCertificate();
+  createRequesterCredential();
+
+  auto params = challenge.getRequestedParameterList(state.status, "");
+  ChallengePossession::fulfillParameters(params, m_keyChain, credential.getName(), std::array<uint8_t, 16>{});
+  challenge.handleChallengeRequest(challenge.genChallengeRequestTLV(state.status, "", params), state);
+  BOOST_CHECK_EQUAL(statusToString(state.status), statusToString(Status::FAILURE));
+  BOOST_CHECK(challenge.m_verifiedCredentials.empty());
+  BOOST_CHECK(challenge.m_pendingCredentials.empty());
+}
+
+BOOST_AUTO_TEST_CASE(ShortLivedCredential)
+{
+  createTrustAnchor();
+  createCertificateRequest();
+  createRequesterCredential();
+
+  // the credential is remembered until it expires, not for the whole cache lifetime
+  BOOST_CHECK(challenge.isTrustedCredential(credential));
+  auto cached = challenge.m_verifiedCredentials.find(credential.getFullName());
+  BOOST_REQUIRE(cached != challenge.m_verifiedCredentials.end());
+  auto notAfter = credential.getValidityPeriod().getPeriod().second;
+  BOOST_CHECK(cached->second == notAfter);
+
+  // an expired credential is rejected and not remembered
+  auto key = m_keyChain.createIdentity("/trust/expired").getDefaultKey();
+  ndn::security::MakeCertificateOptions opts;
+  opts.issuerId = ndn::name::Component("Credential");
+  opts.validity.emplace(ndn::security::ValidityPeriod::makeRelative(-1_min, -1_s));
+  auto expired = m_keyChain.makeCertificate(key, signingByCertificate(trustAnchor), opts);
+  BOOST_CHECK(!challenge.isTrustedCredential(expired));
+  BOOST_CHECK_EQUAL(challenge.m_verifiedCredentials.count(expired.getFullName()), 0);
+
+  // a cached credential is not trusted once it has expired
+  challenge.m_verifiedCredentials.emplace(expired.getFullName(),
+                                          time::system_clock::now() + 1_h);
+  BOOST_CHECK(!challenge.isTrustedCredential(expired));
+}
+
 BOOST_AUTO_TEST_CASE(HandleChallengeRequestProofFail)
 {
   createTrustAnchor();
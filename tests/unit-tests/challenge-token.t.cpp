@@ -0,0 +1,200 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2024, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+
+#include "challenge/challenge-token.hpp"
+
+#include "tests/boost-test.hpp"
+#include "tests/key-chain-fixture.hpp"
+
+namespace ndncert::tests {
+
+class ChallengeTokenFixture : public KeyChainFixture
+{
+public:
+  ChallengeTokenFixture()
+  {
+    JsonSection config;
+    config.put(ChallengeToken::CONFIG_TOKEN_KEY, ndn::toHex(key));
+    config.put(ChallengeToken::CONFIG_MAX_TOKEN_LIFETIME, 3600);
+    challenge.loadConfig(config);
+  }
+
+  ca::RequestState
+  makeRequest(const Name& identity)
+  {
+    ca::RequestState request;
+    request.caPrefix = Name("/ndn/site1");
+    request.requestId = RequestId{{101}};
+    request.requestType = RequestType::NEW;
+    request.cert = m_keyChain.createIdentity(identity).getDefaultKey().getDefaultCertificate();
+    return request;
+  }
+
+  std::tuple<ErrorCode, std::string>
+  handle(ca::RequestState& request, const std::string& token)
+  {
+    auto params = challenge.genChallengeRequestTLV(request.status, "",
+                                                   {{ChallengeToken::PARAMETER_KEY_TOKEN, token}});
+    return challenge.handleChallengeRequest(params, request);
+  }
+
+public:
+  const std::array<uint8_t, 16> key{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+  ChallengeToken challenge;
+};
+
+BOOST_FIXTURE_TEST_SUITE(TestChallengeToken, ChallengeTokenFixture)
+
+BOOST_AUTO_TEST_CASE(ChallengeType)
+{
+  BOOST_CHECK_EQUAL(challenge.CHALLENGE_TYPE, "token");
+  BOOST_CHECK(ChallengeModule::isChallengeSupported("token"));
+}
+
+BOOST_AUTO_TEST_CASE(LoadConfig)
+{
+  ChallengeToken unconfigured;
+  auto request = makeRequest("/ndn/site1/device1");
+  auto token = ChallengeToken::makeToken(key, "/ndn/site1", "/ndn/site1/device1",
+                                         time::system_clock::now() + 10_min);
+  auto params = unconfigured.genChallengeRequestTLV(Status::BEFORE_CHALLENGE, "",
+                                                    {{ChallengeToken::PARAMETER_KEY_TOKEN, token}});
+  BOOST_CHECK_EQUAL(std::get<0>(unconfigured.handleChallengeRequest(params, request)),
+                    ErrorCode::SERVICE_UNAVAILABLE);
+
+  JsonSection config;
+  BOOST_CHECK_THROW(unconfigured.loadConfig(config), std::runtime_error);
+  config.put(ChallengeToken::CONFIG_TOKEN_KEY, "0102030405060708");
+  BOOST_CHECK_THROW(unconfigured.loadConfig(config), std::runtime_error);
+  config.put(ChallengeToken::CONFIG_TOKEN_KEY, "not hex");
+  BOOST_CHECK_THROW(unconfigured.loadConfig(config), std::runtime_error);
+  config.put(ChallengeToken::CONFIG_TOKEN_KEY, ndn::toHex(key));
+  config.put(ChallengeToken::CONFIG_MAX_TOKEN_LIFETIME, 0);
+  BOOST_CHECK_THROW(unconfigured.loadConfig(config), std::runtime_error);
+  config.put(ChallengeToken::CONFIG_MAX_TOKEN_LIFETIME, 60);
+  BOOST_CHECK_NO_THROW(unconfigured.loadConfig(config));
+}
+
+BOOST_AUTO_TEST_CASE(SingleRoundTrip)
+{
+  auto requestedParams = challenge.getRequestedParameterList(Status::BEFORE_CHALLENGE, "");
+  BOOST_CHECK_EQUAL(requestedParams.count(ChallengeToken::PARAMETER_KEY_TOKEN), 1);
+  BOOST_CHECK_THROW(challenge.getRequestedParameterList(Status::CHALLENGE, ""), std::runtime_error);
+
+  auto token = ChallengeToken::makeToken(key, "/ndn/site1", "/ndn/site1/device1",
+                                         time::system_clock::now() + 10_min);
+  auto request = makeRequest("/ndn/site1/device1");
+  auto [errorCode, errorInfo] = handle(request, token);
+  BOOST_CHECK_EQUAL(errorCode, ErrorCode::NO_ERROR);
+  BOOST_CHECK(request.status == Status::PENDING);
+  BOOST_CHECK_EQUAL(request.challengeType, "token");
+
+  // the token is accepted once
+  auto replayed = makeRequest("/ndn/site1/device1");
+  std::tie(errorCode, errorInfo) = handle(replayed, token);
+  BOOST_CHECK_EQUAL(errorCode, ErrorCode::INVALID_PARAMETER);
+  BOOST_CHECK_EQUAL(errorInfo, "Token already used.");
+  BOOST_CHECK(replayed.status == Status::FAILURE);
+}
+
+BOOST_AUTO_TEST_CASE(InvalidToken)
+{
+  auto expiry = time::system_clock::now() + 10_min;
+  auto request = makeRequest("/ndn/site1/device1");
+
+  // other identity
+  auto token = ChallengeToken::makeToken(key, "/ndn/site1", "/ndn/site1/device2", expiry);
+  BOOST_CHECK_EQUAL(std::get<0>(handle(request, token)), ErrorCode::INVALID_PARAMETER);
+
+  // other CA
+  request = makeRequest("/ndn/site1/device1");
+  token = ChallengeToken::makeToken(key, "/ndn/site2", "/ndn/site1/device1", expiry);
+  BOOST_CHECK_EQUAL(std::get<0>(handle(request, token)), ErrorCode::INVALID_PARAMETER);
+
+  // other key
+  request = makeRequest("/ndn/site1/device1");
+  std::array<uint8_t, 16> otherKey{};
+  token = ChallengeToken::makeToken(otherKey, "/ndn/site1", "/ndn/site1/device1", expiry);
+  BOOST_CHECK_EQUAL(std::get<0>(handle(request, token)), ErrorCode::INVALID_PARAMETER);
+
+  // tampered expiry
+  request = makeRequest("/ndn/site1/device1");
+  token = ChallengeToken::makeToken(key, "/ndn/site1", "/ndn/site1/device1", expiry);
+  token[token.find('.') - 1] = token[token.find('.') - 1] == '0' ? '1' : '0';
+  BOOST_CHECK_EQUAL(std::get<0>(handle(request, token)), ErrorCode::INVALID_PARAMETER);
+
+  // expired
+  request = makeRequest("/ndn/site1/device1");
+  token = ChallengeToken::makeToken(key, "/ndn/site1", "/ndn/site1/device1", time::system_clock::now() - 1_s);
+  BOOST_CHECK_EQUAL(std::get<0>(handle(request, token)), ErrorCode::OUT_OF_TIME);
+
+  // expiring beyond max-token-lifetime
+  request = makeRequest("/ndn/site1/device1");
+  token = ChallengeToken::makeToken(key, "/ndn/site1", "/ndn/site1/device1", time::system_clock::now() + 2_h);
+  BOOST_CHECK_EQUAL(std::get<0>(handle(request, token)), ErrorCode::INVALID_PARAMETER);
+
+  // none of the rejected tokens is remembered
+  BOOST_CHECK_EQUAL(challenge.m_ownStorage.m_usedTokens.size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(MalformedToken)
+{
+  for (const std::string token : {"", "123", "123.456", ".0102030405060708.00", "12a.0102030405060708.00",
+                                  "123.01020304050607.00", "123.0102030405060708.zz"}) {
+    auto request = makeRequest("/ndn/site1/device1");
+    BOOST_CHECK_EQUAL(std::get<0>(handle(request, token)), ErrorCode::BAD_PARAMETER_FORMAT);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(UsedTokensInCaStorage)
+{
+  ca::CaMemory storage;
+  challenge.setCaStorage(storage);
+  auto token = ChallengeToken::makeToken(key, "/ndn/site1", "/ndn/site1/device1",
+                                         time::system_clock::now() + 10_min);
+  auto request = makeRequest("/ndn/site1/device1");
+  BOOST_CHECK_EQUAL(std::get<0>(handle(request, token)), ErrorCode::NO_ERROR);
+  BOOST_CHECK_EQUAL(storage.m_usedTokens.size(), 1);
+  BOOST_CHECK_EQUAL(challenge.m_ownStorage.m_usedTokens.size(), 0);
+
+  // a module created by reloading the configuration still rejects the token
+  ChallengeToken reloaded;
+  JsonSection config;
+  config.put(ChallengeToken::CONFIG_TOKEN_KEY, ndn::toHex(key));
+  reloaded.loadConfig(config);
+  reloaded.setCaStorage(storage);
+  request = makeRequest("/ndn/site1/device1");
+  auto params = reloaded.genChallengeRequestTLV(request.status, "",
+                                                {{ChallengeToken::PARAMETER_KEY_TOKEN, token}});
+  auto [errorCode, errorInfo] = reloaded.handleChallengeRequest(params, request);
+  BOOST_CHECK_EQUAL(errorCode, ErrorCode::INVALID_PARAMETER);
+  BOOST_CHECK_EQUAL(errorInfo, "Token already used.");
+}
+
+BOOST_AUTO_TEST_CASE(DefaultMaxTokenLifetime)
+{
+  ChallengeToken unconfigured;
+  BOOST_CHECK_EQUAL(unconfigured.m_maxTokenLifetime, time::seconds(900));
+}
+
+BOOST_AUTO_TEST_SUITE_END() // TestChallengeToken
+
+} // namespace ndncert::tests
@@ -72,6 +72,11 @@ BOOST_AUTO_TEST_CASE(CaConfigFile)
   BOOST_CHECK_EQUAL(names[0], Name("/irl/1@1.edu"));
   BOOST_CHECK_EQUAL(names[1], Name("/irl/ndncert"));
   BOOST_CHECK_EQUAL(names[2].size(), 1);
+
+  config.load("tests/unit-tests/config-files/config-ca-7");
+  BOOST_CHECK_EQUAL(config.challengeConfigs.size(), 2);
+  BOOST_CHECK_EQUAL(config.challengeConfigs["pin"].get<size_t>("max-attempts"), 5);
+  BOOST_CHECK_EQUAL(config.challengeConfigs["email"].get<std::string>("script-path"), "/usr/local/bin/send-email");
 }
 
 BOOST_AUTO_TEST_CASE(CaConfigFileWithErrors)
@@ -85,6 +90,8 @@ BOOST_AUTO_TEST_CASE(CaConfigFileWithErrors)
   BOOST_CHECK_THROW(config.load("tests/unit-tests/config-files/config-ca-4"), std::runtime_error);
   // unsupported name assignment
   BOOST_CHECK_THROW(config.load("tests/unit-tests/config-files/config-ca-6"), std::runtime_error);
+  // configuration of a challenge that is not supported
+  BOOST_CHECK_THROW(config.load("tests/unit-tests/config-files/config-ca-8"), std::runtime_error);
 }
 
 BOOST_AUTO_TEST_CASE(ProfileStorageConfigFile)
@@ -0,0 +1,78 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2024, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+
+#include "detail/counting-bloom-filter.hpp"
+
+#include "tests/boost-test.hpp"
+
+namespace ndncert::tests {
+
+BOOST_AUTO_TEST_SUITE(TestCountingBloomFilter)
+
+BOOST_AUTO_TEST_CASE(InsertErase)
+{
+  CountingBloomFilter filter(1024, 4);
+  std::array<uint8_t, 8> id1{1, 2, 3, 4, 5, 6, 7, 8};
+  std::array<uint8_t, 8> id2{8, 7, 6, 5, 4, 3, 2, 1};
+
+  BOOST_CHECK(!filter.mayContain(id1));
+  filter.insert(id1);
+  filter.insert(id2);
+  BOOST_CHECK_EQUAL(filter.size(), 2);
+  BOOST_CHECK(filter.mayContain(id1));
+  BOOST_CHECK(filter.mayContain(id2));
+
+  filter.erase(id1);
+  BOOST_CHECK(!filter.mayContain(id1));
+  BOOST_CHECK(filter.mayContain(id2));
+
+  filter.clear();
+  BOOST_CHECK_EQUAL(filter.size(), 0);
+  BOOST_CHECK(!filter.mayContain(id2));
+}
+
+BOOST_AUTO_TEST_CASE(FalsePositiveRate)
+{
+  CountingBloomFilter filter(65536, 4);
+  for (uint32_t i = 0; i < 4096; ++i) {
+    filter.insert({reinterpret_cast<const uint8_t*>(&i), sizeof(i)});
+  }
+  for (uint32_t i = 0; i < 4096; ++i) {
+    BOOST_CHECK(filter.mayContain({reinterpret_cast<const uint8_t*>(&i), sizeof(i)}));
+  }
+
+  // 16 counters per item and 4 hashes give a false positive rate of about 0.24%
+  size_t nFalsePositives = 0;
+  for (uint32_t i = 4096; i < 4096 + 100000; ++i) {
+    nFalsePositives += filter.mayContain({reinterpret_cast<const uint8_t*>(&i), sizeof(i)});
+  }
+  BOOST_CHECK_LT(nFalsePositives, 1000);
+}
+
+BOOST_AUTO_TEST_CASE(InvalidParameters)
+{
+  BOOST_CHECK_THROW(CountingBloomFilter(0, 4), std::invalid_argument);
+  BOOST_CHECK_THROW(CountingBloomFilter(1024, 0), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END() // TestCountingBloomFilter
+
+} // namespace ndncert::tests
@@ -52,6 +52,51 @@ BOOST_AUTO_TEST_CASE(EcdhWithRawKeyWrongInput)
   BOOST_CHECK(!alicePub.empty());
   std::vector<uint8_t> fakePub(10, 0x0b);
   BOOST_CHECK_THROW(aliceState.deriveSecret(fakePub), std::runtime_error);
+  // an uncompressed point that is not on the curve
+  std::vector<uint8_t> offCurvePub(65, 0x0b);
+  offCurvePub[0] = 0x04;
+  BOOST_CHECK_THROW(aliceState.deriveSecret(offCurvePub), std::runtime_error);
+  BOOST_CHECK_THROW(aliceState.deriveSecret(ECDHState(KeyAgreement::X25519).getSelfPubKey()),
+                    std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(EcdhRepeatedDerivation)
+{
+  ECDHState caState;
+  const auto& caPub = caState.getSelfPubKey();
+  BOOST_CHECK_EQUAL(caPub.size(), 65);
+  BOOST_CHECK_EQUAL(caPub[0], 0x04);
+
+  // one long-lived state derives secrets with many peers, including after a failure
+  for (int i = 0; i < 3; ++i) {
+    ECDHState peerState;
+    std::vector<uint8_t> expected = peerState.deriveSecret(caPub);
+    auto result = caState.deriveSecret(peerState.getSelfPubKey());
+    BOOST_CHECK_EQUAL(result.size(), 32);
+    BOOST_CHECK_EQUAL_COLLECTIONS(result.begin(), result.end(), expected.begin(), expected.end());
+    BOOST_CHECK_THROW(caState.deriveSecret(std::vector<uint8_t>(65, 0x04)), std::runtime_error);
+  }
+  BOOST_CHECK(caState.getSelfPubKey() == caPub);
+}
+
+BOOST_AUTO_TEST_CASE(EcdhX25519)
+{
+  ECDHState aliceState(KeyAgreement::X25519);
+  auto alicePub = aliceState.getSelfPubKey();
+  BOOST_CHECK_EQUAL(alicePub.size(), 32);
+
+  ECDHState bobState(KeyAgreement::X25519);
+  auto bobPub = bobState.getSelfPubKey();
+  BOOST_CHECK_EQUAL(bobPub.size(), 32);
+
+  auto aliceResult = aliceState.deriveSecret(bobPub);
+  auto bobResult = bobState.deriveSecret(alicePub);
+  BOOST_CHECK_EQUAL(aliceResult.size(), 32);
+  BOOST_CHECK_EQUAL_COLLECTIONS(aliceResult.begin(), aliceResult.end(), bobResult.begin(), bobResult.end());
+
+  // a P-256 key, and a low-order point giving an all-zero secret
+  BOOST_CHECK_THROW(aliceState.deriveSecret(ECDHState().getSelfPubKey()), std::runtime_error);
+  BOOST_CHECK_THROW(aliceState.deriveSecret(std::vector<uint8_t>(32, 0)), std::runtime_error);
 }
 
 BOOST_AUTO_TEST_CASE(HmacSha256)
@@ -71,6 +116,26 @@ BOOST_AUTO_TEST_CASE(HmacSha256)
                                 expected + sizeof(expected));
 }
 
+BOOST_AUTO_TEST_CASE(KeyedHmac)
+{
+  const uint8_t key[] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06,
+                          0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c};
+  const uint8_t otherKey[] = {0xaa, 0xbb};
+  uint8_t input[40] = {};
+  KeyedHmacSha256 keyedHmac(key, sizeof(key));
+  for (size_t i = 0; i < 3; ++i) {
+    input[i] = 0x0b;
+    uint8_t result[32];
+    uint8_t expected[32];
+    keyedHmac.compute(input, sizeof(input) - i, result);
+    // interleaved HMACs with another key do not disturb the keyed instance
+    hmacSha256(input, sizeof(input), otherKey, sizeof(otherKey), expected);
+    hmacSha256(input, sizeof(input) - i, key, sizeof(key), expected);
+    BOOST_CHECK_EQUAL_COLLECTIONS(result, result + sizeof(result), expected,
+                                  expected + sizeof(expected));
+  }
+}
+
 BOOST_AUTO_TEST_CASE(Hkdf1)
 {
   // RFC5869 appendix A.1
@@ -341,6 +406,160 @@ BOOST_AUTO_TEST_CASE(BlockEncodingDecoding)
                     std::runtime_error);
 }
 
+BOOST_AUTO_TEST_CASE(ChaCha20Poly1305)
+{
+  // RFC 8439, section 2.8.2
+  uint8_t key[32];
+  for (size_t i = 0; i < sizeof(key); ++i) {
+    key[i] = 0x80 + i;
+  }
+  const uint8_t iv[] = {0x07, 0x00, 0x00, 0x00, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47};
+  const uint8_t aad[] = {0x50, 0x51, 0x52, 0x53, 0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7};
+  const std::string plaintext = "Ladies and Gentlemen of the class of '99: If I could offer you only one tip "
+                                "for the future, sunscreen would be it.";
+  const uint8_t expectedCiphertextStart[] = {0xd3, 0x1a, 0x8d, 0x34, 0x64, 0x8e, 0x60, 0xdb,
+                                             0x7b, 0x86, 0xaf, 0xbc, 0x53, 0xef, 0x7e, 0xc2};
+  const uint8_t expectedTag[] = {0x1a, 0xe1, 0x0b, 0x59, 0x4f, 0x09, 0xe2, 0x6a,
+                                 0x7e, 0x90, 0x2e, 0xcb, 0xd0, 0x60, 0x06, 0x91};
+
+  uint8_t ciphertext[256] = {0};
+  uint8_t tag[16] = {0};
+  auto size = chacha20Poly1305Encrypt(reinterpret_cast<const uint8_t*>(plaintext.data()), plaintext.size(),
+                                      aad, sizeof(aad), key, iv, ciphertext, tag);
+  BOOST_CHECK_EQUAL(size, plaintext.size());
+  BOOST_CHECK_EQUAL_COLLECTIONS(ciphertext, ciphertext + sizeof(expectedCiphertextStart),
+                                expectedCiphertextStart, expectedCiphertextStart + sizeof(expectedCiphertextStart));
+  BOOST_CHECK_EQUAL_COLLECTIONS(tag, tag + 16, expectedTag, expectedTag + sizeof(expectedTag));
+
+  uint8_t decrypted[256] = {0};
+  size = chacha20Poly1305Decrypt(ciphertext, size, aad, sizeof(aad), tag, key, iv, decrypted);
+  BOOST_CHECK_EQUAL(std::string(reinterpret_cast<char*>(decrypted), size), plaintext);
+
+  tag[0] ^= 1;
+  BOOST_CHECK_THROW(chacha20Poly1305Decrypt(ciphertext, size, aad, sizeof(aad), tag, key, iv, decrypted),
+                    std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(AeadBlockEncodingDecoding)
+{
+  namespace be = boost::endian;
+
+  const uint8_t key[] = {0xbc, 0x22, 0xf3, 0xf0, 0x5c, 0xc4, 0x0d, 0xb9,
+                         0x31, 0x1e, 0x41, 0x92, 0x96, 0x6f, 0xee, 0x92};
+  const std::string plaintext = "alongstringalongstringalongstringalongstringalongstringalongstringalongstringalongstring";
+  const std::string associatedData = "right";
+  auto chachaKey = deriveAeadKey(AeadAlgorithm::CHACHA20_POLY1305, key,
+                                 (uint8_t*)associatedData.c_str(), associatedData.size());
+  std::vector<uint8_t> encryptionIv;
+  std::vector<uint8_t> decryptionIv;
+  auto block = encodeBlockWithAead(AeadAlgorithm::CHACHA20_POLY1305, ndn::tlv::Content, chachaKey.data(),
+                                   (uint8_t*)plaintext.c_str(), plaintext.size(),
+                                   (uint8_t*)associatedData.c_str(), associatedData.size(), encryptionIv);
+  // the IV counter advances as with AES-GCM
+  BOOST_CHECK_EQUAL((be::endian_load<uint32_t, 4, be::order::big>(&encryptionIv[8])), 6);
+
+  // the algorithms are not interchangeable
+  BOOST_CHECK_THROW(decodeBlockWithAead(AeadAlgorithm::AES_128_GCM, block, chachaKey.data(),
+                                        (uint8_t*)associatedData.c_str(), associatedData.size(),
+                                        decryptionIv, {}),
+                    std::runtime_error);
+  decryptionIv.clear();
+  auto decoded = decodeBlockWithAead(AeadAlgorithm::CHACHA20_POLY1305, block, chachaKey.data(),
+                                     (uint8_t*)associatedData.c_str(), associatedData.size(),
+                                     decryptionIv, {});
+  BOOST_CHECK_EQUAL(plaintext, std::string(decoded.get<char>(), decoded.size()));
+
+  BOOST_CHECK_THROW(encodeBlockWithAead(static_cast<AeadAlgorithm>(42), ndn::tlv::Content, key,
+                                        (uint8_t*)plaintext.c_str(), plaintext.size(),
+                                        (uint8_t*)associatedData.c_str(), associatedData.size(), encryptionIv),
+                    std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(AeadKey)
+{
+  const uint8_t key[] = {0xbc, 0x22, 0xf3, 0xf0, 0x5c, 0xc4, 0x0d, 0xb9,
+                         0x31, 0x1e, 0x41, 0x92, 0x96, 0x6f, 0xee, 0x92};
+  const uint8_t salt1[] = {0x01, 0x02};
+  const uint8_t salt2[] = {0x01, 0x03};
+
+  // AES-128-GCM uses the session key itself
+  auto aesKey = deriveAeadKey(AeadAlgorithm::AES_128_GCM, key, salt1, sizeof(salt1));
+  BOOST_CHECK_EQUAL_COLLECTIONS(aesKey.begin(), aesKey.begin() + 16, key, key + sizeof(key));
+
+  // the ChaCha20-Poly1305 key depends on the salt
+  auto chachaKey1 = deriveAeadKey(AeadAlgorithm::CHACHA20_POLY1305, key, salt1, sizeof(salt1));
+  auto chachaKey2 = deriveAeadKey(AeadAlgorithm::CHACHA20_POLY1305, key, salt2, sizeof(salt2));
+  BOOST_CHECK(chachaKey1 != aesKey);
+  BOOST_CHECK(chachaKey1 != chachaKey2);
+  BOOST_CHECK(chachaKey1 == deriveAeadKey(AeadAlgorithm::CHACHA20_POLY1305, key, salt1, sizeof(salt1)));
+
+  BOOST_CHECK_THROW(deriveAeadKey(static_cast<AeadAlgorithm>(42), key, salt1, sizeof(salt1)),
+                    std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(DecryptIntoBlock)
+{
+  const uint8_t key[] = {0xbc, 0x22, 0xf3, 0xf0, 0x5c, 0xc4, 0x0d, 0xb9,
+                         0x31, 0x1e, 0x41, 0x92, 0x96, 0x6f, 0xee, 0x92};
+  const std::string associatedData = "right";
+  Block payload(tlv::EncryptedPayload);
+  payload.push_back(ndn::makeStringBlock(tlv::SelectedChallenge, "pin"));
+  // long enough for a three-byte TLV-LENGTH
+  payload.push_back(ndn::makeStringBlock(tlv::ParameterValue, std::string(300, 'x')));
+  payload.encode();
+
+  for (auto algorithm : {AeadAlgorithm::AES_128_GCM, AeadAlgorithm::CHACHA20_POLY1305}) {
+    auto aeadKey = deriveAeadKey(algorithm, key, (uint8_t*)associatedData.c_str(), associatedData.size());
+    std::vector<uint8_t> encryptionIv;
+    std::vector<uint8_t> decryptionIv;
+    for (int i = 0; i < 2; ++i) {
+      auto block = encodeBlockWithAead(algorithm, ndn::tlv::ApplicationParameters, aeadKey.data(),
+                                       payload.value(), payload.value_size(),
+                                       (uint8_t*)associatedData.c_str(), associatedData.size(), encryptionIv);
+      auto decoded = decryptBlockWithAead(algorithm, block, tlv::EncryptedPayload, aeadKey.data(),
+                                          (uint8_t*)associatedData.c_str(), associatedData.size(),
+                                          decryptionIv, {});
+      BOOST_CHECK_EQUAL(decoded, payload);
+      decoded.parse();
+      BOOST_CHECK_EQUAL(readString(decoded.get(tlv::SelectedChallenge)), "pin");
+      BOOST_CHECK_EQUAL(decoded.get(tlv::ParameterValue).value_size(), 300);
+    }
+    // IVs are checked as with decodeBlockWithAead
+    auto block = encodeBlockWithAead(algorithm, ndn::tlv::ApplicationParameters, aeadKey.data(),
+                                     payload.value(), payload.value_size(),
+                                     (uint8_t*)associatedData.c_str(), associatedData.size(), encryptionIv);
+    BOOST_CHECK_THROW(decryptBlockWithAead(algorithm, block, tlv::EncryptedPayload, aeadKey.data(),
+                                           (uint8_t*)associatedData.c_str(), associatedData.size(),
+                                           decryptionIv, encryptionIv),
+                      std::runtime_error);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(DataHmacSha256)
+{
+  const uint8_t aesKey[] = {0x6f, 0x9b, 0x1c, 0x2d, 0x43, 0x11, 0x7a, 0x88,
+                            0x02, 0x5e, 0xc4, 0x31, 0x99, 0xaf, 0x70, 0x0b};
+  const uint8_t requestId[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08};
+  auto key = deriveSessionHmacKey(aesKey, sizeof(aesKey), requestId, sizeof(requestId));
+  auto otherKey = deriveSessionHmacKey(aesKey, sizeof(aesKey), requestId, sizeof(requestId) - 1);
+  BOOST_CHECK(key != otherKey);
+
+  Data data("/ndn/CA/CHALLENGE/0102030405060708");
+  data.setContent(ndn::make_span(requestId, sizeof(requestId)));
+  signDataWithHmacSha256(data, key.data(), key.size(), "/ndn/CA/0102030405060708");
+  BOOST_CHECK_EQUAL(data.getSignatureType(), ndn::tlv::SignatureHmacWithSha256);
+  BOOST_CHECK_EQUAL(data.getSignatureValue().value_size(), 32);
+
+  // survives encoding and decoding
+  Data decoded(data.wireEncode());
+  BOOST_CHECK(verifyDataWithHmacSha256(decoded, key.data(), key.size()));
+  BOOST_CHECK(!verifyDataWithHmacSha256(decoded, otherKey.data(), otherKey.size()));
+
+  // tampered content
+  data.setContent(ndn::make_span(aesKey, sizeof(aesKey)));
+  BOOST_CHECK(!verifyDataWithHmacSha256(data, key.data(), key.size()));
+}
+
 BOOST_AUTO_TEST_SUITE_END() // TestCryptoHelpers
 
 } // namespace ndncert::tests
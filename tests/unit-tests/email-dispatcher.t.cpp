@@ -0,0 +1,144 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2024, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+
+#include "challenge/email-dispatcher.hpp"
+
+#include "tests/boost-test.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+namespace ndncert::tests {
+
+BOOST_AUTO_TEST_SUITE(TestEmailDispatcher)
+
+BOOST_AUTO_TEST_CASE(InvalidOptions)
+{
+  auto send = [] (const EmailDispatcher::Message&) { return true; };
+  EmailDispatcher::Options options;
+  options.nWorkers = 0;
+  BOOST_CHECK_THROW(EmailDispatcher(send, options), std::invalid_argument);
+  options.nWorkers = 1;
+  options.queueCapacity = 0;
+  BOOST_CHECK_THROW(EmailDispatcher(send, options), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(Deliver)
+{
+  std::mutex mutex;
+  std::vector<std::string> sent;
+  EmailDispatcher dispatcher([&] (const EmailDispatcher::Message& message) {
+    std::lock_guard<std::mutex> lock(mutex);
+    sent.push_back(message.address + " " + message.secret);
+    return true;
+  });
+
+  BOOST_CHECK(dispatcher.enqueue({"a@example.com", "111111", "/ca", "/ca/a/KEY/1"}));
+  BOOST_CHECK(dispatcher.enqueue({"b@example.com", "222222", "/ca", "/ca/b/KEY/1"}));
+  dispatcher.waitUntilIdle();
+
+  std::sort(sent.begin(), sent.end());
+  std::vector<std::string> expected{"a@example.com 111111", "b@example.com 222222"};
+  BOOST_CHECK_EQUAL_COLLECTIONS(sent.begin(), sent.end(), expected.begin(), expected.end());
+  auto counters = dispatcher.getCounters();
+  BOOST_CHECK_EQUAL(counters.nQueued, 2);
+  BOOST_CHECK_EQUAL(counters.nSent, 2);
+  BOOST_CHECK_EQUAL(counters.nFailed, 0);
+}
+
+BOOST_AUTO_TEST_CASE(CoalesceAndDrop)
+{
+  // the only worker is held by the first message while the others are queued
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool isStarted = false;
+  bool isReleased = false;
+  std::vector<std::string> sent;
+  EmailDispatcher::Options options;
+  options.nWorkers = 1;
+  options.queueCapacity = 2;
+  EmailDispatcher dispatcher([&] (const EmailDispatcher::Message& message) {
+    std::unique_lock<std::mutex> lock(mutex);
+    isStarted = true;
+    cv.notify_all();
+    cv.wait(lock, [&] { return isReleased; });
+    sent.push_back(message.address + " " + message.secret);
+    return true;
+  }, options);
+
+  BOOST_CHECK(dispatcher.enqueue({"a@example.com", "000000", "/ca", "/ca/a/KEY/1"}));
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&] { return isStarted; });
+  }
+
+  BOOST_CHECK(dispatcher.enqueue({"b@example.com", "111111", "/ca", "/ca/b/KEY/1"}));
+  BOOST_CHECK(dispatcher.enqueue({"b@example.com", "222222", "/ca", "/ca/b/KEY/1"}));
+  BOOST_CHECK(dispatcher.enqueue({"c@example.com", "333333", "/ca", "/ca/c/KEY/1"}));
+  BOOST_CHECK(!dispatcher.enqueue({"d@example.com", "444444", "/ca", "/ca/d/KEY/1"}));
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    isReleased = true;
+  }
+  cv.notify_all();
+  dispatcher.waitUntilIdle();
+
+  std::vector<std::string> expected{"a@example.com 000000", "b@example.com 222222",
+                                    "c@example.com 333333"};
+  BOOST_CHECK_EQUAL_COLLECTIONS(sent.begin(), sent.end(), expected.begin(), expected.end());
+  auto counters = dispatcher.getCounters();
+  BOOST_CHECK_EQUAL(counters.nQueued, 3);
+  BOOST_CHECK_EQUAL(counters.nCoalesced, 1);
+  BOOST_CHECK_EQUAL(counters.nDropped, 1);
+  BOOST_CHECK_EQUAL(counters.nSent, 3);
+}
+
+BOOST_AUTO_TEST_CASE(Retry)
+{
+  std::atomic<int> nAttempts{0};
+  EmailDispatcher::Options options;
+  options.maxAttempts = 3;
+  options.initialBackoff = 10_ms;
+  EmailDispatcher dispatcher([&] (const EmailDispatcher::Message& message) {
+    ++nAttempts;
+    if (message.address == "broken@example.com") {
+      NDN_THROW(std::runtime_error("connection refused"));
+    }
+    return nAttempts > 1;
+  }, options);
+
+  BOOST_CHECK(dispatcher.enqueue({"a@example.com", "111111", "/ca", "/ca/a/KEY/1"}));
+  dispatcher.waitUntilIdle();
+  BOOST_CHECK_EQUAL(nAttempts, 2);
+  BOOST_CHECK(dispatcher.enqueue({"broken@example.com", "222222", "/ca", "/ca/b/KEY/1"}));
+  dispatcher.waitUntilIdle();
+  BOOST_CHECK_EQUAL(nAttempts, 5);
+
+  auto counters = dispatcher.getCounters();
+  BOOST_CHECK_EQUAL(counters.nSent, 1);
+  BOOST_CHECK_EQUAL(counters.nRetried, 3);
+  BOOST_CHECK_EQUAL(counters.nFailed, 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END() // TestEmailDispatcher
+
+} // namespace ndncert::tests
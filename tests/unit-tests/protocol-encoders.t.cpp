@@ -51,6 +51,21 @@ BOOST_AUTO_TEST_CASE(InfoEncoding)
   BOOST_CHECK_EQUAL_COLLECTIONS(item.probeParameterKeys.begin(), item.probeParameterKeys.end(),
                                 config.caProfile.probeParameterKeys.begin(), config.caProfile.probeParameterKeys.end());
   BOOST_CHECK_EQUAL(item.maxValidityPeriod, config.caProfile.maxValidityPeriod);
+  BOOST_CHECK(item.ecdhPub.empty());
+  BOOST_CHECK(item.keyAgreements.empty());
+  BOOST_CHECK(item.aeadAlgorithms.empty());
+  BOOST_CHECK(!item.signsErrorsWithDigest);
+
+  config.caProfile.ecdhPub = {4, 1, 2, 3};
+  config.caProfile.keyAgreements = {KeyAgreement::X25519, KeyAgreement::P256};
+  config.caProfile.aeadAlgorithms = {AeadAlgorithm::CHACHA20_POLY1305};
+  config.caProfile.signsErrorsWithDigest = true;
+  item = infotlv::decodeDataContent(infotlv::encodeDataContent(config.caProfile, *cert));
+  BOOST_CHECK_EQUAL_COLLECTIONS(item.ecdhPub.begin(), item.ecdhPub.end(),
+                                config.caProfile.ecdhPub.begin(), config.caProfile.ecdhPub.end());
+  BOOST_CHECK(item.keyAgreements == config.caProfile.keyAgreements);
+  BOOST_CHECK(item.aeadAlgorithms == config.caProfile.aeadAlgorithms);
+  BOOST_CHECK(item.signsErrorsWithDigest);
 }
 
 BOOST_AUTO_TEST_CASE(ErrorEncoding)
@@ -60,6 +75,14 @@ BOOST_AUTO_TEST_CASE(ErrorEncoding)
   auto item = errortlv::decodefromDataContent(b);
   BOOST_CHECK_EQUAL(std::get<0>(item), ErrorCode::NAME_NOT_ALLOWED);
   BOOST_CHECK_EQUAL(std::get<1>(item), msg);
+  BOOST_CHECK(!std::get<2>(item));
+
+  b = errortlv::encodeDataContent(ErrorCode::SERVICE_UNAVAILABLE, msg, 1500_ms);
+  item = errortlv::decodefromDataContent(b);
+  BOOST_CHECK_EQUAL(std::get<0>(item), ErrorCode::SERVICE_UNAVAILABLE);
+  BOOST_CHECK_EQUAL(std::get<1>(item), msg);
+  BOOST_REQUIRE(std::get<2>(item));
+  BOOST_CHECK_EQUAL(*std::get<2>(item), 1500_ms);
 }
 
 BOOST_AUTO_TEST_CASE(ProbeEncodingAppParam)
@@ -109,14 +132,41 @@ BOOST_AUTO_TEST_CASE(NewRevokeEncodingParam)
   auto& certRequest = caCache.getKnownProfiles().front().cert;
   std::vector<uint8_t> pub = ECDHState().getSelfPubKey();
   auto b = requesttlv::encodeApplicationParameters(RequestType::REVOKE, pub, *certRequest);
-  std::vector<uint8_t> returnedPub;
-  std::shared_ptr<Certificate> returnedCert;
+  ndn::span<const uint8_t> returnedPub;
+  std::optional<Certificate> returnedCert;
   requesttlv::decodeApplicationParameters(b, RequestType::REVOKE, returnedPub, returnedCert);
 
-  BOOST_TEST(returnedPub == pub, boost::test_tools::per_element());
+  BOOST_CHECK_EQUAL_COLLECTIONS(returnedPub.begin(), returnedPub.end(), pub.begin(), pub.end());
+  // the decoded values refer to the wire encoding of the parameters
+  BOOST_CHECK(returnedPub.data() >= b.data() && returnedPub.data() < b.data() + b.size());
+  BOOST_CHECK(returnedCert->wireEncode().data() >= b.data() &&
+              returnedCert->wireEncode().data() < b.data() + b.size());
   BOOST_CHECK_EQUAL(*returnedCert, *certRequest);
 }
 
+BOOST_AUTO_TEST_CASE(CompactNewEncodingParam)
+{
+  requester::ProfileStorage caCache;
+  caCache.load("tests/unit-tests/config-files/config-client-1");
+  auto& certRequest = caCache.getKnownProfiles().front().cert;
+  std::vector<uint8_t> pub = ECDHState().getSelfPubKey();
+  auto full = requesttlv::encodeApplicationParameters(RequestType::NEW, pub, *certRequest);
+  auto b = requesttlv::encodeApplicationParameters(RequestType::NEW, pub, *certRequest, Block(), Block(), true);
+  BOOST_CHECK_LT(b.size(), full.size());
+
+  ndn::span<const uint8_t> returnedPub;
+  std::optional<Certificate> returnedCert;
+  requesttlv::decodeApplicationParameters(b, RequestType::NEW, returnedPub, returnedCert);
+  BOOST_CHECK_EQUAL_COLLECTIONS(returnedPub.begin(), returnedPub.end(), pub.begin(), pub.end());
+  BOOST_CHECK_EQUAL(returnedCert->getName(), certRequest->getName());
+  BOOST_CHECK_EQUAL(returnedCert->getContentType(), ndn::tlv::ContentType_Key);
+  BOOST_TEST(returnedCert->getPublicKey() == certRequest->getPublicKey(), boost::test_tools::per_element());
+  BOOST_CHECK(returnedCert->getValidityPeriod() == certRequest->getValidityPeriod());
+
+  BOOST_CHECK_THROW(requesttlv::decodeCompactCertRequest(ndn::makeEmptyBlock(tlv::CompactCertRequest)),
+                    std::runtime_error);
+}
+
 BOOST_AUTO_TEST_CASE(NewRevokeEncodingData)
 {
   std::vector<uint8_t> pub = ECDHState().getSelfPubKey();
@@ -154,6 +204,7 @@ BOOST_FIXTURE_TEST_CASE(ChallengeEncoding, ChallengeEncodingFixture)
   state.status = Status::PENDING;
   state.cert = certRequest;
   std::memcpy(state.encryptionKey.data(), key, sizeof(key));
+  state.aeadKey = deriveAeadKey(state.aead, key, id.data(), id.size());
   state.challengeType = "pin";
   auto tp = time::system_clock::now();
   state.challengeState = ca::ChallengeState("test", tp, 3, time::seconds(3600), JsonSection());
@@ -162,6 +213,8 @@ BOOST_FIXTURE_TEST_CASE(ChallengeEncoding, ChallengeEncodingFixture)
   requester::Request context(m_keyChain, caCache.getKnownProfiles().front(), RequestType::NEW);
   context.m_requestId = id;
   std::memcpy(context.m_aesKey.data(), key, sizeof(key));
+  context.m_aead = AeadAlgorithm::AES_128_GCM;
+  context.m_aeadKey = deriveAeadKey(context.m_aead, key, id.data(), id.size());
   advanceClocks(time::seconds(10));
   challengetlv::decodeDataContent(contentBlock, context);
 
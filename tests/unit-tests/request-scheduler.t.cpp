@@ -0,0 +1,114 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2024, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+#include "detail/request-scheduler.hpp"
+
+#include "tests/boost-test.hpp"
+#include "tests/io-fixture.hpp"
+
+namespace ndncert::tests {
+
+using namespace ca;
+
+BOOST_FIXTURE_TEST_SUITE(TestRequestScheduler, IoFixture)
+
+BOOST_AUTO_TEST_CASE(InvalidOptions)
+{
+  BOOST_CHECK_THROW(RequestScheduler(m_io, {0, {1, 1, 1, 1}}), std::invalid_argument);
+  BOOST_CHECK_THROW(RequestScheduler(m_io, {10, {1, 0, 1, 1}}), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(WeightedOrder)
+{
+  RequestScheduler scheduler(m_io, {16, {2, 1, 1, 1}});
+  std::vector<Name> dispatched;
+  auto handler = [&] (const Interest& interest) { dispatched.push_back(interest.getName()); };
+
+  scheduler.enqueue(RequestClass::INFO, Interest("/ca/INFO/1"), handler);
+  scheduler.enqueue(RequestClass::PROBE, Interest("/ca/PROBE/1"), handler);
+  scheduler.enqueue(RequestClass::NEW, Interest("/ca/NEW/1"), handler);
+  scheduler.enqueue(RequestClass::NEW, Interest("/ca/NEW/2"), handler);
+  scheduler.enqueue(RequestClass::CHALLENGE, Interest("/ca/CHALLENGE/1"), handler);
+  scheduler.enqueue(RequestClass::CHALLENGE, Interest("/ca/CHALLENGE/2"), handler);
+  scheduler.enqueue(RequestClass::CHALLENGE, Interest("/ca/CHALLENGE/3"), handler);
+  BOOST_CHECK_EQUAL(scheduler.size(), 7);
+  BOOST_CHECK(dispatched.empty());
+
+  advanceClocks(1_ms, 10_ms);
+  BOOST_CHECK_EQUAL(scheduler.size(), 0);
+  std::vector<Name> expected{"/ca/CHALLENGE/1", "/ca/CHALLENGE/2", "/ca/NEW/1", "/ca/PROBE/1",
+                             "/ca/INFO/1", "/ca/CHALLENGE/3", "/ca/NEW/2"};
+  BOOST_CHECK_EQUAL_COLLECTIONS(dispatched.begin(), dispatched.end(), expected.begin(), expected.end());
+  BOOST_CHECK_EQUAL(scheduler.getCounters(RequestClass::CHALLENGE).nDispatched, 3);
+  BOOST_CHECK_EQUAL(scheduler.getCounters(RequestClass::INFO).nDispatched, 1);
+}
+
+BOOST_AUTO_TEST_CASE(Shedding)
+{
+  RequestScheduler scheduler(m_io, {2, {1, 1, 1, 1}});
+  std::vector<Name> dispatched;
+  std::vector<Name> shed;
+  auto handler = [&] (const Interest& interest) { dispatched.push_back(interest.getName()); };
+  scheduler.setShedCallback([&] (const Interest& interest, RequestClass) {
+    shed.push_back(interest.getName());
+  });
+
+  BOOST_CHECK(scheduler.enqueue(RequestClass::INFO, Interest("/ca/INFO/1"), handler));
+  BOOST_CHECK(scheduler.enqueue(RequestClass::INFO, Interest("/ca/INFO/2"), handler));
+  // full: the oldest INFO gives way to a CHALLENGE
+  BOOST_CHECK(scheduler.enqueue(RequestClass::CHALLENGE, Interest("/ca/CHALLENGE/1"), handler));
+  // full: the remaining INFO gives way to a PROBE
+  BOOST_CHECK(scheduler.enqueue(RequestClass::PROBE, Interest("/ca/PROBE/1"), handler));
+  // full: nothing below INFO, the incoming Interest is shed
+  BOOST_CHECK(!scheduler.enqueue(RequestClass::INFO, Interest("/ca/INFO/3"), handler));
+  // full: PROBE is not below PROBE, the incoming Interest is shed
+  BOOST_CHECK(!scheduler.enqueue(RequestClass::PROBE, Interest("/ca/PROBE/2"), handler));
+
+  std::vector<Name> expectedShed{"/ca/INFO/1", "/ca/INFO/2", "/ca/INFO/3", "/ca/PROBE/2"};
+  BOOST_CHECK_EQUAL_COLLECTIONS(shed.begin(), shed.end(), expectedShed.begin(), expectedShed.end());
+  BOOST_CHECK_EQUAL(scheduler.getCounters(RequestClass::INFO).nShed, 3);
+  BOOST_CHECK_EQUAL(scheduler.getCounters(RequestClass::PROBE).nShed, 1);
+
+  advanceClocks(1_ms, 10_ms);
+  std::vector<Name> expected{"/ca/CHALLENGE/1", "/ca/PROBE/1"};
+  BOOST_CHECK_EQUAL_COLLECTIONS(dispatched.begin(), dispatched.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(ExpiredInterest)
+{
+  RequestScheduler scheduler(m_io);
+  int nDispatched = 0;
+  auto handler = [&] (const Interest&) { ++nDispatched; };
+
+  Interest interest("/ca/PROBE/1");
+  interest.setInterestLifetime(100_ms);
+  scheduler.enqueue(RequestClass::PROBE, interest, handler);
+  advanceClocks(200_ms);
+  BOOST_CHECK_EQUAL(nDispatched, 0);
+  BOOST_CHECK_EQUAL(scheduler.getCounters(RequestClass::PROBE).nExpired, 1);
+
+  scheduler.enqueue(RequestClass::PROBE, interest, handler);
+  advanceClocks(10_ms);
+  BOOST_CHECK_EQUAL(nDispatched, 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END() // TestRequestScheduler
+
+} // namespace ndncert::tests
@@ -128,6 +128,44 @@ BOOST_AUTO_TEST_CASE(ErrorHandling)
   BOOST_CHECK_THROW(Request::onProbeResponse(errorPacket, item, ids, cas), std::runtime_error);
   BOOST_CHECK_THROW(state.onNewRenewRevokeResponse(errorPacket), std::runtime_error);
   BOOST_CHECK_THROW(state.onChallengeResponse(errorPacket), std::runtime_error);
+
+  Data busyPacket;
+  busyPacket.setName(Name("/site/pretend/this/is/busy/packet"));
+  busyPacket.setFreshnessPeriod(time::seconds(100));
+  busyPacket.setContent(errortlv::encodeDataContent(ErrorCode::SERVICE_UNAVAILABLE, "Busy.", 3_s));
+  m_keyChain.sign(busyPacket, ndn::signingByIdentity(identity));
+
+  try {
+    state.onNewRenewRevokeResponse(busyPacket);
+    BOOST_ERROR("RetryAfterError expected");
+  }
+  catch (const RetryAfterError& e) {
+    BOOST_CHECK_EQUAL(e.getRetryAfter(), 3_s);
+  }
+
+  // overload replies are accepted with a digest, other errors are not
+  m_keyChain.sign(busyPacket, ndn::signingWithSha256());
+  BOOST_CHECK_THROW(state.onNewRenewRevokeResponse(busyPacket), RetryAfterError);
+  m_keyChain.sign(errorPacket, ndn::signingWithSha256());
+  BOOST_CHECK_EXCEPTION(state.onNewRenewRevokeResponse(errorPacket), std::runtime_error,
+                        [] (const auto& e) {
+                          return std::string(e.what()).find("signature") != std::string::npos;
+                        });
+}
+
+BOOST_AUTO_TEST_CASE(RetryDelay)
+{
+  for (size_t attempt = 0; attempt < 10; attempt++) {
+    auto delay = Request::getRetryDelay(attempt, 2_s);
+    BOOST_CHECK_GE(delay, 2_s);
+    BOOST_CHECK_LE(delay, 2_s + 60_s);
+  }
+  BOOST_CHECK_LE(Request::getRetryDelay(0), 500_ms);
+  BOOST_CHECK_LE(Request::getRetryDelay(2), 2_s);
+
+  // the CA's hint is bounded
+  BOOST_CHECK_LE(Request::getRetryDelay(0, time::days(1)), 60_s + 500_ms);
+  BOOST_CHECK_GE(Request::getRetryDelay(0, time::milliseconds(-1)), 0_ms);
 }
 
 BOOST_AUTO_TEST_SUITE_END() // TestRequester
@@ -0,0 +1,81 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2024, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+
+#include "detail/resumption-ticket.hpp"
+
+#include "tests/boost-test.hpp"
+#include "tests/io-fixture.hpp"
+
+namespace ndncert::tests {
+
+using namespace ca;
+
+BOOST_FIXTURE_TEST_SUITE(TestResumptionTicket, IoFixture)
+
+BOOST_AUTO_TEST_CASE(SealOpen)
+{
+  ResumptionTicketKeys keys(time::hours(1));
+  std::array<uint8_t, 32> secret;
+  secret.fill(0x42);
+  auto ticket = keys.seal("/ndn/alice/KEY/1", secret);
+  BOOST_CHECK_EQUAL(ticket.type(), tlv::ResumptionTicket);
+
+  auto opened = keys.open(ticket, "/ndn/alice/KEY/1");
+  BOOST_REQUIRE(opened);
+  BOOST_CHECK_EQUAL_COLLECTIONS(opened->begin(), opened->end(), secret.begin(), secret.end());
+
+  // bound to the key name
+  BOOST_CHECK(!keys.open(ticket, "/ndn/bob/KEY/1"));
+  // sealed by another CA
+  ResumptionTicketKeys otherKeys(time::hours(1));
+  BOOST_CHECK(!otherKeys.open(ticket, "/ndn/alice/KEY/1"));
+  // tampered with
+  auto buffer = std::make_shared<ndn::Buffer>(ticket.begin(), ticket.end());
+  buffer->back() ^= 0x01;
+  BOOST_CHECK(!keys.open(Block(buffer), "/ndn/alice/KEY/1"));
+
+  BOOST_CHECK_THROW(ResumptionTicketKeys(0_s), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(Rotation)
+{
+  ResumptionTicketKeys keys(time::hours(1));
+  std::array<uint8_t, 32> secret{};
+  auto ticket1 = keys.seal("/ndn/alice/KEY/1", secret);
+
+  // sealed with the previous key, not expired yet
+  advanceClocks(time::minutes(40));
+  auto ticket2 = keys.seal("/ndn/alice/KEY/1", secret);
+  advanceClocks(time::minutes(30));
+  BOOST_CHECK(!keys.open(ticket1, "/ndn/alice/KEY/1"));
+  BOOST_CHECK(keys.open(ticket2, "/ndn/alice/KEY/1"));
+  auto ticket3 = keys.seal("/ndn/alice/KEY/1", secret);
+
+  // the key of ticket2 is discarded at the second rotation
+  advanceClocks(time::minutes(61));
+  BOOST_CHECK(!keys.open(ticket2, "/ndn/alice/KEY/1"));
+  BOOST_CHECK(!keys.open(ticket3, "/ndn/alice/KEY/1"));
+  BOOST_CHECK(keys.open(keys.seal("/ndn/alice/KEY/1", secret), "/ndn/alice/KEY/1"));
+}
+
+BOOST_AUTO_TEST_SUITE_END() // TestResumptionTicket
+
+} // namespace ndncert::tests
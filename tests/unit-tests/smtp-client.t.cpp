@@ -0,0 +1,259 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017-2024, Regents of the University of California.
+ *
+ * This file is part of ndncert, a certificate management system based on NDN.
+ *
+ * ndncert is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * ndncert is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License along with
+ * ndncert, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of ndncert authors and contributors.
+ */
+
+
+#include "challenge/smtp-client.hpp"
+
+#include "tests/boost-test.hpp"
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/streambuf.hpp>
+#include <boost/asio/write.hpp>
+
+#include <thread>
+
+namespace ndncert::tests {
+
+namespace asio = boost::asio;
+using asio::ip::tcp;
+
+/**
+ * @brief Minimal SMTP server accepting every message, serving one connection at a time.
+ */
+class FakeSmtpServer
+{
+public:
+  FakeSmtpServer()
+    : m_acceptor(m_io, tcp::endpoint(asio::ip::address_v4::loopback(), 0))
+    , m_thread([this] { run(); })
+  {
+  }
+
+  ~FakeSmtpServer()
+  {
+    m_shouldStop = true;
+    // unblock accept()
+    tcp::socket socket(m_io);
+    boost::system::error_code ec;
+    socket.connect(m_acceptor.local_endpoint(), ec);
+    m_thread.join();
+  }
+
+  std::string
+  getPort() const
+  {
+    return std::to_string(m_acceptor.local_endpoint().port());
+  }
+
+  size_t
+  getConnectionCount()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_nConnections;
+  }
+
+  std::vector<std::string>
+  getMessages()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_messages;
+  }
+
+private:
+  void
+  run()
+  {
+    while (!m_shouldStop) {
+      tcp::socket socket(m_io);
+      boost::system::error_code ec;
+      m_acceptor.accept(socket, ec);
+      if (ec || m_shouldStop) {
+        return;
+      }
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_nConnections;
+      }
+      serve(socket, ec);
+    }
+  }
+
+  void
+  serve(tcp::socket& socket, boost::system::error_code& ec)
+  {
+    asio::streambuf buffer;
+    auto reply = [&] (const std::string& text) { asio::write(socket, asio::buffer(text), ec); };
+    auto readLine = [&] {
+      asio::read_until(socket, buffer, "\r\n", ec);
+      std::istream is(&buffer);
+      std::string line;
+      std::getline(is, line);
+      if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+      }
+      return line;
+    };
+
+    reply("220 fake.example.com ESMTP\r\n");
+    std::string envelope;
+    while (!ec) {
+      auto command = readLine();
+      if (ec) {
+        return;
+      }
+      if (boost::starts_with(command, "EHLO")) {
+        reply("250-fake.example.com\r\n250-PIPELINING\r\n250 8BITMIME\r\n");
+      }
+      else if (boost::starts_with(command, "MAIL FROM:") || boost::starts_with(command, "RCPT TO:")) {
+        envelope += command + "\n";
+        reply("250 OK\r\n");
+      }
+      else if (command == "DATA") {
+        reply("354 Go ahead\r\n");
+        std::string data;
+        for (auto line = readLine(); !ec && line != "."; line = readLine()) {
+          data += line + "\n";
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_messages.push_back(envelope + data);
+        envelope.clear();
+        reply("250 Queued\r\n");
+      }
+      else if (command == "QUIT") {
+        reply("221 Bye\r\n");
+        return;
+      }
+      else {
+        reply("502 Not implemented\r\n");
+      }
+    }
+  }
+
+private:
+  asio::io_context m_io;
+  tcp::acceptor m_acceptor;
+  std::mutex m_mutex;
+  size_t m_nConnections = 0;
+  std::vector<std::string> m_messages;
+  std::atomic<bool> m_shouldStop{false};
+  std::thread m_thread;
+};
+
+class SmtpClientFixture
+{
+protected:
+  SmtpClient::Options
+  makeOptions() const
+  {
+    SmtpClient::Options options;
+    options.server = "127.0.0.1";
+    options.port = server.getPort();
+    options.mailFrom = "NDNCERT Robot <noreply@example.com>";
+    options.subject = "Email Challenge";
+    options.textTemplate = "Your PIN code: {0} from {1}.\n.Certificate Name: {2}.";
+    options.timeout = 2_s;
+    return options;
+  }
+
+protected:
+  FakeSmtpServer server;
+};
+
+BOOST_FIXTURE_TEST_SUITE(TestSmtpClient, SmtpClientFixture)
+
+BOOST_AUTO_TEST_CASE(LoadOptions)
+{
+  auto options = SmtpClient::loadOptions("tests/unit-tests/config-files/config-mail-1");
+  BOOST_CHECK_EQUAL(options.server, "smtp.example.com");
+  BOOST_CHECK_EQUAL(options.port, "587");
+  BOOST_CHECK(options.security == SmtpClient::Security::STARTTLS);
+  BOOST_CHECK_EQUAL(options.username, "robot");
+  BOOST_CHECK_EQUAL(options.password, "secret");
+  BOOST_CHECK_EQUAL(options.maxConnections, 2);
+  BOOST_CHECK_EQUAL(options.mailFrom, "NDNCERT Robot <noreply@example.com>");
+  BOOST_CHECK(options.htmlTemplate.empty());
+
+  BOOST_CHECK_THROW(SmtpClient::loadOptions("tests/unit-tests/config-files/nonexistent"),
+                    std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(PooledConnection)
+{
+  {
+    SmtpClient client(makeOptions());
+    for (int i = 0; i < 3; ++i) {
+      client.send({"user" + std::to_string(i) + "@example.com", "12345" + std::to_string(i),
+                   "/ndn/site1", "/ndn/site1/user/KEY/1"});
+    }
+    BOOST_CHECK_EQUAL(client.getConnectionCount(), 1);
+  }
+  BOOST_CHECK_EQUAL(server.getConnectionCount(), 1);
+
+  auto messages = server.getMessages();
+  BOOST_REQUIRE_EQUAL(messages.size(), 3);
+  const auto& message = messages[2];
+  BOOST_CHECK(message.find("MAIL FROM:<noreply@example.com>\n") != std::string::npos);
+  BOOST_CHECK(message.find("RCPT TO:<user2@example.com>\n") != std::string::npos);
+  BOOST_CHECK(message.find("To: user2@example.com\n") != std::string::npos);
+  BOOST_CHECK(message.find("Your PIN code: 123452 from /ndn/site1.\n") != std::string::npos);
+  // the line starting with a dot has been stuffed
+  BOOST_CHECK(message.find("\n..Certificate Name: /ndn/site1/user/KEY/1.\n") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(MaxMessagesPerConnection)
+{
+  auto options = makeOptions();
+  options.maxMessagesPerConnection = 2;
+  {
+    SmtpClient client(options);
+    for (int i = 0; i < 3; ++i) {
+      client.send({"user@example.com", "123456", "/ndn/site1", "/ndn/site1/user/KEY/1"});
+    }
+  }
+  BOOST_CHECK_EQUAL(server.getConnectionCount(), 2);
+  BOOST_CHECK_EQUAL(server.getMessages().size(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(UnsafeAddress)
+{
+  SmtpClient client(makeOptions());
+  BOOST_CHECK_THROW(client.send({"user@example.com>\r\nRCPT TO:<other@example.com", "123456",
+                                 "/ndn/site1", "/ndn/site1/user/KEY/1"}),
+                    SmtpClient::Error);
+  BOOST_CHECK_EQUAL(client.getConnectionCount(), 0);
+  BOOST_CHECK(server.getMessages().empty());
+}
+
+BOOST_AUTO_TEST_CASE(ConnectionRefused)
+{
+  auto options = makeOptions();
+  // nothing listens on the discard port of the loopback interface
+  options.port = "9";
+  SmtpClient client(options);
+  BOOST_CHECK_THROW(client.send({"user@example.com", "123456", "/ndn/site1", "/ndn/site1/user/KEY/1"}),
+                    SmtpClient::Error);
+  BOOST_CHECK_EQUAL(client.getConnectionCount(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END() // TestSmtpClient
+
+} // namespace ndncert::tests
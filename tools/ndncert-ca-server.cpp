@@ -28,6 +28,7 @@
 
 #include <chrono>
 #include <deque>
+#include <functional>
 #include <iostream>
 
 #include <ndn-cxx/face.hpp>
@@ -76,6 +77,19 @@ handleSignal(const boost::system::error_code& error, int signalNum)
   exit(1);
 }
 
+static void
+printProbeCacheStats(const CaModule& ca)
+{
+  const auto& stats = ca.getProbeCacheStats();
+  auto nLookups = stats.nHits + stats.nMisses;
+  std::cerr << "PROBE response cache: " << stats.nHits << " hits / " << nLookups << " lookups";
+  if (nLookups > 0) {
+    std::cerr << " (" << stats.nHits * 100 / nLookups << "%)";
+  }
+  std::cerr << ", saved signing time "
+            << time::duration_cast<time::microseconds>(stats.savedSigningTime).count() << " us" << std::endl;
+}
+
 static int
 main(int argc, char* argv[])
 {
@@ -123,19 +137,48 @@ main(int argc, char* argv[])
 
   CaModule ca(face, keyChain, configFilePath);
   std::deque<Data> cachedCertificates;
-  auto profileData = ca.getCaProfileData();
+  auto profileSegments = ca.getCaProfileSegments();
+
+  boost::asio::signal_set reloadSignals(face.getIoContext());
+  reloadSignals.add(SIGHUP);
+  std::function<void(const boost::system::error_code&, int)> handleReload =
+    [&] (const boost::system::error_code& error, int) {
+      if (error) {
+        return;
+      }
+      printProbeCacheStats(ca);
+      try {
+        ca.reload();
+        profileSegments = ca.getCaProfileSegments();
+        if (wantRepoOut) {
+          for (const auto& segment : profileSegments) {
+            writeDataToRepo(segment);
+          }
+        }
+        std::cerr << "Configuration reloaded from " << configFilePath << std::endl;
+      }
+      catch (const std::exception& e) {
+        std::cerr << "ERROR: Cannot reload configuration: " << e.what() << std::endl;
+      }
+      reloadSignals.async_wait(handleReload);
+    };
+  reloadSignals.async_wait(handleReload);
 
   if (wantRepoOut) {
-    writeDataToRepo(profileData);
+    for (const auto& segment : profileSegments) {
+      writeDataToRepo(segment);
+    }
     ca.setStatusUpdateCallback([&](const RequestState& request) {
-      if (request.status == Status::SUCCESS && request.requestType == RequestType::NEW) {
+      if (request.status == Status::SUCCESS &&
+          (request.requestType == RequestType::NEW || request.requestType == RequestType::RENEW)) {
         writeDataToRepo(request.cert);
       }
     });
   }
   else {
     ca.setStatusUpdateCallback([&](const RequestState& request) {
-      if (request.status == Status::SUCCESS && request.requestType == RequestType::NEW) {
+      if (request.status == Status::SUCCESS &&
+          (request.requestType == RequestType::NEW || request.requestType == RequestType::RENEW)) {
         cachedCertificates.push_front(request.cert);
         if (cachedCertificates.size() > MAX_CACHED_CERT_NUM) {
           cachedCertificates.pop_back();
@@ -146,9 +189,11 @@ main(int argc, char* argv[])
         ndn::InterestFilter(ca.getCaConf().caProfile.caPrefix),
         [&](const auto&, const auto& interest) {
           const auto& interestName = interest.getName();
-          if (interestName.isPrefixOf(profileData.getName())) {
-            face.put(profileData);
-            return;
+          for (const auto& segment : profileSegments) {
+            if (interestName.isPrefixOf(segment.getName())) {
+              face.put(segment);
+              return;
+            }
           }
           for (const auto& item : cachedCertificates) {
             if (interestName.isPrefixOf(item.getFullName())) {
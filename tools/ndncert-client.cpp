@@ -23,6 +23,7 @@
 #include <ndn-cxx/face.hpp>
 #include <ndn-cxx/security/key-chain.hpp>
 #include <ndn-cxx/security/verification-helpers.hpp>
+#include <ndn-cxx/util/scheduler.hpp>
 
 #include <boost/algorithm/string/case_conv.hpp>
 #include <boost/asio/signal_set.hpp>
@@ -48,13 +49,16 @@ runChallenge(const std::string& challengeType);
 
 static size_t nStep = 1;
 static const std::string defaultChallenge = "email";
+static const size_t maxRetries = 5;
 static ndn::Face face;
+static ndn::Scheduler scheduler(face.getIoContext());
 static ndn::KeyChain keyChain;
 static std::shared_ptr<Request> requesterState;
 static std::shared_ptr<std::multimap<std::string, std::string>> capturedProbeParams;
 static std::shared_ptr<Certificate> trustedCert;
 static Name newlyCreatedIdentityName;
 static Name newlyCreatedKeyName;
+static AeadAlgorithm preferredAead = AeadAlgorithm::AES_128_GCM;
 
 static void
 captureParams(std::multimap<std::string, std::string>& requirement)
@@ -176,30 +180,83 @@ timeoutCb()
 }
 
 static void
-certFetchCb(const Data& reply)
+sendRequest(const Interest& interest, const std::function<void(const Data&)>& onData, size_t nRetries = 0);
+
+static void
+retryRequest(Interest interest, const std::function<void(const Data&)>& onData, size_t nRetries,
+             time::milliseconds retryAfter)
 {
-  auto item = Request::onCertFetchResponse(reply);
-  if (item) {
-    keyChain.addCertificate(keyChain.getPib().getIdentity(item->getIdentity()).getKey(item->getKeyName()), *item);
+  if (nRetries >= maxRetries) {
+    std::cerr << "No response from the CA after " << nRetries << " retries. Exit" << std::endl;
+    exit(1);
   }
+  // back off with jitter, so that requesters turned away together do not come back together
+  auto delay = Request::getRetryDelay(nRetries, retryAfter);
+  std::cerr << "Retrying in " << delay << std::endl;
+  scheduler.schedule(delay, [=] () mutable {
+    interest.refreshNonce();
+    sendRequest(interest, onData, nRetries + 1);
+  });
+}
+
+static void
+sendRequest(const Interest& interest, const std::function<void(const Data&)>& onData, size_t nRetries)
+{
+  face.expressInterest(interest,
+                       [=] (const auto&, const auto& data) {
+                         try {
+                           onData(data);
+                         }
+                         catch (const RetryAfterError& e) {
+                           std::cerr << "The CA asked to retry later: " << e.what() << std::endl;
+                           retryRequest(interest, onData, nRetries, e.getRetryAfter());
+                         }
+                       },
+                       [] (auto&&...) { onNackCb(); },
+                       [=] (auto&&...) {
+                         timeoutCb();
+                         retryRequest(interest, onData, nRetries, 0_ms);
+                       });
+}
+
+static void
+installCert(const Certificate& cert)
+{
+  keyChain.addCertificate(keyChain.getPib().getIdentity(cert.getIdentity()).getKey(cert.getKeyName()), cert);
   std::cerr << "\n***************************************\n"
             << "Step " << nStep++
-            << ": DONE\nCertificate with Name: " << reply.getName()
+            << ": DONE\nCertificate with Name: " << cert.getName()
             << " has been installed to your local keychain\n"
             << "Exit now" << std::endl;
   face.getIoContext().stop();
 }
 
+static void
+certFetchCb(const Data& reply)
+{
+  auto item = Request::onCertFetchResponse(reply);
+  if (item) {
+    installCert(*item);
+  }
+}
+
 static void
 challengeCb(const Data& reply)
 {
   try {
     requesterState->onChallengeResponse(reply);
   }
+  catch (const RetryAfterError&) {
+    throw;
+  }
   catch (const std::exception& e) {
     std::cerr << "Error when decoding challenge step: " << e.what() << std::endl;
     exit(1);
   }
+  if (requesterState->m_status == Status::SUCCESS && requesterState->m_issuedCert != nullptr) {
+    installCert(*requesterState->m_issuedCert);
+    return;
+  }
   if (requesterState->m_status == Status::SUCCESS) {
     std::cerr << "Certificate has already been issued, downloading certificate..." << std::endl;
     face.expressInterest(*requesterState->genCertFetchInterest(),
@@ -218,6 +275,9 @@ newCb(const Data& reply)
   try {
     challengeList = requesterState->onNewRenewRevokeResponse(reply);
   }
+  catch (const RetryAfterError&) {
+    throw;
+  }
   catch (const std::exception& e) {
     std::cerr << "Error on decoding NEW step reply because: " << e.what() << std::endl;
     exit(1);
@@ -276,18 +336,21 @@ newCb(const Data& reply)
 }
 
 static void
-infoCb(const Data& reply, const Name& certFullName)
+infoCb(const std::vector<Data>& segments, const Name& certFullName)
 {
+  const auto& reply = segments.front();
   std::optional<CaProfile> profile;
   try {
     if (certFullName.empty()) {
-      if (trustedCert && !ndn::security::verifySignature(reply, *trustedCert)) {
-        NDN_THROW(std::runtime_error("Cannot verify replied Data packet signature."));
+      for (const auto& segment : segments) {
+        if (trustedCert && !ndn::security::verifySignature(segment, *trustedCert)) {
+          NDN_THROW(std::runtime_error("Cannot verify replied Data packet signature."));
+        }
       }
-      profile = Request::onCaProfileResponse(reply);
+      profile = Request::onCaProfileResponse(segments);
     }
     else {
-      profile = Request::onCaProfileResponseAfterRedirection(reply, certFullName);
+      profile = Request::onCaProfileResponseAfterRedirection(segments, certFullName);
     }
   }
   catch (const std::exception& e) {
@@ -322,6 +385,25 @@ infoCb(const Data& reply, const Name& certFullName)
   }
 }
 
+static void
+fetchCaProfile(const Interest& interest, const Name& certFullName,
+               std::shared_ptr<std::vector<Data>> segments = std::make_shared<std::vector<Data>>())
+{
+  face.expressInterest(interest,
+    [=] (const auto&, const auto& data) {
+      segments->push_back(data);
+      auto nextInterest = Request::genCaProfileSegmentInterest(data);
+      if (nextInterest == nullptr) {
+        infoCb(*segments, certFullName);
+      }
+      else {
+        fetchCaProfile(*nextInterest, certFullName, segments);
+      }
+    },
+    [] (auto&&...) { onNackCb(); },
+    [] (auto&&...) { timeoutCb(); });
+}
+
 static void
 probeCb(const Data& reply, CaProfile profile)
 {
@@ -330,6 +412,9 @@ probeCb(const Data& reply, CaProfile profile)
   try {
     Request::onProbeResponse(reply, profile, names, redirects);
   }
+  catch (const RetryAfterError&) {
+    throw;
+  }
   catch (const std::exception& e) {
     std::cerr << "The probed CA response cannot be used because: " << e.what() << std::endl;
     exit(1);
@@ -375,10 +460,7 @@ probeCb(const Data& reply, CaProfile profile)
         *Request::genCaProfileDiscoveryInterest(redirectedCaName),
         [&, redirectedCaFullName] (const auto&, const auto& data) {
           auto fetchingInterest = Request::genCaProfileInterestFromDiscoveryResponse(data);
-          face.expressInterest(*fetchingInterest,
-                              [=] (const auto&, const auto& data2) { infoCb(data2, redirectedCaFullName); },
-                              [] (auto&&...) { onNackCb(); },
-                              [] (auto&&...) { timeoutCb(); });
+          fetchCaProfile(*fetchingInterest, redirectedCaFullName);
         },
         [] (auto&&...) { onNackCb(); },
         [] (auto&&...) { timeoutCb(); });
@@ -484,10 +566,7 @@ selectCaProfile(const std::string& configFilePath)
     *Request::genCaProfileDiscoveryInterest(selectedCaName),
     [&] (const auto&, const auto& data) {
       auto fetchingInterest = Request::genCaProfileInterestFromDiscoveryResponse(data);
-      face.expressInterest(*fetchingInterest,
-                            [] (const auto&, const auto& data2) { infoCb(data2, {}); },
-                            [] (auto&&...) { onNackCb(); },
-                            [] (auto&&...) { timeoutCb(); });
+      fetchCaProfile(*fetchingInterest, {});
     },
     [] (auto&&...) { onNackCb(); },
     [] (auto&&...) { timeoutCb(); });
@@ -506,10 +585,8 @@ runProbe(CaProfile profile)
     }
     capturedProbeParams = std::make_shared<std::multimap<std::string, std::string>>(captured);
   }
-  face.expressInterest(*Request::genProbeInterest(profile, std::move(*capturedProbeParams)),
-                        [profile] (const auto&, const auto& data) { probeCb(data, profile); },
-                        [] (auto&&...) { onNackCb(); },
-                        [] (auto&&...) { timeoutCb(); });
+  sendRequest(*Request::genProbeInterest(profile, std::move(*capturedProbeParams)),
+              [profile] (const auto& data) { probeCb(data, profile); });
 }
 
 static void
@@ -518,7 +595,7 @@ runNew(CaProfile profile, Name identityName)
   int validityPeriod = captureValidityPeriod(time::duration_cast<time::hours>(profile.maxValidityPeriod));
   auto now = time::system_clock::now();
   std::cerr << "The validity period of your certificate will be: " << validityPeriod << " hours" << std::endl;
-  requesterState = std::make_shared<Request>(keyChain, profile, RequestType::NEW);
+  requesterState = std::make_shared<Request>(keyChain, profile, RequestType::NEW, preferredAead);
 
   // generate a newly key pair or choose an existing key
   const auto& pib = keyChain.getPib();
@@ -548,10 +625,7 @@ runNew(CaProfile profile, Name identityName)
   }
   auto interest = requesterState->genNewInterest(keyName, now, now + time::hours(validityPeriod));
   if (interest != nullptr) {
-    face.expressInterest(*interest,
-                         [] (const auto&, const auto& data) { newCb(data); },
-                         [] (auto&&...) { onNackCb(); },
-                         [] (auto&&...) { timeoutCb(); });
+    sendRequest(*interest, [] (const auto& data) { newCb(data); });
   }
   else {
     std::cerr << "Cannot generate the Interest for NEW step. Exit" << std::endl;
@@ -581,10 +655,8 @@ runChallenge(const std::string& challengeType)
       captureParams(requirement);
     }
   }
-  face.expressInterest(*requesterState->genChallengeInterest(std::move(requirement)),
-                       [] (const auto&, const auto& data) { challengeCb(data); },
-                       [] (auto&&...) { onNackCb(); },
-                       [] (auto&&...) { timeoutCb(); });
+  sendRequest(*requesterState->genChallengeInterest(std::move(requirement)),
+              [] (const auto& data) { challengeCb(data); });
 }
 
 static void
@@ -626,10 +698,11 @@ main(int argc, char* argv[])
 
   namespace po = boost::program_options;
   std::string configFilePath = std::string(NDNCERT_SYSCONFDIR) + "/ndncert/client.conf";
-  po::options_description description("Usage: ndncert-client [-h] [-c FILE]\n");
+  po::options_description description("Usage: ndncert-client [-h] [-c FILE] [--chacha20]\n");
   description.add_options()
     ("help,h", "produce help message")
     ("config-file,c", po::value<std::string>(&configFilePath), "configuration file name")
+    ("chacha20", "prefer ChaCha20-Poly1305 to AES-128-GCM, e.g., on devices without AES hardware")
     ;
   po::positional_options_description p;
 
@@ -647,6 +720,9 @@ main(int argc, char* argv[])
     std::cerr << description << std::endl;
     return 0;
   }
+  if (vm.count("chacha20") != 0) {
+    preferredAead = AeadAlgorithm::CHACHA20_POLY1305;
+  }
 
   selectCaProfile(configFilePath);
   face.processEvents();